@@ -1,7 +1,9 @@
 #ifndef BRAIN_CONFIG_H
 #define BRAIN_CONFIG_H
 
+#ifdef ARDUINO
 #include <Arduino.h>
+#endif
 #include "../common/common_config.h"
 
 
@@ -15,12 +17,96 @@
 // LCD硬件支持配置
 // 设置为 1 启用LCD显示，设置为 0 禁用LCD（适用于没有LCD硬件的brain）
 #define HAS_LCD 0  // 1=有LCD硬件, 0=无LCD硬件
+#define LCD_I2C_CLOCK_HZ 400000   // LCD的I2C时钟（PCF8574支持400kHz）
+#define LCD_FLUSH_CHARS 4          // 每轮主循环最多发送到LCD的字符数（光标定位算一个）
 
 // G-code处理器配置
 #define MAX_GCODE_LINE_LENGTH 64
+#define GCODE_LINE_QUEUE_DEPTH 8  // 已收到、等待主循环处理的G-code行数（串口和TCP共用）
+#define GCODE_REPLY_BUFFER_SIZE 96 // 回复缓冲区，超长回复（如M620）分段发送
+#define GCODE_DETAILS_BUFFER_SIZE 6144 // M620在线Hand详情的缓冲区（约40台），不超过TCP发送缓冲区与TCP_PENDING_BUFFER_SIZE之和
 #define GCODE_BUFFER_SIZE 128
 #define MAX_UNASSIGNED_HANDS 10   // 最多跟踪10个未分配设备
 #define UNASSIGNED_HAND_TIMEOUT_MS 30000  // 未分配设备超时时间（30秒）
+
+// TCP G-code服务器配置
+#define TCP_GCODE_PORT 8080
+#define TCP_PENDING_BUFFER_SIZE 2048 // 发送缓冲区满时暂存的回复字节数，对端确认后继续发送
+
+// 命令调度配置
+#define FEEDER_QUEUE_DEPTH 4      // 每个Feeder最多排队的命令数，超出时回复busy
+#define MAX_PENDING_COMMANDS TOTAL_FEEDERS  // 等待响应的命令数（每个Feeder最多一条在途）
+#define FEED_COALESCE_ENABLED 1   // Feeder忙碌时排队的送料命令合并为一次更长的送料
+#define FEED_COALESCE_MAX_MM 24   // 合并后的最大送料长度（与M600的F上限相同）
+
+// 命令超时配置（link_estimator.h）：Hand确认命令后按该Feeder的送料耗时模型等待响应，
+// 未确认时按该Hand的往返时间重发，重发UDP_MAX_RETRY_COUNT次仍未确认则停止重发，等到送料耗时预算用完再判定失败
+#define UDP_RTO_INITIAL_MS 200    // 还没有往返时间样本时的重发间隔
+#define UDP_RTO_MIN_MS 110        // 重发间隔下限：ESP8266的WiFi休眠未关闭或AP缓存帧时，确认可能推迟到下一个信标(102.4ms)
+#define UDP_RTO_MAX_MS 500        // 重发间隔上限
+#define ACTUATION_DEFAULT_US_PER_MM 250000  // 还没有样本时每mm的送料耗时：未实测的保守默认值（24mm约6s），收到响应后按实际耗时修正
+#define ACTUATION_MIN_MARGIN_MS 300         // 预计送料耗时之外至少多等的时间
+
+// Feeder状态查询配置（M621）：直接回复Brain缓存的状态，过旧时在后台向空闲的Feeder发探测
+#define FEEDER_STATE_MAX_AGE_MS 10000         // 超过该时间没有收到Feeder的包时请求探测（略大于Hand心跳间隔）
+#define FEEDER_STATE_PROBE_INTERVAL_MS 1000   // 同一Feeder两次探测的最小间隔
+
+// 命令通道传输配置（common/transport.h）：开启后Brain同时在ESP-NOW上收发，
+// 每个Hand的命令走它最近一次发来主通道包的链路（UDP或ESP-NOW），两种Hand可以混用
+#ifndef BRAIN_ESPNOW_ENABLED
+#define BRAIN_ESPNOW_ENABLED 0
+#endif
+
+// 送料链路追踪配置（/api/trace导出Chrome trace JSON）
+#define FEED_TRACE_DEPTH 128      // 环形缓冲区可保存的区间数量
+#define FEED_TRACE_LINES_PER_COMMAND 4 // 一条合并的送料命令最多包含的G-code行数，每行都记录接收/解析区间
+
+// 通信录制配置（/api/record开关和下载，用Firmware/tools/traffic_replay.py回放）
+#define TRAFFIC_RECORD_BYTES 16384  // 录制缓冲区字节数，写满后覆盖最旧记录
+#define TRAFFIC_RECORD_DEFAULT false // 上电时是否开始录制
+// 主循环耗时统计配置（/api/loop）
+#define LOOP_STALL_US 20000       // 单轮循环超过该耗时时记录耗时最多的阶段
+
+// 延迟日志配置（brain_log.h）：热路径只写RAM记录，主循环空闲时输出到串口或/api/log
+#define LOG_RING_DEPTH 64         // 可缓存的日志条数，满时丢弃新记录
+#define LOG_LINE_LENGTH 128       // 输出时单条日志的最大长度
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+// 各模块的日志级别，低于该级别的日志在编译期去掉
+#define MAIN_LOG_LEVEL  LOG_LEVEL_INFO
+#define TCP_LOG_LEVEL   LOG_LEVEL_INFO
+#define GCODE_LOG_LEVEL LOG_LEVEL_INFO
+#define WEB_LOG_LEVEL   LOG_LEVEL_INFO
+#define LCD_LOG_LEVEL   LOG_LEVEL_WARN
+#define PEER_LOG_LEVEL  LOG_LEVEL_INFO
+#define OTA_LOG_LEVEL   LOG_LEVEL_INFO
+#define HEALTH_LOG_LEVEL LOG_LEVEL_WARN
+
+// 主备Brain配置（brain_peer.h）：两台Brain烧录相同固件，备机镜像主机状态，主机失联后接管
+#define BRAIN_STANDBY_ENABLED 0   // 1=启用主备，0=单Brain（始终为主机）
+#define BRAIN_PRIORITY 1          // 两台同时为主机时优先级高的保留主机角色，两台应设置不同的值
+#define BRAIN_PEER_SYNC_INTERVAL_MS 100  // 同步包发送间隔（同时作为对端心跳）
+#define BRAIN_PEER_TIMEOUT_MS 1000       // 超过该时间收不到主机同步包时接管
+
+// Hand固件组播升级配置（brain_ota.h，/api/ota）
+#define HAND_FIRMWARE_PATH "/hand_firmware.bin"  // 上传的Hand镜像在LittleFS中的路径
+#define OTA_BEGIN_WAIT_MS 1500    // 开始后收集Hand应答的时间，之后加入的Hand不参与本次升级
+#define OTA_QUERY_TIMEOUT_MS 150  // 每轮等待各Hand回复块状态的时间（Hand写Flash时回复会延迟几十毫秒）
+#define OTA_MAX_ROUNDS 20         // Hand连续这么多轮不回复或补发后仍缺片时放弃该Hand
+#define OTA_VERIFY_TIMEOUT_MS 5000 // 等待各Hand校验结果的时间
+#define OTA_CHUNKS_PER_LOOP 4     // 每轮主循环最多组播的分片数
+
+// Hand健康状态告警阈值（brain_health.h，/api/health）
+#define HEALTH_RSSI_WARN_DBM -75          // 平均信号强度低于该值
+#define HEALTH_HEAP_WARN_BYTES 8192       // 空闲堆低于该值
+#define HEALTH_FRAGMENTATION_WARN 50      // 堆碎片率高于该值(%)，大块分配可能失败
+#define HEALTH_LOOP_WARN_US 20000         // 心跳区间内最大单轮循环耗时超过该值
+
 // 调试配置 - Brain开发模式
 #define DEBUG_MODE DEBUG_MODE_DISABLED  // 1=开发模式(启用串口), 0=正常模式(禁用串口)
 
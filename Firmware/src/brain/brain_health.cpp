@@ -0,0 +1,179 @@
+#include "brain_health.h"
+#include "brain_udp.h"
+#include "brain_log.h"
+#include <ArduinoJson.h>
+
+// 每个Hand的汇总，按首个通道的Feeder ID保存
+struct HandHealthRecord {
+    bool valid;                         // 收到过带健康状态的心跳
+    uint8_t status;                     // 最近一次心跳的status(HAND_STATUS_*)
+    uint8_t warnings;                   // 最近一次判断的告警位(HEALTH_WARN_*)
+    UDPHandHealth last;                 // 最近一次上报
+    uint32_t lastLoopMaxUs;             // 最近一次心跳区间内的最大单轮耗时
+    uint32_t lastUpdate;
+    uint32_t samples;
+    int16_t rssiAvg16;                  // 信号强度平滑平均值×16
+    int8_t rssiMin;
+    uint8_t fragmentationMax;
+    uint32_t freeHeapMin;
+    uint32_t loopMaxUs;                 // 所有心跳区间中的最大单轮耗时
+    uint16_t restarts;                  // Brain观察到的重启次数（运行时间变小），包括断电
+};
+
+static HandHealthRecord records[TOTAL_FEEDERS];
+
+static const char* const warningNames[] = {
+    "weak_rssi", "low_heap", "fragmented", "slow_loop", "resets", "feed_error"
+};
+
+static uint8_t evaluateWarnings(const HandHealthRecord& record) {
+    uint8_t warnings = 0;
+    if (record.rssiAvg16 / 16 < HEALTH_RSSI_WARN_DBM) {
+        warnings |= HEALTH_WARN_WEAK_RSSI;
+    }
+    if (record.last.freeHeap < HEALTH_HEAP_WARN_BYTES) {
+        warnings |= HEALTH_WARN_LOW_HEAP;
+    }
+    if (record.last.heapFragmentation > HEALTH_FRAGMENTATION_WARN) {
+        warnings |= HEALTH_WARN_FRAGMENTED;
+    }
+    if (record.lastLoopMaxUs > HEALTH_LOOP_WARN_US) {
+        warnings |= HEALTH_WARN_SLOW_LOOP;
+    }
+    if (record.last.resetCount > 0 || record.restarts > 0) {
+        warnings |= HEALTH_WARN_RESETS;
+    }
+    if (record.status & HAND_STATUS_FEED_ERROR) {
+        warnings |= HEALTH_WARN_FEED_ERROR;
+    }
+    return warnings;
+}
+
+static void resetAggregates(HandHealthRecord& record) {
+    record.samples = 1;
+    record.rssiAvg16 = record.last.rssi * 16;
+    record.rssiMin = record.last.rssi;
+    record.fragmentationMax = record.last.heapFragmentation;
+    record.freeHeapMin = record.last.freeHeap;
+    record.loopMaxUs = record.lastLoopMaxUs;
+    record.restarts = 0;
+}
+
+void recordHandHealth(uint8_t feederId, const UDPHeartbeatPacket& heartbeat) {
+    // 旧固件不带健康状态（缺少的字段为0）
+    if (feederId >= TOTAL_FEEDERS || heartbeat.health.freeHeap == 0) {
+        return;
+    }
+
+    HandHealthRecord& record = records[feederId];
+    const UDPHandHealth& health = heartbeat.health;
+    bool restarted = record.valid && health.uptimeS < record.last.uptimeS;
+
+    record.status = heartbeat.status;
+    record.last = health;
+    record.lastLoopMaxUs = heartbeat.loop.maxUs;
+    record.lastUpdate = millis();
+
+    if (!record.valid) {
+        record.valid = true;
+        resetAggregates(record);
+    } else {
+        record.samples++;
+        record.rssiAvg16 += health.rssi - record.rssiAvg16 / 16;    // 约16次心跳的指数平均
+        if (health.rssi < record.rssiMin) {
+            record.rssiMin = health.rssi;
+        }
+        if (health.heapFragmentation > record.fragmentationMax) {
+            record.fragmentationMax = health.heapFragmentation;
+        }
+        if (health.freeHeap < record.freeHeapMin) {
+            record.freeHeapMin = health.freeHeap;
+        }
+        if (record.lastLoopMaxUs > record.loopMaxUs) {
+            record.loopMaxUs = record.lastLoopMaxUs;
+        }
+        if (restarted) {
+            record.restarts++;
+        }
+    }
+
+    // 只在新出现告警时记录，避免每次心跳重复输出
+    uint8_t warnings = evaluateWarnings(record);
+    uint8_t added = warnings & ~record.warnings;
+    record.warnings = warnings;
+    if (added) {
+        LOG_WARN(HEALTH, "hand %u health warning 0x%02x, rssi %d, heap %u", feederId, added,
+                 health.rssi, health.freeHeap);
+    }
+}
+
+uint8_t getHandHealthWarnings(uint8_t feederId) {
+    return feederId < TOTAL_FEEDERS && records[feederId].valid ? records[feederId].warnings : 0;
+}
+
+void getHandHealthJSON(String& result) {
+    const size_t capacity = JSON_OBJECT_SIZE(3) + JSON_OBJECT_SIZE(4) + JSON_ARRAY_SIZE(TOTAL_FEEDERS)
+                          + TOTAL_FEEDERS * (JSON_OBJECT_SIZE(23) + JSON_ARRAY_SIZE(6)) + 128;
+    DynamicJsonDocument doc(capacity);
+    uint32_t now = millis();
+
+    JsonObject thresholds = doc.createNestedObject("thresholds");
+    thresholds["rssiDbm"] = HEALTH_RSSI_WARN_DBM;
+    thresholds["heapBytes"] = HEALTH_HEAP_WARN_BYTES;
+    thresholds["fragmentation"] = HEALTH_FRAGMENTATION_WARN;
+    thresholds["loopUs"] = HEALTH_LOOP_WARN_US;
+
+    uint8_t warningCount = 0;
+    JsonArray hands = doc.createNestedArray("hands");
+    for (int i = 0; i < TOTAL_FEEDERS; i++) {
+        const HandHealthRecord& record = records[i];
+        if (!record.valid) {
+            continue;
+        }
+        JsonObject object = hands.createNestedObject();
+        object["feederId"] = i;
+        object["online"] = connectedHands[i].isOnline;
+        object["ageS"] = (now - record.lastUpdate) / 1000;
+        object["samples"] = record.samples;
+        object["rssi"] = record.last.rssi;
+        object["rssiAvg"] = record.rssiAvg16 / 16;
+        object["rssiMin"] = record.rssiMin;
+        object["freeHeap"] = record.last.freeHeap;
+        object["freeHeapMin"] = record.freeHeapMin;
+        object["maxFreeBlock"] = record.last.maxFreeBlock;
+        object["fragmentation"] = record.last.heapFragmentation;
+        object["fragmentationMax"] = record.fragmentationMax;
+        object["loopMaxUs"] = record.lastLoopMaxUs;
+        object["loopMaxUsAll"] = record.loopMaxUs;
+        object["servoCycles"] = record.last.servoCycles;
+        object["uptimeS"] = record.last.uptimeS;
+        object["resetCount"] = record.last.resetCount;
+        object["resetReason"] = record.last.resetReason;
+        object["restarts"] = record.restarts;
+        object["errorCount"] = record.last.errorCount;
+        object["lastError"] = record.last.lastError;
+        object["status"] = record.status;
+
+        JsonArray warnings = object.createNestedArray("warnings");
+        for (uint8_t bit = 0; bit < sizeof(warningNames) / sizeof(warningNames[0]); bit++) {
+            if (record.warnings & (1 << bit)) {
+                warnings.add(warningNames[bit]);
+            }
+        }
+        if (record.warnings) {
+            warningCount++;
+        }
+    }
+    doc["warningCount"] = warningCount;
+
+    serializeJson(doc, result);
+}
+
+void clearHandHealth() {
+    for (int i = 0; i < TOTAL_FEEDERS; i++) {
+        if (records[i].valid) {
+            resetAggregates(records[i]);
+            records[i].warnings = evaluateWarnings(records[i]);
+        }
+    }
+}
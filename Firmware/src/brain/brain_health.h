@@ -0,0 +1,33 @@
+#ifndef BRAIN_HEALTH_H
+#define BRAIN_HEALTH_H
+
+#include <Arduino.h>
+#include "brain_config.h"
+#include "common/udp_protocol.h"
+
+// =============================================================================
+// Hand健康状态汇总 - 按Hand保存心跳上报的WiFi信号、堆、循环耗时、重启和送料错误，
+// 记录最差值并按brain_config.h中的阈值标出需要关注的Hand（/api/health）
+// =============================================================================
+
+// 告警位
+#define HEALTH_WARN_WEAK_RSSI   0x01
+#define HEALTH_WARN_LOW_HEAP    0x02
+#define HEALTH_WARN_FRAGMENTED  0x04
+#define HEALTH_WARN_SLOW_LOOP   0x08
+#define HEALTH_WARN_RESETS      0x10
+#define HEALTH_WARN_FEED_ERROR  0x20
+
+// 收到Hand心跳时调用（feederId为Hand首个通道的ID）
+void recordHandHealth(uint8_t feederId, const UDPHeartbeatPacket& heartbeat);
+
+// 获取Hand的告警位，没有记录时返回0
+uint8_t getHandHealthWarnings(uint8_t feederId);
+
+// 导出各Hand健康状态JSON（/api/health）
+void getHandHealthJSON(String& result);
+
+// 清空最差值和重启统计，保留最近一次上报
+void clearHandHealth();
+
+#endif // BRAIN_HEALTH_H
@@ -0,0 +1,106 @@
+#include "brain_log.h"
+
+static LogRing<LOG_RING_DEPTH> logRing;
+
+// 写入/取出记录用自旋锁，只保护几次内存拷贝
+static portMUX_TYPE logLock = portMUX_INITIALIZER_UNLOCKED;
+
+// 串口和/api/log都会取出记录，同一时间只允许一个输出者
+static SemaphoreHandle_t logDrainMutex = NULL;
+
+static const char levelNames[] = "?EWID";
+
+void brain_log_setup() {
+    if (logDrainMutex == NULL) {
+        logDrainMutex = xSemaphoreCreateMutex();
+    }
+}
+
+void logWrite(uint8_t level, const char* format, const uint32_t* args, uint8_t argCount) {
+    LogRecord record;
+    record.timeUs = micros();
+    record.format = format;
+    record.level = level;
+    record.argCount = argCount;
+    for (uint8_t i = 0; i < LOG_MAX_ARGS; i++) {
+        record.args[i] = i < argCount ? args[i] : 0;
+    }
+
+    portENTER_CRITICAL(&logLock);
+    logRing.push(record);
+    portEXIT_CRITICAL(&logLock);
+}
+
+// 把一条记录格式化成一行文本，返回长度（不含'\0'）
+static size_t formatRecord(const LogRecord& record, char* buffer, size_t size) {
+    char level = record.level < sizeof(levelNames) - 1 ? levelNames[record.level] : '?';
+    int length = snprintf(buffer, size, "[%lu] %c ", (unsigned long)(record.timeUs / 1000), level);
+    if (length < 0 || (size_t)length >= size) {
+        return 0;
+    }
+
+    // 参数个数不足的格式说明符读到的是0，多余参数被忽略
+    int messageLength = snprintf(buffer + length, size - length, record.format,
+                                 record.args[0], record.args[1], record.args[2], record.args[3]);
+    if (messageLength < 0) {
+        messageLength = 0;
+    }
+    length += messageLength;
+    if ((size_t)length >= size - 1) {
+        // 过长的消息截断
+        length = size - 2;
+    }
+    buffer[length++] = '\n';
+    buffer[length] = '\0';
+    return length;
+}
+
+size_t logDrain(Print& out, size_t maxBytes) {
+    if (logDrainMutex == NULL || xSemaphoreTake(logDrainMutex, 0) != pdTRUE) {
+        return 0;
+    }
+
+    char line[LOG_LINE_LENGTH];
+    size_t written = 0;
+
+    if (maxBytes >= sizeof(line)) {
+        portENTER_CRITICAL(&logLock);
+        uint32_t dropped = logRing.takeDropped();
+        portEXIT_CRITICAL(&logLock);
+        if (dropped > 0) {
+            size_t length = snprintf(line, sizeof(line), "[log] %lu条日志因缓冲区满被丢弃\n", (unsigned long)dropped);
+            written += out.write((const uint8_t*)line, length);
+        }
+    }
+
+    LogRecord record;
+    while (true) {
+        portENTER_CRITICAL(&logLock);
+        bool hasRecord = logRing.peek(record);
+        portEXIT_CRITICAL(&logLock);
+        if (!hasRecord) {
+            break;
+        }
+
+        size_t length = formatRecord(record, line, sizeof(line));
+        if (written + length > maxBytes) {
+            // 剩余空间不够，留到下一次
+            break;
+        }
+        written += out.write((const uint8_t*)line, length);
+
+        portENTER_CRITICAL(&logLock);
+        logRing.pop();
+        portEXIT_CRITICAL(&logLock);
+    }
+
+    xSemaphoreGive(logDrainMutex);
+    return written;
+}
+
+void logDrainToSerial() {
+    size_t space = Serial.availableForWrite();
+    if (space > 0) {
+        logDrain(Serial, space);
+    }
+}
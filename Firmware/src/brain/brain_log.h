@@ -0,0 +1,56 @@
+#ifndef BRAIN_LOG_H
+#define BRAIN_LOG_H
+
+#include <Arduino.h>
+#include <type_traits>
+#include "brain_config.h"
+#include "log_ring.h"
+
+// =============================================================================
+// Brain延迟日志 - 热路径上只写一条记录到RAM环形缓冲区（几微秒），
+// 主循环空闲时再格式化输出到串口，也可通过/api/log读取
+//
+// 用法：LOG_INFO(TCP, "client #%u connected", id);
+// 模块级别在brain_config.h中用<模块>_LOG_LEVEL配置，低于该级别的调用在编译期去掉
+// 参数最多LOG_MAX_ARGS个，只支持整数和常量字符串（%d %u %x %c %s），
+// 不能传入String、浮点数或会在输出前被修改的字符数组
+// =============================================================================
+
+void brain_log_setup();
+
+// 写入一条记录，缓冲区满时丢弃并计数（可在任意任务中调用，不能在中断中调用）
+void logWrite(uint8_t level, const char* format, const uint32_t* args, uint8_t argCount);
+
+// 输出已缓存的记录，最多maxBytes字节（不会拆开一条记录），返回输出的字节数
+size_t logDrain(Print& out, size_t maxBytes);
+
+// 主循环空闲时调用：只写入串口发送缓冲区的剩余空间，不会阻塞
+void logDrainToSerial();
+
+template <typename T>
+inline uint32_t logArg(T value) {
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+                  "延迟日志只支持整数和常量字符串参数");
+    return (uint32_t)(uintptr_t)value;
+}
+
+template <typename... Args>
+inline void brainLog(uint8_t level, const char* format, Args... args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "延迟日志参数过多");
+    uint32_t values[LOG_MAX_ARGS] = {logArg(args)...};
+    logWrite(level, format, values, sizeof...(Args));
+}
+
+#define BRAIN_LOG(module, level, format, ...) \
+    do { \
+        if (module##_LOG_LEVEL >= LOG_LEVEL_##level) { \
+            brainLog(LOG_LEVEL_##level, format, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_ERROR(module, format, ...) BRAIN_LOG(module, ERROR, format, ##__VA_ARGS__)
+#define LOG_WARN(module, format, ...)  BRAIN_LOG(module, WARN, format, ##__VA_ARGS__)
+#define LOG_INFO(module, format, ...)  BRAIN_LOG(module, INFO, format, ##__VA_ARGS__)
+#define LOG_DEBUG(module, format, ...) BRAIN_LOG(module, DEBUG, format, ##__VA_ARGS__)
+
+#endif // BRAIN_LOG_H
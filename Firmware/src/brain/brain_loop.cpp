@@ -0,0 +1,91 @@
+#include "brain_loop.h"
+#include "brain_udp.h"
+#include "brain_log.h"
+#include <ArduinoJson.h>
+
+static LoopProfiler<BRAIN_LOOP_STAGE_COUNT> loopProfiler;
+static uint32_t stageStartCycles = 0;
+static uint32_t cyclesPerUs = 160;
+
+static const char* const stageNames[BRAIN_LOOP_STAGE_COUNT] = {
+    "lcd", "gcode", "tcp", "udp", "web", "idle", "log"
+};
+
+void loop_profile_setup() {
+    cyclesPerUs = ESP.getCpuFreqMHz();
+}
+
+void loopProfileBegin() {
+    stageStartCycles = ESP.getCycleCount();
+}
+
+void loopProfileStage(uint8_t stage) {
+    // 周期计数器32位回绕，差值在单次回绕内仍然正确
+    uint32_t now = ESP.getCycleCount();
+    loopProfiler.record(stage, (now - stageStartCycles) / cyclesPerUs);
+    stageStartCycles = now;
+}
+
+void loopProfileEnd() {
+    uint32_t loopUs = loopProfiler.endLoop();
+    if (loopUs > LOOP_STALL_US) {
+        LOG_WARN(MAIN, "loop stall %uus, %s took %uus", loopUs,
+                 stageNames[loopProfiler.getLastWorstStage()], loopProfiler.getLastWorstStageUs());
+    }
+}
+
+static void addStats(JsonObject object, const LoopStageStats& stats) {
+    object["count"] = stats.count;
+    object["minUs"] = stats.minUs;
+    object["avgUs"] = loopStatsAverage(stats);
+    object["p99Us"] = loopStatsPercentile(stats, 99);
+    object["maxUs"] = stats.maxUs;
+}
+
+void getLoopProfileJSON(String& result) {
+    const size_t capacity = JSON_OBJECT_SIZE(5) + JSON_OBJECT_SIZE(6) + JSON_ARRAY_SIZE(LOOP_HISTOGRAM_BUCKETS)
+                          + JSON_ARRAY_SIZE(BRAIN_LOOP_STAGE_COUNT) + BRAIN_LOOP_STAGE_COUNT * JSON_OBJECT_SIZE(6)
+                          + JSON_ARRAY_SIZE(TOTAL_FEEDERS) + TOTAL_FEEDERS * JSON_OBJECT_SIZE(7) + 256;
+    DynamicJsonDocument doc(capacity);
+
+    const LoopStageStats& loop = loopProfiler.loopStats();
+    JsonObject loopObject = doc.createNestedObject("loop");
+    addStats(loopObject, loop);
+    JsonArray histogram = loopObject.createNestedArray("histogram");
+    for (uint8_t i = 0; i < LOOP_HISTOGRAM_BUCKETS; i++) {
+        histogram.add(loop.histogram[i]);
+    }
+
+    doc["worstStage"] = stageNames[loopProfiler.getWorstStage()];
+    doc["worstStageUs"] = loopProfiler.getWorstStageUs();
+
+    JsonArray stages = doc.createNestedArray("stages");
+    for (uint8_t i = 0; i < BRAIN_LOOP_STAGE_COUNT; i++) {
+        JsonObject stage = stages.createNestedObject();
+        stage["name"] = stageNames[i];
+        addStats(stage, loopProfiler.stage(i));
+    }
+
+    // Hand统计区间为两次心跳之间
+    JsonArray hands = doc.createNestedArray("hands");
+    for (int i = 0; i < TOTAL_FEEDERS; i++) {
+        const HandInfo& hand = connectedHands[i];
+        if (!hand.isOnline || hand.channel != 0 || hand.loopStats.loops == 0) {
+            continue;
+        }
+        JsonObject object = hands.createNestedObject();
+        object["feederId"] = i;
+        object["loops"] = hand.loopStats.loops;
+        object["avgUs"] = hand.loopStats.avgUs;
+        object["p99Us"] = hand.loopStats.p99Us;
+        object["maxUs"] = hand.loopStats.maxUs;
+        object["worstStage"] = getHandLoopStageName(hand.loopStats.worstStage);
+        object["worstStageUs"] = hand.loopStats.worstStageUs;
+    }
+
+    serializeJson(doc, result);
+}
+
+void clearLoopProfile() {
+    loopProfiler.clear();
+}
@@ -0,0 +1,41 @@
+#ifndef BRAIN_LOOP_H
+#define BRAIN_LOOP_H
+
+#include <Arduino.h>
+#include "brain_config.h"
+#include "common/loop_profiler.h"
+
+// =============================================================================
+// Brain主循环耗时统计（/api/loop），Hand的统计随心跳上报
+// =============================================================================
+
+// Brain主循环阶段
+typedef enum {
+    BRAIN_LOOP_LCD = 0,                 // lcd_update和在线数量刷新
+    BRAIN_LOOP_GCODE,                   // processGcodeLines
+    BRAIN_LOOP_TCP,                     // tcp_loop
+    BRAIN_LOOP_UDP,                     // brain_udp_update、brain_peer_update和brain_ota_update
+    BRAIN_LOOP_WEB,                     // web_update
+    BRAIN_LOOP_IDLE,                    // waitForGcodeLine（最多约1ms）
+    BRAIN_LOOP_LOG,                     // 空闲时输出延迟日志
+    BRAIN_LOOP_STAGE_COUNT
+} BrainLoopStage;
+
+void loop_profile_setup();
+
+// 每轮循环开始时调用
+void loopProfileBegin();
+
+// 记录从上一个标记点到现在的耗时，计入stage
+void loopProfileStage(uint8_t stage);
+
+// 一轮循环结束，超过LOOP_STALL_US时记录耗时最多的阶段
+void loopProfileEnd();
+
+// 导出统计JSON（Brain各阶段 + 各Hand最近一次心跳上报的统计）
+void getLoopProfileJSON(String& result);
+
+// 清空Brain端统计
+void clearLoopProfile();
+
+#endif // BRAIN_LOOP_H
@@ -5,6 +5,10 @@
 #include "gcode.h"
 #include "lcd.h"
 #include "brain_tcp.h"
+#include "brain_log.h"
+#include "brain_loop.h"
+#include "brain_peer.h"
+#include "brain_ota.h"
 
 void setup()
 {
@@ -12,6 +16,8 @@ void setup()
     Serial.begin(115200);
     delay(1000); // 等待串口稳定
     Serial.println("ESP-NOW PNP Brain Controller Starting...");
+    brain_log_setup();
+    loop_profile_setup();
 
 #if HAS_LCD
     // 只有在有LCD硬件时才初始化LCD
@@ -25,6 +31,8 @@ void setup()
     // 初始化UDP通信
     Serial.println("Initializing UDP communication...");
     brain_udp_setup();
+    brain_peer_setup(); // 主备Brain（未启用时始终为主机）
+    brain_ota_setup(); // Hand固件组播升级
 
     // 初始化feeder状态数组
     initFeederStatus();
@@ -33,13 +41,14 @@ void setup()
     lcd_update_system_status(SYSTEM_RUNNING);
 #endif
 
+    gcode_setup(); // 初始化G-code输入队列和串口接收事件
     tcp_setup(); // 初始化TCP服务器
     web_setup(); // 初始化Web服务器
 
     // 输出网络信息
     Serial.printf("WiFi连接状态: %s\n", WiFi.status() == WL_CONNECTED ? "已连接" : "未连接");
     Serial.printf("本地IP地址: %s\n", WiFi.localIP().toString().c_str());
-    Serial.printf("TCP服务器端口: 8080\n");
+    Serial.printf("TCP服务器端口: %d\n", TCP_GCODE_PORT);
     Serial.printf("Web服务器端口: 80\n");
     Serial.printf("UDP监听端口: %d\n", UDP_BRAIN_PORT);
 
@@ -50,22 +59,31 @@ void setup()
 
 void loop()
 {
+    loopProfileBegin();
+
 #if HAS_LCD
     // 更新LCD显示 (只有在有LCD时才调用)
     lcd_update();
 #endif
+    loopProfileStage(BRAIN_LOOP_LCD);
 
-    // 处理串口G-code命令
-    listenToSerialStream();
+    // 处理串口和TCP收到的G-code命令
+    processGcodeLines();
+    loopProfileStage(BRAIN_LOOP_GCODE);
 
     // 处理TCP通信
     tcp_loop();
+    loopProfileStage(BRAIN_LOOP_TCP);
 
     // 处理UDP通信
     brain_udp_update();
+    brain_peer_update();
+    brain_ota_update();
+    loopProfileStage(BRAIN_LOOP_UDP);
 
     // 处理Web服务器更新
     web_update();
+    loopProfileStage(BRAIN_LOOP_WEB);
 
 #if HAS_LCD
     // 更新在线手部数量 (只有在有LCD时才需要)
@@ -77,7 +95,17 @@ void loop()
         last_hand_count_update = millis();
     }
 #endif
+    loopProfileStage(BRAIN_LOOP_LCD);
+
+    // 等待下一行G-code，最多1ms以避免过度占用CPU；串口或TCP收到新行时立即进入下一轮循环
+    // 没有新行时才输出缓存的日志
+    bool hasLine = waitForGcodeLine(1);
+    loopProfileStage(BRAIN_LOOP_IDLE);
+    if (!hasLine)
+    {
+        logDrainToSerial();
+    }
+    loopProfileStage(BRAIN_LOOP_LOG);
 
-    // 添加一个小延迟以避免过度占用CPU
-    delay(1);
+    loopProfileEnd();
 }
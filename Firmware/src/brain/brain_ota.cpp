@@ -0,0 +1,514 @@
+#include "brain_ota.h"
+#include "brain_log.h"
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <LittleFS.h>
+#include <MD5Builder.h>
+#include <ArduinoJson.h>
+
+// 升级阶段
+typedef enum {
+    OTA_PHASE_IDLE = 0,
+    OTA_PHASE_BEGIN,                    // 组播开始包，收集参与的Hand
+    OTA_PHASE_SEND,                     // 组播当前块待发送的分片
+    OTA_PHASE_QUERY,                    // 等待各Hand回复当前块的缺失位图
+    OTA_PHASE_VERIFY,                   // 等待各Hand校验镜像
+    OTA_PHASE_REBOOT,                   // 通知校验通过的Hand重启
+    OTA_PHASE_DONE,
+    OTA_PHASE_FAILED
+} FleetOtaPhase;
+
+static const char* phaseNames[] = {"idle", "begin", "send", "query", "verify", "reboot", "done", "failed"};
+static const char* handStateNames[] = {"idle", "receiving", "verified", "failed"};
+
+// 参与升级的Hand
+struct OtaHand {
+    IPAddress ip;
+    uint8_t feederId;
+    uint8_t state;                      // OtaState
+    uint8_t error;                      // OtaError
+    bool active;                        // 仍在本次升级中（失败或被放弃后为false）
+    bool replied;                       // 本轮已回复当前块状态
+    bool blockDone;                     // 已确认收齐当前块，之后的查询轮不再等待它
+    uint8_t failedRounds;               // 连续未回复或补发后仍缺片的轮数
+    uint32_t missing;                   // 当前块缺失的分片
+    uint32_t bytesWritten;
+};
+
+static OtaHand otaHands[TOTAL_FEEDERS];
+static uint8_t otaHandCount = 0;
+
+static WiFiUDP otaUdp;
+static File image;
+static File uploadFile;
+
+// Web请求在主循环中执行，避免在Web任务中读写镜像文件
+static volatile bool startRequested = false;
+static volatile bool abortRequested = false;
+
+static volatile uint8_t phase = OTA_PHASE_IDLE;
+static uint32_t phaseStart = 0;
+static uint32_t lastControlSent = 0;
+static uint8_t controlRepeats = 0;
+static const char* failReason = "";
+
+static uint16_t sessionId = 0;
+static uint32_t imageSize = 0;
+static uint8_t imageMd5[16];
+static uint16_t totalBlocks = 0;
+static uint16_t currentBlock = 0;
+static uint32_t sendMask = 0;               // 当前块本轮还要组播的分片
+static uint8_t queryRound = 0;              // 当前块已进行的查询轮数
+
+static uint8_t blockBuffer[OTA_BLOCK_CHUNKS * OTA_CHUNK_SIZE];
+static uint8_t packetBuffer[sizeof(UDPOtaChunkHeader) + OTA_CHUNK_SIZE];
+
+// 统计
+static uint32_t startTime = 0;
+static uint32_t endTime = 0;
+static uint32_t chunksSent = 0;
+static uint32_t chunksResent = 0;
+static uint32_t queriesSent = 0;
+
+static void enterPhase(uint8_t newPhase) {
+    phase = newPhase;
+    phaseStart = millis();
+    lastControlSent = 0;
+    controlRepeats = 0;
+}
+
+static bool multicast(const uint8_t* data, size_t length) {
+    otaUdp.beginPacket(UDP_OTA_MULTICAST_IP, UDP_OTA_PORT);
+    otaUdp.write(data, length);
+    return otaUdp.endPacket();
+}
+
+static void sendControl(uint8_t action, uint16_t blockIndex) {
+    UDPOtaControl control;
+    control.packetType = UDP_PKT_OTA_CONTROL;
+    control.action = action;
+    control.sessionId = sessionId;
+    control.blockIndex = blockIndex;
+    multicast((uint8_t*)&control, sizeof(control));
+    lastControlSent = millis();
+    controlRepeats++;
+}
+
+static void sendBegin() {
+    UDPOtaBegin begin;
+    begin.packetType = UDP_PKT_OTA_BEGIN;
+    begin.blockChunks = OTA_BLOCK_CHUNKS;
+    begin.sessionId = sessionId;
+    begin.imageSize = imageSize;
+    begin.chunkSize = OTA_CHUNK_SIZE;
+    memcpy(begin.md5, imageMd5, sizeof(imageMd5));
+    multicast((uint8_t*)&begin, sizeof(begin));
+    lastControlSent = millis();
+}
+
+static uint8_t activeHandCount() {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < otaHandCount; i++) {
+        if (otaHands[i].active) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static void finishUpdate(uint8_t result, const char* reason) {
+    if (image) {
+        image.close();
+    }
+    failReason = reason;
+    endTime = millis();
+    enterPhase(result);
+    if (result == OTA_PHASE_DONE) {
+        LOG_INFO(OTA, "fleet update done in %lums, %u hands verified",
+                 (unsigned long)(endTime - startTime), activeHandCount());
+    } else {
+        LOG_WARN(OTA, "fleet update failed: %s", reason);
+    }
+}
+
+static void dropHand(OtaHand& hand, uint8_t error) {
+    hand.active = false;
+    hand.state = OTA_STATE_FAILED;
+    hand.error = error;
+    LOG_WARN(OTA, "hand %u dropped from update, error %u", hand.feederId, error);
+}
+
+static bool loadBlock(uint16_t block) {
+    uint32_t bytes = otaBlockBytes(imageSize, block);
+    return image.seek((uint32_t)block * sizeof(blockBuffer)) && image.read(blockBuffer, bytes) == bytes;
+}
+
+static void startBlock(uint16_t block) {
+    currentBlock = block;
+    if (!loadBlock(block)) {
+        finishUpdate(OTA_PHASE_FAILED, "image read error");
+        return;
+    }
+    sendMask = otaBlockMask(imageSize, block);
+    queryRound = 0;
+    for (uint8_t i = 0; i < otaHandCount; i++) {
+        otaHands[i].blockDone = false;
+    }
+    enterPhase(OTA_PHASE_SEND);
+}
+
+static void startUpdate() {
+    image = LittleFS.open(HAND_FIRMWARE_PATH, "r");
+    if (!image || image.size() == 0) {
+        finishUpdate(OTA_PHASE_FAILED, "no image");
+        return;
+    }
+    imageSize = image.size();
+
+    // 用块缓冲区分段计算整个镜像的MD5，由Hand在写完后校验
+    MD5Builder md5;
+    md5.begin();
+    int length;
+    while ((length = image.read(blockBuffer, sizeof(blockBuffer))) > 0) {
+        md5.add(blockBuffer, length);
+    }
+    md5.calculate();
+    md5.getBytes(imageMd5);
+
+    sessionId = random(1, 0x10000);
+    totalBlocks = otaBlockCount(imageSize);
+    currentBlock = 0;
+    otaHandCount = 0;
+    failReason = "";
+    startTime = millis();
+    endTime = 0;
+    chunksSent = 0;
+    chunksResent = 0;
+    queriesSent = 0;
+    enterPhase(OTA_PHASE_BEGIN);
+
+    LOG_INFO(OTA, "fleet update started: %lu bytes, %u blocks, session %u",
+             (unsigned long)imageSize, totalBlocks, sessionId);
+}
+
+static OtaHand* findHand(IPAddress ip, uint8_t feederId) {
+    for (uint8_t i = 0; i < otaHandCount; i++) {
+        if (otaHands[i].ip == ip && otaHands[i].feederId == feederId) {
+            return &otaHands[i];
+        }
+    }
+    return nullptr;
+}
+
+static void handleStatus(const UDPOtaStatus& status, IPAddress fromIP) {
+    OtaHand* hand = findHand(fromIP, status.feederId);
+    if (hand == nullptr) {
+        // 只在开始阶段接受新的Hand
+        if (phase != OTA_PHASE_BEGIN || otaHandCount >= TOTAL_FEEDERS) {
+            return;
+        }
+        hand = &otaHands[otaHandCount++];
+        hand->ip = fromIP;
+        hand->feederId = status.feederId;
+        hand->active = true;
+        hand->replied = false;
+        hand->blockDone = false;
+        hand->failedRounds = 0;
+        hand->missing = 0;
+    }
+    if (!hand->active) {
+        return;
+    }
+
+    hand->state = status.state;
+    hand->error = status.error;
+    hand->bytesWritten = status.bytesWritten;
+    if (status.state == OTA_STATE_FAILED) {
+        hand->active = false;
+        LOG_WARN(OTA, "hand %u failed, error %u", hand->feederId, status.error);
+        return;
+    }
+
+    // 发送阶段收到的迟到回复也能确认收齐，但缺片只按本轮查询的回复补发
+    if (status.blockIndex == currentBlock && (phase == OTA_PHASE_QUERY || phase == OTA_PHASE_SEND)) {
+        if (status.missing == 0) {
+            hand->blockDone = true;
+        }
+        if (phase == OTA_PHASE_QUERY) {
+            hand->replied = true;
+            hand->missing = status.missing;
+        }
+    }
+}
+
+static void receiveStatus() {
+    UDPOtaStatus status;
+    while (otaUdp.parsePacket() > 0) {
+        IPAddress fromIP = otaUdp.remoteIP();
+        size_t length = otaUdp.read((uint8_t*)&status, sizeof(status));
+        if (length >= sizeof(status) && status.packetType == UDP_PKT_OTA_STATUS && status.sessionId == sessionId) {
+            handleStatus(status, fromIP);
+        }
+    }
+}
+
+// 组播当前块待发送的分片，每次最多OTA_CHUNKS_PER_LOOP片，发送失败的留到下一次
+static void sendPendingChunks() {
+    UDPOtaChunkHeader* header = (UDPOtaChunkHeader*)packetBuffer;
+    uint8_t sent = 0;
+    for (uint8_t slot = 0; slot < OTA_BLOCK_CHUNKS && sent < OTA_CHUNKS_PER_LOOP; slot++) {
+        if (!(sendMask & (1UL << slot))) {
+            continue;
+        }
+        uint16_t chunkIndex = currentBlock * OTA_BLOCK_CHUNKS + slot;
+        header->packetType = UDP_PKT_OTA_CHUNK;
+        header->reserved = 0;
+        header->sessionId = sessionId;
+        header->chunkIndex = chunkIndex;
+        header->length = otaChunkLength(imageSize, chunkIndex);
+        memcpy(packetBuffer + sizeof(UDPOtaChunkHeader), blockBuffer + slot * OTA_CHUNK_SIZE, header->length);
+        if (!multicast(packetBuffer, sizeof(UDPOtaChunkHeader) + header->length)) {
+            break;
+        }
+        sendMask &= ~(1UL << slot);
+        sent++;
+        chunksSent++;
+        if (queryRound > 0) {
+            chunksResent++;
+        }
+    }
+}
+
+static void startQuery() {
+    for (uint8_t i = 0; i < otaHandCount; i++) {
+        otaHands[i].replied = false;
+    }
+    sendControl(OTA_ACTION_QUERY, currentBlock);
+    queriesSent++;
+    enterPhase(OTA_PHASE_QUERY);
+}
+
+// 本轮是否还在等待某个未确认收齐的Hand回复
+static bool waitingForReplies() {
+    for (uint8_t i = 0; i < otaHandCount; i++) {
+        if (otaHands[i].active && !otaHands[i].blockDone && !otaHands[i].replied) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 一轮查询结束：都已确认收齐则进入下一块，否则补发缺失分片的并集后再查询未确认的Hand
+static void finishQueryRound() {
+    uint32_t missing = 0;
+    bool allDone = true;
+    for (uint8_t i = 0; i < otaHandCount; i++) {
+        OtaHand& hand = otaHands[i];
+        if (!hand.active) {
+            continue;
+        }
+        // 之前某轮已确认收齐的Hand本轮丢了查询或回复也不用再等
+        if (hand.blockDone) {
+            hand.failedRounds = 0;
+            continue;
+        }
+        // 按每个Hand连续失败的轮数放弃：Hand多时几乎每轮都有个别Hand丢包，不能按块的轮数判断
+        if (++hand.failedRounds > OTA_MAX_ROUNDS) {
+            dropHand(hand, OTA_ERROR_TIMEOUT);
+            continue;
+        }
+        allDone = false;
+        if (hand.replied) {
+            missing |= hand.missing;
+        }
+    }
+    queryRound++;
+
+    if (activeHandCount() == 0) {
+        finishUpdate(OTA_PHASE_FAILED, "all hands failed");
+    } else if (allDone) {
+        if (currentBlock + 1 >= totalBlocks) {
+            enterPhase(OTA_PHASE_VERIFY);
+        } else {
+            startBlock(currentBlock + 1);
+        }
+    } else {
+        // 只有未回复的Hand时sendMask为0，直接再次查询
+        sendMask = missing;
+        enterPhase(OTA_PHASE_SEND);
+    }
+}
+
+static void updateVerify(uint32_t now) {
+    bool allDone = true;
+    for (uint8_t i = 0; i < otaHandCount; i++) {
+        if (otaHands[i].active && otaHands[i].state != OTA_STATE_VERIFIED) {
+            allDone = false;
+        }
+    }
+
+    if (!allDone && now - phaseStart >= OTA_VERIFY_TIMEOUT_MS) {
+        for (uint8_t i = 0; i < otaHandCount; i++) {
+            if (otaHands[i].active && otaHands[i].state != OTA_STATE_VERIFIED) {
+                dropHand(otaHands[i], OTA_ERROR_TIMEOUT);
+            }
+        }
+        allDone = true;
+    }
+
+    if (allDone) {
+        if (activeHandCount() == 0) {
+            finishUpdate(OTA_PHASE_FAILED, "no hand verified");
+        } else {
+            enterPhase(OTA_PHASE_REBOOT);
+        }
+    } else if (now - lastControlSent >= 300) {
+        // Hand在END后校验并回复，未回复的定期重发
+        sendControl(OTA_ACTION_END, currentBlock);
+    }
+}
+
+void brain_ota_setup() {
+    if (otaUdp.begin(UDP_OTA_PORT)) {
+        DEBUG_PRINTF("Brain OTA: 监听端口 %d\n", UDP_OTA_PORT);
+    } else {
+        DEBUG_PRINTLN("Brain OTA: 端口初始化失败");
+    }
+}
+
+void brain_ota_update() {
+    if (abortRequested) {
+        abortRequested = false;
+        if (isFleetUpdateRunning()) {
+            sendControl(OTA_ACTION_ABORT, currentBlock);
+            finishUpdate(OTA_PHASE_FAILED, "aborted");
+        }
+    }
+    if (startRequested) {
+        startRequested = false;
+        if (!isFleetUpdateRunning()) {
+            startUpdate();
+        }
+    }
+    if (!isFleetUpdateRunning()) {
+        return;
+    }
+
+    receiveStatus();
+
+    uint32_t now = millis();
+    switch (phase) {
+        case OTA_PHASE_BEGIN:
+            if (now - lastControlSent >= 300) {
+                sendBegin();
+            }
+            if (now - phaseStart >= OTA_BEGIN_WAIT_MS) {
+                if (activeHandCount() == 0) {
+                    finishUpdate(OTA_PHASE_FAILED, "no hands");
+                } else {
+                    LOG_INFO(OTA, "%u hands joined the update", activeHandCount());
+                    startBlock(0);
+                }
+            }
+            break;
+
+        case OTA_PHASE_SEND:
+            sendPendingChunks();
+            if (sendMask == 0) {
+                startQuery();
+            }
+            break;
+
+        case OTA_PHASE_QUERY:
+            if (!waitingForReplies() || now - phaseStart >= OTA_QUERY_TIMEOUT_MS) {
+                finishQueryRound();
+            }
+            break;
+
+        case OTA_PHASE_VERIFY:
+            updateVerify(now);
+            break;
+
+        case OTA_PHASE_REBOOT:
+            // 重启命令不需要回复，组播3次
+            if (controlRepeats >= 3) {
+                finishUpdate(OTA_PHASE_DONE, "");
+            } else if (now - lastControlSent >= 100) {
+                sendControl(OTA_ACTION_REBOOT, currentBlock);
+            }
+            break;
+    }
+}
+
+bool storeHandFirmware(size_t index, const uint8_t* data, size_t length, bool final) {
+    if (isFleetUpdateRunning()) {
+        return false;
+    }
+    // 先写入临时文件，完整上传后才替换，避免用截断的镜像升级
+    if (index == 0) {
+        uploadFile = LittleFS.open(HAND_FIRMWARE_PATH ".tmp", "w");
+    }
+    if (!uploadFile) {
+        return false;
+    }
+    bool ok = uploadFile.write(data, length) == length;
+    if (!ok) {
+        uploadFile.close();
+        LittleFS.remove(HAND_FIRMWARE_PATH ".tmp");
+    } else if (final) {
+        uploadFile.close();
+        LittleFS.remove(HAND_FIRMWARE_PATH);
+        ok = LittleFS.rename(HAND_FIRMWARE_PATH ".tmp", HAND_FIRMWARE_PATH);
+    }
+    return ok;
+}
+
+bool requestFleetUpdate() {
+    if (isFleetUpdateRunning() || !LittleFS.exists(HAND_FIRMWARE_PATH)) {
+        return false;
+    }
+    startRequested = true;
+    return true;
+}
+
+void requestFleetUpdateAbort() {
+    abortRequested = true;
+}
+
+bool isFleetUpdateRunning() {
+    return phase != OTA_PHASE_IDLE && phase != OTA_PHASE_DONE && phase != OTA_PHASE_FAILED;
+}
+
+void getFleetUpdateStatusJSON(String& result) {
+    const size_t capacity = JSON_OBJECT_SIZE(12) + JSON_ARRAY_SIZE(TOTAL_FEEDERS)
+                          + TOTAL_FEEDERS * (JSON_OBJECT_SIZE(5) + 16) + 128;
+    DynamicJsonDocument doc(capacity);
+
+    doc["phase"] = phaseNames[phase];
+    if (phase == OTA_PHASE_FAILED) {
+        doc["reason"] = failReason;
+    }
+    if (phase != OTA_PHASE_IDLE) {
+        doc["session"] = sessionId;
+        doc["imageSize"] = imageSize;
+        doc["block"] = currentBlock;
+        doc["blocks"] = totalBlocks;
+        doc["elapsedMs"] = (endTime ? endTime : millis()) - startTime;
+        doc["chunksSent"] = chunksSent;
+        doc["chunksResent"] = chunksResent;
+        doc["queries"] = queriesSent;
+    }
+
+    JsonArray hands = doc.createNestedArray("hands");
+    for (uint8_t i = 0; i < otaHandCount; i++) {
+        const OtaHand& hand = otaHands[i];
+        JsonObject object = hands.createNestedObject();
+        object["feederId"] = hand.feederId;
+        object["ip"] = hand.ip.toString();
+        object["state"] = hand.state < 4 ? handStateNames[hand.state] : "unknown";
+        object["error"] = hand.error;
+        object["bytesWritten"] = hand.bytesWritten;
+    }
+
+    serializeJson(doc, result);
+}
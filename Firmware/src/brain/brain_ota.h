@@ -0,0 +1,34 @@
+#ifndef BRAIN_OTA_H
+#define BRAIN_OTA_H
+
+#include <Arduino.h>
+#include "brain_config.h"
+#include "common/udp_protocol.h"
+
+// =============================================================================
+// Hand固件组播升级 - 把LittleFS中的Hand镜像按块组播给所有Hand，
+// 每块按各Hand回复的缺失位图补发，全部校验通过后再让Hand重启（协议见udp_protocol.h）
+//
+// 用法：POST /api/ota/image上传镜像，POST /api/ota开始，GET /api/ota查看进度
+// =============================================================================
+
+void brain_ota_setup();
+
+// 在主循环中调用：推进升级状态机
+void brain_ota_update();
+
+// 保存上传的镜像（Web上传回调中调用，index为本段在文件中的偏移），升级进行中时返回false
+bool storeHandFirmware(size_t index, const uint8_t* data, size_t length, bool final);
+
+// 请求开始升级（在下一次brain_ota_update中开始），没有镜像或已在升级时返回false
+bool requestFleetUpdate();
+
+// 请求取消升级
+void requestFleetUpdateAbort();
+
+bool isFleetUpdateRunning();
+
+// 获取升级进度和各Hand状态JSON（/api/ota）
+void getFleetUpdateStatusJSON(String& result);
+
+#endif // BRAIN_OTA_H
@@ -0,0 +1,410 @@
+#include "brain_peer.h"
+#include "brain_udp.h"
+#include "brain_log.h"
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <ArduinoJson.h>
+
+static const char* roleNames[] = {"startup", "active", "standby"};
+
+static const char* roleName(uint8_t role) {
+    return role < sizeof(roleNames) / sizeof(roleNames[0]) ? roleNames[role] : "unknown";
+}
+
+#if BRAIN_STANDBY_ENABLED
+
+// 接管时跳过的序列号数量：对端最后一次同步之后可能还发出过命令，避免新命令与其响应混淆
+#define PEER_SEQUENCE_GAP 1000
+
+static WiFiUDP peerUdp;
+static uint8_t peerBuffer[UDP_BUFFER_SIZE];
+
+// 角色在主循环中修改，TCP回调任务只读取
+static volatile uint8_t brainRole = BRAIN_ROLE_STARTUP;
+static uint32_t roleSince = 0;
+
+// 对端状态
+static bool peerSeen = false;
+static IPAddress peerIP;
+static uint8_t peerRole = BRAIN_ROLE_STARTUP;
+static uint8_t peerPriority = 0;
+static uint32_t peerNextSequence = 0;
+static uint32_t lastPeerSeen = 0;
+
+// 备机镜像的对端在途命令（接管时继续等待响应）
+static PendingCommandInfo peerPending[TOTAL_FEEDERS];
+static uint32_t peerPendingReceived[TOTAL_FEEDERS];
+static bool peerPendingValid[TOTAL_FEEDERS];
+
+static uint32_t lastSyncSent = 0;
+static uint8_t syncCursor = 0;              // 下一个同步的Feeder ID（轮流同步全部Feeder）
+
+// 统计
+static uint32_t syncSent = 0;
+static uint32_t syncReceived = 0;
+static uint32_t takeoverCount = 0;
+static uint32_t lastTakeoverGapMs = 0;      // 最近一次接管时距最后收到主机同步包的时间
+static uint8_t lastTakeoverHands = 0;
+static uint8_t lastTakeoverCommands = 0;
+
+// 对端是否应当优先成为主机：先比较优先级，相同时IP大的优先
+static bool peerOutranks() {
+    if (peerPriority != BRAIN_PRIORITY) {
+        return peerPriority > BRAIN_PRIORITY;
+    }
+    IPAddress localIP = WiFi.localIP();
+    for (uint8_t i = 0; i < 4; i++) {
+        if (peerIP[i] != localIP[i]) {
+            return peerIP[i] > localIP[i];
+        }
+    }
+    return false;
+}
+
+static void setRole(uint8_t role) {
+    brainRole = role;
+    roleSince = millis();
+}
+
+static void becomeStandby() {
+    // 在途和排队的命令交给主机处理，本机不再等待响应
+    resetCommandState();
+    for (int i = 0; i < TOTAL_FEEDERS; i++) {
+        peerPendingValid[i] = false;
+    }
+    setRole(BRAIN_ROLE_STANDBY);
+    LOG_WARN(PEER, "peer %u.%u.%u.%u is active, switched to standby",
+             peerIP[0], peerIP[1], peerIP[2], peerIP[3]);
+}
+
+// 备机：丢弃已超过超时时间的镜像在途命令（主机早已完成或放弃，接管时不能再等待它的响应）
+static void expirePeerPending(uint32_t now) {
+    for (int i = 0; i < TOTAL_FEEDERS; i++) {
+        if (peerPendingValid[i] &&
+            peerPending[i].elapsedMs + (now - peerPendingReceived[i]) >= peerPending[i].timeoutMs) {
+            peerPendingValid[i] = false;
+        }
+    }
+}
+
+// 主机失联：接管在途命令和所有Hand
+static void takeOver() {
+    uint32_t now = millis();
+    resetCommandState();
+
+    uint8_t adopted = 0;
+    for (int i = 0; i < TOTAL_FEEDERS; i++) {
+        if (!peerPendingValid[i]) {
+            continue;
+        }
+        PendingCommandInfo info = peerPending[i];
+        info.elapsedMs += now - peerPendingReceived[i];
+        if (connectedHands[i].isOnline && adoptPendingCommand(i, info)) {
+            adopted++;
+        }
+        peerPendingValid[i] = false;
+    }
+
+    if (peerNextSequence + PEER_SEQUENCE_GAP > getNextSequence()) {
+        setNextSequence(peerNextSequence + PEER_SEQUENCE_GAP);
+    }
+
+    lastTakeoverGapMs = now - lastPeerSeen;
+    lastTakeoverHands = announceBrainToHands();
+    lastTakeoverCommands = adopted;
+    takeoverCount++;
+    setRole(BRAIN_ROLE_ACTIVE);
+
+    LOG_WARN(PEER, "peer silent for %lums, took over %u hands and %u pending commands",
+             (unsigned long)lastTakeoverGapMs, lastTakeoverHands, adopted);
+}
+
+// 备机：把主机同步的条目写入本地注册表
+static void applyEntry(const UDPPeerFeederEntry& entry, uint32_t now) {
+    uint8_t id = entry.feederId;
+    if (id >= TOTAL_FEEDERS) {
+        return;
+    }
+
+    HandInfo& hand = connectedHands[id];
+    bool wasOnline = hand.isOnline;
+    if (entry.flags & PEER_FEEDER_ONLINE) {
+        // 同步条目只有IP，接管后先用UDP，Hand下次发来主通道包时再换回它使用的链路
+        hand.ip = IPAddress(entry.ip[0], entry.ip[1], entry.ip[2], entry.ip[3]);
+        hand.port = UDP_HAND_PORT;
+        hand.address = udpTransportAddress(hand.ip, UDP_HAND_PORT);
+        hand.lastSeen = now - (uint32_t)entry.lastSeenAgeS * 1000;
+        hand.isOnline = true;
+        hand.channel = entry.channel;
+        if (!wasOnline) {
+            notifyHandOnline(id);
+        }
+    } else if (wasOnline) {
+        hand.isOnline = false;
+        notifyHandOffline(id);
+    }
+
+    feederStatusArray[id].totalFeedCount = entry.totalFeedCount;
+    feederStatusArray[id].sessionFeedCount = entry.sessionFeedCount;
+
+    peerPendingValid[id] = (entry.flags & PEER_FEEDER_PENDING) != 0;
+    if (peerPendingValid[id]) {
+        peerPending[id].sequence = entry.pendingSequence;
+        peerPending[id].elapsedMs = entry.pendingElapsedMs;
+        peerPending[id].timeoutMs = entry.pendingTimeoutMs;
+        peerPending[id].commandType = entry.pendingCommandType;
+        peerPendingReceived[id] = now;
+    }
+}
+
+// 两台都是主机时保留主机角色的一方：登记对端知道而本机不知道的Hand，并让其改连本机
+static void mergeEntry(const UDPPeerFeederEntry& entry) {
+    uint8_t id = entry.feederId;
+    if (id >= TOTAL_FEEDERS || !(entry.flags & PEER_FEEDER_ONLINE) || connectedHands[id].isOnline) {
+        return;
+    }
+
+    IPAddress ip(entry.ip[0], entry.ip[1], entry.ip[2], entry.ip[3]);
+    updateHandInfo(id, udpTransportAddress(ip, UDP_HAND_PORT), "", entry.channel);
+    if (entry.channel == 0) {
+        sendDiscoveryResponse(ip, UDP_HAND_PORT, id);
+    }
+}
+
+static void handleSyncPacket(size_t length, IPAddress fromIP) {
+    if (length < sizeof(UDPPeerSyncHeader)) {
+        return;
+    }
+    const UDPPeerSyncHeader* header = (const UDPPeerSyncHeader*)peerBuffer;
+    uint8_t entryCount = header->entryCount;
+    if (length < sizeof(UDPPeerSyncHeader) + entryCount * sizeof(UDPPeerFeederEntry)) {
+        return;
+    }
+
+    uint32_t now = millis();
+    peerSeen = true;
+    peerIP = fromIP;
+    peerRole = header->role;
+    peerPriority = header->priority;
+    peerNextSequence = header->nextSequence;
+    lastPeerSeen = now;
+    syncReceived++;
+
+    switch (brainRole) {
+        case BRAIN_ROLE_STARTUP:
+            // 已有主机，或对端同样在启动但优先级更高
+            if (peerRole == BRAIN_ROLE_ACTIVE || (peerRole == BRAIN_ROLE_STARTUP && peerOutranks())) {
+                becomeStandby();
+            }
+            break;
+
+        case BRAIN_ROLE_ACTIVE:
+            if (peerRole == BRAIN_ROLE_ACTIVE && peerOutranks()) {
+                becomeStandby();
+            }
+            break;
+
+        case BRAIN_ROLE_STANDBY:
+            // 两台都是备机（对端刚退为备机）时由优先级高的一方接管
+            if (peerRole == BRAIN_ROLE_STANDBY && !peerOutranks()) {
+                takeOver();
+                return;
+            }
+            break;
+    }
+
+    const UDPPeerFeederEntry* entries = (const UDPPeerFeederEntry*)(peerBuffer + sizeof(UDPPeerSyncHeader));
+    if (peerRole != BRAIN_ROLE_ACTIVE) {
+        return;
+    }
+    for (uint8_t i = 0; i < entryCount; i++) {
+        if (brainRole == BRAIN_ROLE_STANDBY) {
+            applyEntry(entries[i], now);
+        } else if (brainRole == BRAIN_ROLE_ACTIVE) {
+            mergeEntry(entries[i]);
+        }
+    }
+}
+
+static void receivePeerPackets() {
+    int packetSize;
+    while ((packetSize = peerUdp.parsePacket()) > 0) {
+        IPAddress fromIP = peerUdp.remoteIP();
+        size_t length = peerUdp.read(peerBuffer, sizeof(peerBuffer));
+        if (fromIP == WiFi.localIP()) {
+            continue;                       // 自己发出的广播
+        }
+        if (length > 0 && peerBuffer[0] == UDP_PKT_PEER_SYNC) {
+            handleSyncPacket(length, fromIP);
+        }
+    }
+}
+
+static void fillEntry(UDPPeerFeederEntry& entry, uint8_t id, uint32_t now) {
+    const HandInfo& hand = connectedHands[id];
+    memset(&entry, 0, sizeof(entry));
+    entry.feederId = id;
+    entry.channel = hand.channel;
+    if (hand.isOnline) {
+        entry.flags |= PEER_FEEDER_ONLINE;
+        for (uint8_t i = 0; i < 4; i++) {
+            entry.ip[i] = hand.ip[i];
+        }
+        uint32_t ageS = (now - hand.lastSeen) / 1000;
+        entry.lastSeenAgeS = ageS > 0xFFFF ? 0xFFFF : ageS;
+    }
+    entry.totalFeedCount = feederStatusArray[id].totalFeedCount;
+    entry.sessionFeedCount = feederStatusArray[id].sessionFeedCount;
+
+    PendingCommandInfo pending;
+    if (getPendingCommand(id, pending)) {
+        entry.flags |= PEER_FEEDER_PENDING;
+        entry.pendingSequence = pending.sequence;
+        entry.pendingElapsedMs = pending.elapsedMs > 0xFFFF ? 0xFFFF : pending.elapsedMs;
+        entry.pendingTimeoutMs = pending.timeoutMs > 0xFFFF ? 0xFFFF : pending.timeoutMs;
+        entry.pendingCommandType = pending.commandType;
+    }
+}
+
+// 主机：先放有在途命令的Feeder（状态变化快），剩余位置轮流同步全部Feeder
+// （包括前面没放下的在途Feeder，否则在途数超过一半时部分Feeder永远不会同步）
+// 备机和启动中只发包头，作为心跳
+static void sendSyncPacket() {
+    uint32_t now = millis();
+    UDPPeerSyncHeader* header = (UDPPeerSyncHeader*)peerBuffer;
+    UDPPeerFeederEntry* entries = (UDPPeerFeederEntry*)(peerBuffer + sizeof(UDPPeerSyncHeader));
+    uint8_t count = 0;
+
+    if (brainRole == BRAIN_ROLE_ACTIVE) {
+        bool included[TOTAL_FEEDERS] = {false};
+        for (int i = 0; i < TOTAL_FEEDERS && count < UDP_PEER_MAX_ENTRIES / 2; i++) {
+            if (feederStatusArray[i].waitingForResponse) {
+                fillEntry(entries[count++], i, now);
+                included[i] = true;
+            }
+        }
+        for (int i = 0; i < TOTAL_FEEDERS && count < UDP_PEER_MAX_ENTRIES; i++) {
+            uint8_t id = syncCursor;
+            syncCursor = (syncCursor + 1) % TOTAL_FEEDERS;
+            if (!included[id]) {
+                fillEntry(entries[count++], id, now);
+            }
+        }
+    }
+
+    header->packetType = UDP_PKT_PEER_SYNC;
+    header->role = brainRole;
+    header->priority = BRAIN_PRIORITY;
+    header->entryCount = count;
+    header->nextSequence = getNextSequence();
+
+    peerUdp.beginPacket(WiFi.broadcastIP(), UDP_PEER_PORT);
+    peerUdp.write(peerBuffer, sizeof(UDPPeerSyncHeader) + count * sizeof(UDPPeerFeederEntry));
+    if (peerUdp.endPacket()) {
+        syncSent++;
+    }
+}
+
+void brain_peer_setup() {
+    for (int i = 0; i < TOTAL_FEEDERS; i++) {
+        peerPendingValid[i] = false;
+    }
+    if (peerUdp.begin(UDP_PEER_PORT)) {
+        DEBUG_PRINTF("Brain Peer: 监听端口 %d，优先级 %d\n", UDP_PEER_PORT, BRAIN_PRIORITY);
+    } else {
+        DEBUG_PRINTLN("Brain Peer: 端口初始化失败");
+    }
+    setRole(BRAIN_ROLE_STARTUP);
+}
+
+void brain_peer_update() {
+    receivePeerPackets();
+
+    uint32_t now = millis();
+    switch (brainRole) {
+        case BRAIN_ROLE_STARTUP:
+            // 等待一个超时周期没有听到主机，自己成为主机
+            if (now - roleSince > BRAIN_PEER_TIMEOUT_MS) {
+                setRole(BRAIN_ROLE_ACTIVE);
+                LOG_INFO(PEER, "no active peer, running as active brain");
+            }
+            break;
+
+        case BRAIN_ROLE_STANDBY:
+            expirePeerPending(now);
+            if (now - lastPeerSeen > BRAIN_PEER_TIMEOUT_MS) {
+                takeOver();
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    if (now - lastSyncSent >= BRAIN_PEER_SYNC_INTERVAL_MS) {
+        sendSyncPacket();
+        lastSyncSent = now;
+    }
+}
+
+bool isBrainActive() {
+    return brainRole == BRAIN_ROLE_ACTIVE;
+}
+
+BrainRole getBrainRole() {
+    return (BrainRole)brainRole;
+}
+
+void getBrainPeerStatusJSON(String& result) {
+    DynamicJsonDocument doc(JSON_OBJECT_SIZE(10) + JSON_OBJECT_SIZE(5) + 128);
+    uint32_t now = millis();
+
+    doc["enabled"] = true;
+    doc["role"] = roleName(brainRole);
+    doc["roleForMs"] = now - roleSince;
+    doc["priority"] = BRAIN_PRIORITY;
+    doc["syncSent"] = syncSent;
+    doc["syncReceived"] = syncReceived;
+    doc["takeovers"] = takeoverCount;
+    if (takeoverCount > 0) {
+        doc["lastTakeoverGapMs"] = lastTakeoverGapMs;
+        doc["lastTakeoverHands"] = lastTakeoverHands;
+        doc["lastTakeoverCommands"] = lastTakeoverCommands;
+    }
+
+    if (peerSeen) {
+        JsonObject peer = doc.createNestedObject("peer");
+        peer["ip"] = peerIP.toString();
+        peer["role"] = roleName(peerRole);
+        peer["priority"] = peerPriority;
+        peer["lastSeenMs"] = now - lastPeerSeen;
+        peer["nextSequence"] = peerNextSequence;
+    }
+
+    serializeJson(doc, result);
+}
+
+#else // BRAIN_STANDBY_ENABLED
+
+void brain_peer_setup() {
+}
+
+void brain_peer_update() {
+}
+
+bool isBrainActive() {
+    return true;
+}
+
+BrainRole getBrainRole() {
+    return BRAIN_ROLE_ACTIVE;
+}
+
+void getBrainPeerStatusJSON(String& result) {
+    DynamicJsonDocument doc(JSON_OBJECT_SIZE(2));
+    doc["enabled"] = false;
+    doc["role"] = roleName(BRAIN_ROLE_ACTIVE);
+    serializeJson(doc, result);
+}
+
+#endif // BRAIN_STANDBY_ENABLED
@@ -0,0 +1,30 @@
+#ifndef BRAIN_PEER_H
+#define BRAIN_PEER_H
+
+#include <Arduino.h>
+#include "brain_config.h"
+#include "common/udp_protocol.h"
+
+// =============================================================================
+// 主备Brain - 两台Brain在同一网络中，主机每BRAIN_PEER_SYNC_INTERVAL_MS广播一次
+// Hand注册表、送料计数和在途命令，备机镜像这些状态；主机超过BRAIN_PEER_TIMEOUT_MS
+// 没有消息时备机接管：继续等待在途命令的响应，并向所有Hand发送发现响应使其改连本机
+//
+// 接管后OpenPnP需要重新连接到新主机的IP（不做IP漂移）
+// BRAIN_STANDBY_ENABLED为0时始终为主机，不收发同步包
+// =============================================================================
+
+void brain_peer_setup();
+
+// 在主循环中调用：接收对端同步包、判断角色、定时发送同步包
+void brain_peer_update();
+
+// 本机是否为主机（只有主机服务G-code和控制Hand），可在任意任务中调用
+bool isBrainActive();
+
+BrainRole getBrainRole();
+
+// 获取主备状态JSON（/api/peer）
+void getBrainPeerStatusJSON(String& result);
+
+#endif // BRAIN_PEER_H
@@ -0,0 +1,59 @@
+#include "brain_record.h"
+#include <ArduinoJson.h>
+
+static TrafficRecordRing<TRAFFIC_RECORD_BYTES> trafficRing;
+static bool recording = TRAFFIC_RECORD_DEFAULT;
+
+void setTrafficRecording(bool enabled) {
+    recording = enabled;
+    DEBUG_PRINTF("Traffic recording %s\n", enabled ? "started" : "stopped");
+}
+
+bool isTrafficRecording() {
+    return recording;
+}
+
+void recordTcpLine(const char* line, size_t length, uint32_t timeUs) {
+    if (!recording) {
+        return;
+    }
+    trafficRing.record(TRAFFIC_TCP_LINE, timeUs, nullptr, (const uint8_t*)line, (uint16_t)length);
+}
+
+void recordUdpPacket(uint8_t source, IPAddress remoteIP, const uint8_t* data, size_t length, uint32_t timeUs) {
+    if (!recording) {
+        return;
+    }
+    uint8_t ip[4] = {remoteIP[0], remoteIP[1], remoteIP[2], remoteIP[3]};
+    trafficRing.record(source, timeUs, ip, data, (uint16_t)length);
+}
+
+size_t writeTrafficRecording(Print& out) {
+    TrafficFileHeader header;
+    trafficRing.exportHeader(header);
+    size_t written = out.write((const uint8_t*)&header, sizeof(header));
+
+    // 分块复制，避免为整个缓冲区再分配一份内存
+    uint8_t chunk[256];
+    size_t offset = 0;
+    size_t n;
+    while ((n = trafficRing.readBytes(offset, chunk, sizeof(chunk))) > 0) {
+        written += out.write(chunk, n);
+        offset += n;
+    }
+    return written;
+}
+
+void getTrafficRecordStatusJSON(String& result) {
+    DynamicJsonDocument doc(256);
+    doc["recording"] = recording;
+    doc["records"] = trafficRing.size();
+    doc["dropped"] = trafficRing.droppedCount();
+    doc["bytesUsed"] = trafficRing.bytesUsed();
+    doc["capacity"] = trafficRing.capacity();
+    serializeJson(doc, result);
+}
+
+void clearTrafficRecording() {
+    trafficRing.clear();
+}
@@ -0,0 +1,32 @@
+#ifndef BRAIN_RECORD_H
+#define BRAIN_RECORD_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "brain_config.h"
+#include "common/traffic_record.h"
+
+// =============================================================================
+// Brain端通信录制（调试用，默认关闭）
+// =============================================================================
+
+// 开始/停止录制
+void setTrafficRecording(bool enabled);
+bool isTrafficRecording();
+
+// tcp_loop收到完整G-code行
+void recordTcpLine(const char* line, size_t length, uint32_t timeUs);
+
+// processBrainUDPData收到UDP包
+void recordUdpPacket(uint8_t source, IPAddress remoteIP, const uint8_t* data, size_t length, uint32_t timeUs);
+
+// 导出录制文件（TrafficFileHeader + 记录），写入任意Print（如AsyncResponseStream）
+size_t writeTrafficRecording(Print& out);
+
+// 录制状态JSON
+void getTrafficRecordStatusJSON(String& result);
+
+// 清空录制
+void clearTrafficRecording();
+
+#endif // BRAIN_RECORD_H
@@ -1,111 +1,179 @@
 #include "brain_tcp.h"
+#include "brain_config.h"
 #include "gcode.h"
 #include "lcd.h"
-#include <WiFi.h>
+#include "brain_log.h"
+#include "brain_peer.h"
+#include <AsyncTCP.h>
 
-WiFiServer server(8080);
-WiFiClient currentClient;  // 保存当前活动的客户端
-String tcpBuffer = "";
+// G-code TCP服务器：AsyncTCP在自己的任务中回调，收到的数据在回调里拼成完整行，
+// 通过G-code行队列交给主循环执行processCommand（UDP、LCD等都只在主循环中访问）
+static AsyncServer tcpServer(TCP_GCODE_PORT);
+static AsyncClient* tcpClient = nullptr;     // 当前活动的客户端，只允许一个
+static SemaphoreHandle_t tcpClientMutex = nullptr; // 保护tcpClient和暂存区，避免发送时被回调释放
 
-// 外部全局变量，用于与gcode.cpp通信
-extern String inputBuffer;
+// 发送缓冲区放不下的回复暂存在这里，按顺序在onAck/onPoll中继续发送（受tcpClientMutex保护）
+static char tcpPending[TCP_PENDING_BUFFER_SIZE];
+static size_t tcpPendingLength = 0;
+
+static void replyTcpBusy(const char* data, size_t length) {
+    tcpSend(data, length);
+    LOG_WARN(TCP, "行队列已满，回复busy");
+}
+
+static GcodeLineReceiver tcpReceiver(GCODE_SOURCE_TCP, queueGcodeLine, replyTcpBusy);
+
+// 连接状态变化由回调记录，在主循环中通知LCD
+static volatile bool tcpConnectedFlag = false;
+static volatile bool tcpStateChanged = false;
+
+static void onTcpData(void* arg, AsyncClient* client, void* data, size_t len) {
+    tcpReceiver.receive((const char*)data, len, micros());
+}
+
+// 写入发送缓冲区能放下的部分，返回写入的字节数（调用者持有tcpClientMutex并在之后调用send）
+static size_t writeToClient(const char* data, size_t length) {
+    size_t space = tcpClient->space();
+    size_t count = length < space ? length : space;
+    if (count > 0) {
+        // 复制到发送缓冲区，由调用者统一send()，不等待对端确认
+        tcpClient->add(data, count, ASYNC_WRITE_FLAG_COPY);
+    }
+    return count;
+}
+
+// 继续发送暂存的回复（调用者持有tcpClientMutex）
+static void flushPending() {
+    if (tcpPendingLength == 0 || !tcpClient || !tcpClient->connected()) {
+        return;
+    }
+    size_t written = writeToClient(tcpPending, tcpPendingLength);
+    if (written > 0) {
+        tcpClient->send();
+    }
+    tcpPendingLength -= written;
+    memmove(tcpPending, tcpPending + written, tcpPendingLength);
+}
+
+// 对端确认后发送缓冲区有了空间
+static void onTcpAck(void* arg, AsyncClient* client, size_t len, uint32_t time) {
+    xSemaphoreTake(tcpClientMutex, portMAX_DELAY);
+    if (client == tcpClient) {
+        flushPending();
+    }
+    xSemaphoreGive(tcpClientMutex);
+}
+
+// 定期轮询，防止确认先于暂存到达时回复卡在暂存区
+static void onTcpPoll(void* arg, AsyncClient* client) {
+    onTcpAck(arg, client, 0, 0);
+}
+
+static void onTcpDisconnect(void* arg, AsyncClient* client) {
+    xSemaphoreTake(tcpClientMutex, portMAX_DELAY);
+    if (client == tcpClient) {
+        tcpClient = nullptr;
+        tcpPendingLength = 0;
+        tcpConnectedFlag = false;
+        tcpStateChanged = true;
+    }
+    xSemaphoreGive(tcpClientMutex);
+    delete client;
+}
+
+static void onTcpClient(void* arg, AsyncClient* client) {
+    xSemaphoreTake(tcpClientMutex, portMAX_DELAY);
+    bool busy = tcpClient != nullptr && tcpClient->connected();
+    bool accept = !busy && isBrainActive();
+    if (accept) {
+        tcpClient = client;
+        tcpPendingLength = 0;
+    }
+    xSemaphoreGive(tcpClientMutex);
+
+    if (!accept) {
+        // 如果已有客户端连接，或本机是备机，拒绝新连接
+        client->onDisconnect([](void* arg, AsyncClient* c) { delete c; });
+        client->close(true);
+        return;
+    }
+
+    tcpReceiver.reset();
+    client->setNoDelay(true);           // 关闭Nagle，短回复立即发出
+    client->onData(onTcpData);
+    client->onDisconnect(onTcpDisconnect);
+    client->onAck(onTcpAck);
+    client->onPoll(onTcpPoll);
+    tcpConnectedFlag = true;
+    tcpStateChanged = true;
+
+    // 发送欢迎消息
+    tcpSendLine("ok connected to Brain TCP Server");
+}
 
 void tcp_setup() {
-    server.begin();
-    Serial.println("TCP Server started on port 8080");
-    Serial.print("Server listening on IP: ");
-    Serial.println(WiFi.localIP());
+    tcpClientMutex = xSemaphoreCreateMutex();
+    tcpServer.onClient(onTcpClient, nullptr);
+    tcpServer.setNoDelay(true);
+    tcpServer.begin();
+    Serial.printf("TCP Server started on port %d\n", TCP_GCODE_PORT);
 }
 
 void tcp_loop() {
-    // 检查是否有新的客户端连接
-    if (server.hasClient()) {
-        // 如果当前没有客户端或客户端已断开，接受新连接
-        if (!currentClient || !currentClient.connected()) {
-            currentClient = server.available();
-            Serial.println("New Client Connected");
-            Serial.print("Client IP: ");
-            Serial.println(currentClient.remoteIP());
-            
-            // 发送欢迎消息
-            currentClient.println("ok connected to Brain TCP Server");
-            currentClient.flush();
-            
-            // 通知LCD更新TCP连接状态
-            lcd_update_tcp_status(true);
-            Serial.println("LCD notified: TCP client connected");
-        } else {
-            // 如果已有客户端连接，拒绝新连接
-            WiFiClient newClient = server.available();
-            newClient.stop();
-            Serial.println("Additional client rejected - existing client still connected");
-        }
+    // 连接状态变化时通知LCD
+    if (tcpStateChanged) {
+        tcpStateChanged = false;
+        bool connected = tcpConnectedFlag;
+        LOG_INFO(TCP, connected ? "New Client Connected" : "Client Disconnected");
+        lcd_update_tcp_status(connected);
     }
+}
 
-    // 处理当前客户端的数据
-    if (currentClient && currentClient.connected()) {
-        if (currentClient.available()) {
-            while (currentClient.available()) {
-                char c = currentClient.read();
-                if (c == '\n') {
-                    tcpBuffer.trim();
-                    if (tcpBuffer.length() > 0) {
-                        // 设置全局inputBuffer供processCommand使用
-                        String backupBuffer = inputBuffer;
-                        inputBuffer = tcpBuffer;
-                        
-                        Serial.print("Received TCP command: ");
-                        Serial.println(inputBuffer);
-
-                        // 处理命令
-                        processCommand();
-                        
-                        // 恢复原始buffer
-                        inputBuffer = backupBuffer;
-                        // currentClient.println("Command processed: " + tcpBuffer);
-                    }
-                    tcpBuffer = "";
-                } else if (c != '\r') {
-                    tcpBuffer += c;
-                }
-            }
+bool tcpSendParts(const char* const* parts, const size_t* lengths, size_t count) {
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++) {
+        length += lengths[i];
+    }
+
+    bool sent = false;
+    xSemaphoreTake(tcpClientMutex, portMAX_DELAY);
+    if (tcpClient && tcpClient->connected()) {
+        flushPending();
+        // 有暂存内容时必须排在其后，保证回复顺序
+        size_t direct = tcpPendingLength == 0 ? tcpClient->space() : 0;
+        if (direct > length) {
+            direct = length;
         }
-    } else {
-        // 添加调试信息
-        if (currentClient) {
-            Serial.println("TCP客户端已断开连接");
+        // 整条回复要么全部发出/暂存，要么全部丢弃，不发送半条。检查和写入在同一次持锁内完成，
+        // 其他任务的回复不会插在各部分之间
+        if (length - direct <= sizeof(tcpPending) - tcpPendingLength) {
+            for (size_t i = 0; i < count; i++) {
+                size_t written = writeToClient(parts[i], lengths[i] < direct ? lengths[i] : direct);
+                direct -= written;
+                memcpy(tcpPending + tcpPendingLength, parts[i] + written, lengths[i] - written);
+                tcpPendingLength += lengths[i] - written;
+            }
+            // 各部分在发送缓冲区中合并，一次发出
+            tcpClient->send();
+            sent = true;
         }
     }
-    
-    // 检查客户端是否断开
-    if (currentClient && !currentClient.connected()) {
-        Serial.println("Client Disconnected");
-        currentClient.stop();
-        currentClient = WiFiClient(); // 重置客户端
-        
-        // 通知LCD更新TCP连接状态
-        lcd_update_tcp_status(false);
-        Serial.println("LCD notified: TCP client disconnected");
-    }
+    xSemaphoreGive(tcpClientMutex);
+
+    return sent;
 }
 
-// 获取当前TCP客户端的函数
-WiFiClient* getCurrentTcpClient() {
-    if (currentClient && currentClient.connected()) {
-        return &currentClient;
-    }
-    
-    // 调试信息
-    if (!currentClient) {
-        Serial.println("getCurrentTcpClient: currentClient为空");
-    } else if (!currentClient.connected()) {
-        Serial.println("getCurrentTcpClient: currentClient未连接");
-    }
-    
-    return nullptr;
+bool tcpSend(const char* data, size_t length) {
+    return tcpSendParts(&data, &length, 1);
+}
+
+bool tcpSendLine(const char* line) {
+    const char* parts[] = {line, "\r\n"};
+    const size_t lengths[] = {strlen(line), 2};
+    return tcpSendParts(parts, lengths, 2);
 }
 
 // 检查TCP客户端是否连接
 bool isTcpClientConnected() {
-    return currentClient && currentClient.connected();
-}
\ No newline at end of file
+    return tcpConnectedFlag;
+}
@@ -1,12 +1,13 @@
 #ifndef BRAIN_TCP_H
 #define BRAIN_TCP_H
 
-#include <WiFi.h>
-#include <WiFiServer.h>
+#include <Arduino.h>
 
 void tcp_setup();
-void tcp_loop();
-WiFiClient* getCurrentTcpClient(); // 获取当前TCP客户端
-bool isTcpClientConnected();       // 检查TCP客户端是否连接
+void tcp_loop();                    // 在主循环中处理连接状态变化（收到的G-code行由processGcodeLines处理）
+bool isTcpClientConnected();        // 检查TCP客户端是否连接
+bool tcpSend(const char* data, size_t length); // 非阻塞发送，发送缓冲区不足的部分暂存后续发；未连接或暂存区也放不下时返回false
+bool tcpSendLine(const char* line); // 非阻塞发送一行回复（自动追加\r\n）
+bool tcpSendParts(const char* const* parts, const size_t* lengths, size_t count); // 把几段内容作为一条回复整体发送或暂存，不拼接
 
-#endif // BRAIN_TCP_H
\ No newline at end of file
+#endif // BRAIN_TCP_H
@@ -0,0 +1,137 @@
+#include "brain_trace.h"
+#include <ArduinoJson.h>
+
+// Chrome trace中的进程ID
+#define TRACE_PID_BRAIN 1
+#define TRACE_PID_HAND  2
+
+static FeedTraceRing<FEED_TRACE_DEPTH> brainTrace;
+
+// 当前正在处理的G-code行，由dispatchCommandToHand取走随命令排队，发送时再写入环形缓冲区
+static GcodeLineTrace currentLine = {false, false, 0, 0, 0, 0};
+
+// sendAnswer回复耗时汇总
+struct AnswerStats {
+    uint32_t count;
+    uint32_t totalUs;
+    uint32_t maxUs;
+};
+
+static AnswerStats answerStats = {0, 0, 0};
+
+void traceLineReceived(uint32_t rxStartUs, uint32_t rxEndUs) {
+    currentLine.hasLine = true;
+    currentLine.hasParse = false;
+    currentLine.rxStartUs = rxStartUs;
+    currentLine.rxEndUs = rxEndUs;
+}
+
+void traceParseDone(uint32_t parseStartUs, uint32_t parseEndUs) {
+    currentLine.hasParse = true;
+    currentLine.parseStartUs = parseStartUs;
+    currentLine.parseEndUs = parseEndUs;
+}
+
+void clearLineTrace() {
+    currentLine.hasLine = false;
+    currentLine.hasParse = false;
+}
+
+void takeLineTrace(GcodeLineTrace& line) {
+    line = currentLine;
+    clearLineTrace();
+}
+
+void traceCommandSent(uint8_t feederId, uint32_t sequence, uint32_t sendStartUs, uint32_t sendEndUs,
+                      const GcodeLineTrace* lines, uint8_t lineCount) {
+    for (uint8_t i = 0; i < lineCount; i++) {
+        if (lines[i].hasLine) {
+            brainTrace.record(TRACE_GCODE_RECEIVED, feederId, sequence, lines[i].rxStartUs, lines[i].rxEndUs);
+        }
+        if (lines[i].hasParse) {
+            brainTrace.record(TRACE_GCODE_PARSE, feederId, sequence, lines[i].parseStartUs, lines[i].parseEndUs);
+        }
+    }
+
+    brainTrace.record(TRACE_SEND_TO_HAND, feederId, sequence, sendStartUs, sendEndUs);
+}
+
+void traceHandResponse(uint8_t feederId, uint32_t sequence, const UDPHandTiming& timing, uint32_t arrivalUs) {
+    // 旧固件的响应不带timing，偏移量全为0，重建出的是长度为0的假区间，不记录
+    if (!hasHandTiming(timing)) {
+        return;
+    }
+
+    // Hand时钟与Brain不同步，单程网络延迟计入response_send区间
+    uint32_t receiveUs = arrivalUs - timing.receiveOffsetUs;
+    uint32_t servoStartUs = arrivalUs - timing.servoStartOffsetUs;
+    uint32_t servoEndUs = arrivalUs - timing.servoEndOffsetUs;
+
+    brainTrace.record(TRACE_HAND_RECEIVE, feederId, sequence, receiveUs, servoStartUs);
+    brainTrace.record(TRACE_SERVO_MOTION, feederId, sequence, servoStartUs, servoEndUs);
+    brainTrace.record(TRACE_RESPONSE_SEND, feederId, sequence, servoEndUs, arrivalUs);
+}
+
+void traceTcpReply(uint8_t feederId, uint32_t sequence, uint32_t startUs, uint32_t endUs) {
+    brainTrace.record(TRACE_TCP_REPLY, feederId, sequence, startUs, endUs);
+}
+
+void traceAnswer(uint32_t startUs, uint32_t endUs) {
+    uint32_t durationUs = endUs - startUs;
+    answerStats.count++;
+    answerStats.totalUs += durationUs;
+    if (durationUs > answerStats.maxUs) {
+        answerStats.maxUs = durationUs;
+    }
+}
+
+static void addProcessName(JsonArray& events, int pid, const char* name) {
+    JsonObject meta = events.createNestedObject();
+    meta["name"] = "process_name";
+    meta["ph"] = "M";
+    meta["pid"] = pid;
+    meta["args"]["name"] = name;
+}
+
+void getFeedTraceJSON(String& result) {
+    size_t spanCount = brainTrace.size();
+    const size_t capacity = JSON_OBJECT_SIZE(3) + JSON_ARRAY_SIZE(FEED_TRACE_DEPTH + 2)
+                          + 2 * (JSON_OBJECT_SIZE(4) + JSON_OBJECT_SIZE(1))
+                          + FEED_TRACE_DEPTH * (JSON_OBJECT_SIZE(8) + JSON_OBJECT_SIZE(1))
+                          + JSON_OBJECT_SIZE(3) + 64;
+    DynamicJsonDocument doc(capacity);
+    JsonArray events = doc.createNestedArray("traceEvents");
+
+    addProcessName(events, TRACE_PID_BRAIN, "Brain");
+    addProcessName(events, TRACE_PID_HAND, "Hand");
+
+    for (size_t i = 0; i < spanCount; i++) {
+        const FeedTraceSpan& span = brainTrace.at(i);
+        bool handStage = span.stage >= TRACE_HAND_RECEIVE && span.stage <= TRACE_RESPONSE_SEND;
+
+        JsonObject event = events.createNestedObject();
+        event["name"] = getFeedTraceStageName(span.stage);
+        event["cat"] = handStage ? "hand" : "brain";
+        event["ph"] = "X";
+        event["ts"] = span.startUs;
+        event["dur"] = span.durationUs;
+        event["pid"] = handStage ? TRACE_PID_HAND : TRACE_PID_BRAIN;
+        event["tid"] = span.feederId;
+        event["args"]["seq"] = span.sequence;
+    }
+
+    // otherData会显示在Perfetto的metadata中
+    JsonObject answers = doc.createNestedObject("otherData");
+    answers["answerCount"] = answerStats.count;
+    answers["answerAvgUs"] = answerStats.count ? answerStats.totalUs / answerStats.count : 0;
+    answers["answerMaxUs"] = answerStats.maxUs;
+
+    doc["displayTimeUnit"] = "ms";
+    serializeJson(doc, result);
+}
+
+void clearFeedTrace() {
+    brainTrace.clear();
+    memset(&answerStats, 0, sizeof(answerStats));
+    clearLineTrace();
+}
@@ -0,0 +1,53 @@
+#ifndef BRAIN_TRACE_H
+#define BRAIN_TRACE_H
+
+#include <Arduino.h>
+#include "brain_config.h"
+#include "common/feed_trace.h"
+
+// =============================================================================
+// Brain端送料链路追踪
+// =============================================================================
+
+// 一行G-code的接收/解析区间，随命令排队，发送时才知道序列号
+struct GcodeLineTrace {
+    bool hasLine;
+    bool hasParse;
+    uint32_t rxStartUs;
+    uint32_t rxEndUs;
+    uint32_t parseStartUs;
+    uint32_t parseEndUs;
+};
+
+// tcp_loop收到完整G-code行（从第一个字节到换行符）
+void traceLineReceived(uint32_t rxStartUs, uint32_t rxEndUs);
+
+// processCommand完成参数解析
+void traceParseDone(uint32_t parseStartUs, uint32_t parseEndUs);
+
+// 开始处理新的一行，丢弃上一行未关联到命令的记录（如非M600指令、串口行）
+void clearLineTrace();
+
+// 取出当前行的接收/解析区间（dispatchCommandToHand调用，随命令保存）
+void takeLineTrace(GcodeLineTrace& line);
+
+// 命令发送完成，把随命令保存的每一行的接收/解析区间关联到该序列号（合并的送料命令有多行）
+void traceCommandSent(uint8_t feederId, uint32_t sequence, uint32_t sendStartUs, uint32_t sendEndUs,
+                      const GcodeLineTrace* lines, uint8_t lineCount);
+
+// 收到Hand响应，根据Hand回传的偏移量重建Hand端区间（以响应到达时刻对齐），不带timing的响应不记录
+void traceHandResponse(uint8_t feederId, uint32_t sequence, const UDPHandTiming& timing, uint32_t arrivalUs);
+
+// handleHandResponse回复TCP客户端
+void traceTcpReply(uint8_t feederId, uint32_t sequence, uint32_t startUs, uint32_t endUs);
+
+// sendAnswer回复耗时（格式化+串口+TCP），只做汇总统计，随trace一起导出
+void traceAnswer(uint32_t startUs, uint32_t endUs);
+
+// 导出Chrome/Perfetto trace JSON
+void getFeedTraceJSON(String& result);
+
+// 清空追踪记录
+void clearFeedTrace();
+
+#endif // BRAIN_TRACE_H
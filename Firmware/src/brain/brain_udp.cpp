@@ -1,6 +1,17 @@
 #include "brain_udp.h"
 #include "gcode.h"
 #include "brain_tcp.h"  // 添加TCP支持
+#include "brain_trace.h"
+#include "brain_record.h"
+#include "brain_peer.h"
+#include "brain_health.h"
+#include "link_estimator.h"
+#include "pending_command.h"
+#include "gcode_reply.h"
+#if BRAIN_ESPNOW_ENABLED
+#include "common/espnow_transport.h"
+#endif
+#include <ArduinoJson.h>
 
 // =============================================================================
 // 全局变量
@@ -14,6 +25,15 @@ UDPStats brainUdpStats = {0};
 WiFiUDP udp;
 WiFiUDP discoveryUdp;
 
+// 命令通道传输，按链路类型索引
+static UdpTransport udpTransport(udp, UDP_BRAIN_PORT);
+#if BRAIN_ESPNOW_ENABLED
+static EspNowTransport espNowTransport;
+Transport* brainTransports[TRANSPORT_TYPE_COUNT] = {&udpTransport, &espNowTransport};
+#else
+Transport* brainTransports[TRANSPORT_TYPE_COUNT] = {&udpTransport, nullptr};
+#endif
+
 // 时间戳变量
 uint32_t lastHeartbeatTime = 0;
 uint32_t lastHandCheckTime = 0;
@@ -22,18 +42,81 @@ uint32_t lastHandCheckTime = 0;
 uint8_t brainUdpBuffer[UDP_BUFFER_SIZE];
 
 // 命令响应等待映射
-struct PendingCommand {
-    uint32_t sequence;
-    uint8_t feederId;
-    uint32_t sentTime;
+PendingCommand pendingCommands[MAX_PENDING_COMMANDS]; // 每个Feeder同一时间最多一条在途命令
+uint32_t nextSequence = 1;
+
+// 每个Feeder的命令队列：Hand忙碌时命令在此排队，保证同一Hand不会收到重叠的动作
+struct QueuedCommand {
+    ESPNowPacket command;
     uint32_t timeoutMs;
-    bool waiting;
-    bool needTcpReply;    // 是否需要TCP回复
-    uint8_t commandType;  // 命令类型，用于生成回复消息
+    bool needTcpReply;
+    uint8_t lineCount;    // 合并的G-code行数（送料命令可合并，见dispatchCommandToHand）
+    GcodeLineTrace lines[FEED_TRACE_LINES_PER_COMMAND]; // 各行的接收/解析区间，发送时写入追踪记录
 };
 
-PendingCommand pendingCommands[10]; // 最多同时等待10个命令响应
-uint32_t nextSequence = 1;
+struct FeederCommandQueue {
+    QueuedCommand items[FEEDER_QUEUE_DEPTH];
+    uint8_t head;
+    uint8_t count;
+};
+
+FeederCommandQueue feederQueues[TOTAL_FEEDERS];
+
+// 每个Feeder的往返时间和送料耗时估计；确认过命令的Hand才按往返时间重发（旧固件不回复确认）
+static RttEstimator handRtt[TOTAL_FEEDERS];
+static ActuationModel feederActuation[TOTAL_FEEDERS];
+static bool handAcks[TOTAL_FEEDERS];
+
+// 合并到排队送料命令中的G-code行数
+static uint32_t coalescedCommands = 0;
+
+// 重发用完仍未确认、等到超时才判定失败的命令数（与Hand确认后未按时完成的超时分开统计）
+static uint32_t noAckFailures = 0;
+
+// Feeder状态缓存（M621）：最近一次收到该Feeder的包的时间（lastSeen在Brain发送心跳时也会更新，不能表示新鲜度）
+// 和最近一次送料结果；状态过旧时由getFeederState请求探测
+static uint32_t feederHeardMs[TOTAL_FEEDERS];
+static uint8_t feederLastStatus[TOTAL_FEEDERS];
+static uint8_t feederLastReason[TOTAL_FEEDERS];
+static bool stateProbeRequested[TOTAL_FEEDERS];
+static uint32_t lastStateProbeMs[TOTAL_FEEDERS];
+static uint8_t stateProbeCount = 0;     // 已请求、还未处理的探测数
+static uint32_t stateProbesSent = 0;
+
+// Hand上报的通道数量（旧固件为0，按单通道处理），并限制在ID范围内
+static uint8_t handFeederCount(uint8_t baseId, uint8_t reportedCount) {
+    uint8_t count = reportedCount > 0 ? reportedCount : 1;
+    if (baseId < TOTAL_FEEDERS && baseId + count > TOTAL_FEEDERS) {
+        count = TOTAL_FEEDERS - baseId;
+    }
+    return count;
+}
+
+// 经address所属的链路发送，该链路未开启时返回false
+static bool sendToAddress(const TransportAddress& address, const uint8_t* data, size_t length) {
+    Transport* transport = address.type < TRANSPORT_TYPE_COUNT ? brainTransports[address.type] : nullptr;
+    return transport != nullptr && transport->send(address, data, length);
+}
+
+// 记录Hand的命令通道地址：UDP的命令固定发往Hand主端口
+static void setHandAddress(HandInfo& hand, const TransportAddress& from) {
+    if (from.type == TRANSPORT_UDP) {
+        hand.ip = transportAddressIP(from);
+        hand.port = UDP_HAND_PORT;
+        hand.address = udpTransportAddress(hand.ip, UDP_HAND_PORT);
+    } else {
+        hand.address = from;
+    }
+}
+
+// 向当前TCP客户端发送喂料器错误回复，合并的命令每行回复一次（栈上格式化，不做堆分配）
+static void sendFeederError(uint8_t feederId, const char* reason, uint8_t lineCount = 1) {
+    char line[40];
+    snprintf(line, sizeof(line), "error Feeder %u %s", feederId, reason);
+    for (uint8_t i = 0; i < lineCount; i++) {
+        tcpSendLine(line);
+    }
+}
 
 // =============================================================================
 // 兼容ESP-NOW的全局变量定义
@@ -67,11 +150,16 @@ void brain_udp_setup() {
     // 优化WiFi性能设置
     optimizeWiFiSettings();
 
-    // 初始化UDP
-    if (udp.begin(UDP_BRAIN_PORT)) {
-        DEBUG_PRINTF("Brain UDP: 监听端口 %d\n", UDP_BRAIN_PORT);
-    } else {
-        DEBUG_PRINTLN("Brain UDP: 主端口初始化失败");
+    // 初始化命令通道（UDP主端口，以及开启时的ESP-NOW）
+    for (int i = 0; i < TRANSPORT_TYPE_COUNT; i++) {
+        if (brainTransports[i] == nullptr) {
+            continue;
+        }
+        if (brainTransports[i]->begin()) {
+            DEBUG_PRINTF("Brain UDP: 命令通道 %s 已启动\n", brainTransports[i]->name());
+        } else {
+            DEBUG_PRINTF("Brain UDP: 命令通道 %s 初始化失败\n", brainTransports[i]->name());
+        }
     }
 
     if (discoveryUdp.begin(UDP_DISCOVERY_PORT)) {
@@ -84,148 +172,408 @@ void brain_udp_setup() {
     for (int i = 0; i < TOTAL_FEEDERS; i++) {
         connectedHands[i].ip = IPAddress(0, 0, 0, 0);
         connectedHands[i].port = 0;
+        connectedHands[i].address = udpTransportAddress(IPAddress(0, 0, 0, 0), 0);
         connectedHands[i].lastSeen = 0;
         connectedHands[i].isOnline = false;
         connectedHands[i].feederId = i;
+        connectedHands[i].channel = 0;
         memset(connectedHands[i].handInfo, 0, sizeof(connectedHands[i].handInfo));
     }
 
     // 初始化待命令数组
-    for (int i = 0; i < 10; i++) {
+    for (int i = 0; i < MAX_PENDING_COMMANDS; i++) {
         pendingCommands[i].waiting = false;
         pendingCommands[i].needTcpReply = false;
         pendingCommands[i].commandType = 0;
     }
 
+    // 初始化Feeder命令队列
+    for (int i = 0; i < TOTAL_FEEDERS; i++) {
+        feederQueues[i].head = 0;
+        feederQueues[i].count = 0;
+    }
+
     resetBrainUDPStats();
     DEBUG_PRINTLN("Brain UDP: 初始化完成");
 }
 
+// 等待送料完成的时间：送料命令按该Feeder的耗时模型，其他命令Hand收到后立即回复
+static uint32_t actuationBudgetMs(uint8_t feederId, uint8_t commandType, uint8_t feedLength) {
+    if (commandType != CMD_FEEDER_ADVANCE) {
+        return ACTUATION_MIN_MARGIN_MS;
+    }
+    return feederActuation[feederId].budgetMs(feedLength, ACTUATION_DEFAULT_US_PER_MM, ACTUATION_MIN_MARGIN_MS);
+}
+
+static void failPendingCommand(PendingCommand& pending) {
+    pending.waiting = false;
+    const char* reason;
+    if (pending.ackGaveUp && !pending.acked) {
+        reason = "no ack";
+        noAckFailures++;
+    } else {
+        reason = "timeout";
+        brainUdpStats.timeouts++;
+    }
+
+    uint8_t feederId = pending.feederId;
+    if (pending.needTcpReply) {
+        sendFeederError(feederId, reason, pending.lineCount);
+    }
+    if (pending.commandType == CMD_FEEDER_ADVANCE) {
+        feederLastStatus[feederId] = STATUS_TIMEOUT;
+        feederLastReason[feederId] = REASON_NONE;
+        notifyCommandCompleted(feederId, false, reason);
+    }
+    completeFeederCommand(feederId);
+}
+
+// 发送命令包，重发时使用相同的序列号
+static bool sendCommandPacket(uint8_t feederId, uint32_t sequence, const ESPNowPacket& command) {
+    UDPCommandPacket udpCommand;
+    udpCommand.packetType = UDP_PKT_COMMAND;
+    udpCommand.sequence = sequence;
+    udpCommand.timestamp = getCurrentTimestamp();
+    udpCommand.command = command;
+
+    bool sent = sendToAddress(connectedHands[feederId].address, (uint8_t*)&udpCommand, sizeof(udpCommand));
+    if (!sent) {
+        brainUdpStats.errors++;
+    }
+    return sent;
+}
+
+// 处理一个状态探测请求：向空闲的在线Feeder发送心跳命令（不进入在途命令表），
+// Hand的确认或"Online"响应会刷新feederHeardMs；忙碌的Feeder由在途命令的确认和响应刷新
+static void sendStateProbe(uint32_t now) {
+    if (stateProbeCount == 0) {
+        return;
+    }
+    for (int i = 0; i < TOTAL_FEEDERS; i++) {
+        if (!stateProbeRequested[i]) {
+            continue;
+        }
+        stateProbeRequested[i] = false;
+        stateProbeCount--;
+        if (!connectedHands[i].isOnline || feederStatusArray[i].waitingForResponse || feederQueues[i].count > 0
+            || now - lastStateProbeMs[i] < FEEDER_STATE_PROBE_INTERVAL_MS) {
+            continue;
+        }
+
+        ESPNowPacket probe;
+        probe.commandType = CMD_HEARTBEAT;
+        probe.feederId = i;
+        probe.feedLength = 0;
+        memset(probe.reserved, 0, sizeof(probe.reserved));
+        probe.flags = 0;
+        if (sendCommandPacket(i, nextSequence++, probe)) {
+            stateProbesSent++;
+        }
+        lastStateProbeMs[i] = now;
+        break;                              // 每轮最多发送一个
+    }
+}
+
 void brain_udp_update() {
     uint32_t now = millis();
 
     // 处理接收到的UDP数据
     processBrainUDPData();
 
+    // 备机不向Hand发送心跳，也不判断超时（Hand状态由主机同步）
+    if (!isBrainActive()) {
+        return;
+    }
+
     // 定期发送心跳
     if (now - lastHeartbeatTime > UDP_HEARTBEAT_INTERVAL_MS) {
         sendHeartbeatToAllHands();
         lastHeartbeatTime = now;
     }
 
+    sendStateProbe(now);
+
     // 检查Hand连接状态
     if (now - lastHandCheckTime > UNASSIGNED_HAND_TIMEOUT_MS) { // 30秒检查一次
         checkHandConnections();
         lastHandCheckTime = now;
     }
 
-    // 检查命令超时
-    for (int i = 0; i < 10; i++) {
-        if (pendingCommands[i].waiting) {        if (now - pendingCommands[i].sentTime > pendingCommands[i].timeoutMs) {
-            pendingCommands[i].waiting = false;
-            brainUdpStats.timeouts++;
+    // 检查命令超时：会确认命令的Hand未确认时按往返时间重发，重发多次仍未确认说明Hand已失联
+    for (int i = 0; i < MAX_PENDING_COMMANDS; i++) {
+        PendingCommand& pending = pendingCommands[i];
+        if (!pending.waiting) {
+            continue;
         }
+        uint8_t feederId = pending.feederId;
+        if (!pending.acked && !pending.ackGaveUp && handAcks[feederId]) {
+            uint32_t rtoMs = handRtt[feederId].rtoMs(UDP_RTO_INITIAL_MS, UDP_RTO_MIN_MS, UDP_RTO_MAX_MS);
+            if (now - pending.lastSendTime <= rtoMs) {
+                continue;
+            }
+            if (pending.retries < UDP_MAX_RETRY_COUNT) {
+                sendCommandPacket(feederId, pending.sequence, pending.command);
+                pending.retries++;
+                pending.lastSendTime = now;
+                brainUdpStats.retransmits++;
+            } else {
+                // 可能只是确认丢失，Hand仍在送料：停止重发，但在送料耗时预算用完之前Feeder保持忙碌，
+                // 不派发排队的命令；这期间收到响应仍按正常完成处理
+                pending.ackGaveUp = true;
+            }
+        } else if (now - pending.sentTime > pending.timeoutMs) {
+            failPendingCommand(pending);
         }
     }
 }
 
-bool sendCommandToHand(uint8_t feederId, const ESPNowPacket& command, uint32_t timeoutMs) {
-    if (feederId >= TOTAL_FEEDERS || !connectedHands[feederId].isOnline) {
-        DEBUG_PRINTF("Brain UDP: Hand %d 未连接\n", feederId);
+// 实际发送UDP命令，不检查Feeder是否忙碌
+static bool transmitCommandToHand(uint8_t feederId, const ESPNowPacket& command, uint32_t timeoutMs, bool needTcpReply,
+                                  uint8_t lineCount, const GcodeLineTrace* lines) {
+    uint32_t sequence = nextSequence++;
+
+    // 发送命令
+    uint32_t sendStartUs = micros();
+    if (!sendCommandPacket(feederId, sequence, command)) {
         return false;
     }
 
-    // 创建UDP命令包
-    UDPCommandPacket udpCommand;
-    udpCommand.packetType = UDP_PKT_COMMAND;
-    udpCommand.sequence = nextSequence++;
-    udpCommand.timestamp = getCurrentTimestamp();
-    udpCommand.command = command;
+    traceCommandSent(feederId, sequence, sendStartUs, micros(), lines, lineCount);
+    brainUdpStats.commandsSent++;
+    // 更新最后通信时间
+    connectedHands[feederId].lastSeen = millis();
 
-    // 记录待命令
+    // 记录待命令，等待响应期间Feeder视为忙碌
     if (timeoutMs > 0) {
-        for (int i = 0; i < 10; i++) {
+        // 收到确认前按调用者的超时加上预计送料耗时等待（旧固件不回复确认）
+        if (command.commandType == CMD_FEEDER_ADVANCE) {
+            timeoutMs += actuationBudgetMs(feederId, command.commandType, command.feedLength);
+        }
+        for (int i = 0; i < MAX_PENDING_COMMANDS; i++) {
             if (!pendingCommands[i].waiting) {
-                pendingCommands[i].sequence = udpCommand.sequence;
-                pendingCommands[i].feederId = feederId;
-                pendingCommands[i].sentTime = millis();
-                pendingCommands[i].timeoutMs = timeoutMs;
-                pendingCommands[i].waiting = true;
-                pendingCommands[i].needTcpReply = false;    // 默认不需要TCP回复
-                pendingCommands[i].commandType = command.commandType;
+                PendingCommand& pending = pendingCommands[i];
+                pending.sequence = sequence;
+                pending.feederId = feederId;
+                pending.sentTime = millis();
+                pending.timeoutMs = timeoutMs;
+                pending.waiting = true;
+                pending.needTcpReply = needTcpReply;
+                pending.lineCount = lineCount;
+                pending.commandType = command.commandType;
+                pending.feedLength = command.feedLength;
+                pending.acked = false;
+                pending.retries = 0;
+                pending.ackGaveUp = false;
+                pending.lastSendTime = pending.sentTime;
+                pending.sentUs = sendStartUs;
+                pending.command = command;
                 break;
             }
         }
+
+        feederStatusArray[feederId].waitingForResponse = true;
+        feederStatusArray[feederId].commandSentTime = millis();
+        feederStatusArray[feederId].timeoutMs = timeoutMs;
     }
 
-    // 发送命令
-    udp.beginPacket(connectedHands[feederId].ip, connectedHands[feederId].port);
-    udp.write((uint8_t*)&udpCommand, sizeof(udpCommand));
-    bool sent = udp.endPacket();
+    // 通知Web界面命令已发送
+    if (command.commandType == CMD_FEEDER_ADVANCE) {
+        notifyCommandReceived(feederId, command.feedLength);
+    }
 
-    if (sent) {
-        brainUdpStats.commandsSent++;
-        // 更新最后通信时间
-        connectedHands[feederId].lastSeen = millis();
-        
-        // 通知Web界面命令已发送
-        if (command.commandType == CMD_FEEDER_ADVANCE) {
-            notifyCommandReceived(feederId, command.feedLength);
+    return true;
+}
+
+DispatchResult dispatchCommandToHand(uint8_t feederId, const ESPNowPacket& command, uint32_t timeoutMs, bool needTcpReply) {
+    // 需要TCP回复的命令来自正在处理的G-code行，该行的接收/解析区间随命令保存
+    GcodeLineTrace line = {false, false, 0, 0, 0, 0};
+    if (needTcpReply) {
+        takeLineTrace(line);
+    }
+
+    if (feederId >= TOTAL_FEEDERS || !connectedHands[feederId].isOnline) {
+        DEBUG_PRINTF("Brain UDP: Hand %d 未连接\n", feederId);
+        return DISPATCH_FAILED;
+    }
+    if (!isBrainActive()) {
+        // 备机不向Hand发送命令（Hand的响应会发到主机）
+        return DISPATCH_FAILED;
+    }
+
+    FeederCommandQueue& queue = feederQueues[feederId];
+
+    // Hand空闲且没有排队命令时立即发送
+    if (!feederStatusArray[feederId].waitingForResponse && queue.count == 0) {
+        return transmitCommandToHand(feederId, command, timeoutMs, needTcpReply, 1, &line) ? DISPATCH_SENT : DISPATCH_FAILED;
+    }
+
+#if FEED_COALESCE_ENABLED
+    // 送料命令合并到队尾同一Feeder的送料命令：Hand只执行一次更长的送料，完成后每行各回复一次
+    if (queue.count > 0 && command.commandType == CMD_FEEDER_ADVANCE) {
+        QueuedCommand& tail = queue.items[(queue.head + queue.count - 1) % FEEDER_QUEUE_DEPTH];
+        if (tail.command.commandType == CMD_FEEDER_ADVANCE && tail.command.flags == command.flags &&
+            tail.needTcpReply == needTcpReply && tail.lineCount < FEED_TRACE_LINES_PER_COMMAND &&
+            tail.command.feedLength + command.feedLength <= FEED_COALESCE_MAX_MM) {
+            tail.command.feedLength += command.feedLength;
+            tail.timeoutMs = max(tail.timeoutMs, timeoutMs);
+            tail.lines[tail.lineCount++] = line;
+            coalescedCommands++;
+            DEBUG_PRINTF("Brain UDP: Feeder %d 送料合并为 %dmm (%d行)\n", feederId, tail.command.feedLength, tail.lineCount);
+            return DISPATCH_QUEUED;
         }
-    } else {
+    }
+#endif
+
+    // Hand忙碌，排队等待上一条命令完成
+    if (queue.count >= FEEDER_QUEUE_DEPTH) {
+        DEBUG_PRINTF("Brain UDP: Feeder %d 队列已满\n", feederId);
         brainUdpStats.errors++;
+        return DISPATCH_BUSY;
     }
 
-    return sent;
+    QueuedCommand& slot = queue.items[(queue.head + queue.count) % FEEDER_QUEUE_DEPTH];
+    slot.command = command;
+    slot.timeoutMs = timeoutMs;
+    slot.needTcpReply = needTcpReply;
+    slot.lineCount = 1;
+    slot.lines[0] = line;
+    queue.count++;
+
+    DEBUG_PRINTF("Brain UDP: Feeder %d 忙碌，命令排队 (%d/%d)\n", feederId, queue.count, FEEDER_QUEUE_DEPTH);
+    return DISPATCH_QUEUED;
 }
 
-bool sendCommandToHand(uint8_t feederId, const ESPNowPacket& command, uint32_t timeoutMs, bool needTcpReply) {
-    if (feederId >= TOTAL_FEEDERS || !connectedHands[feederId].isOnline) {
-        return false;
+void completeFeederCommand(uint8_t feederId) {
+    if (feederId >= TOTAL_FEEDERS) {
+        return;
     }
 
-    // 创建UDP命令包
-    UDPCommandPacket udpCommand;
-    udpCommand.packetType = UDP_PKT_COMMAND;
-    udpCommand.sequence = nextSequence++;
-    udpCommand.timestamp = getCurrentTimestamp();
-    udpCommand.command = command;
+    feederStatusArray[feederId].waitingForResponse = false;
 
-    // 记录待命令
-    if (timeoutMs > 0) {
-        for (int i = 0; i < 10; i++) {
-            if (!pendingCommands[i].waiting) {
-                pendingCommands[i].sequence = udpCommand.sequence;
-                pendingCommands[i].feederId = feederId;
-                pendingCommands[i].sentTime = millis();
-                pendingCommands[i].timeoutMs = timeoutMs;
-                pendingCommands[i].waiting = true;
-                pendingCommands[i].needTcpReply = needTcpReply;
-                pendingCommands[i].commandType = command.commandType;
-                break;
-            }
+    // 发送队列中的下一条命令，发送失败则继续尝试后续命令
+    FeederCommandQueue& queue = feederQueues[feederId];
+    while (queue.count > 0 && !feederStatusArray[feederId].waitingForResponse) {
+        QueuedCommand next = queue.items[queue.head];
+        queue.head = (queue.head + 1) % FEEDER_QUEUE_DEPTH;
+        queue.count--;
+
+        bool sent = connectedHands[feederId].isOnline &&
+                    transmitCommandToHand(feederId, next.command, next.timeoutMs, next.needTcpReply, next.lineCount,
+                                          next.lines);
+        if (!sent && next.needTcpReply) {
+            sendFeederError(feederId, "send failed", next.lineCount);
         }
     }
+}
 
-    // 发送命令
-    udp.beginPacket(connectedHands[feederId].ip, connectedHands[feederId].port);
-    udp.write((uint8_t*)&udpCommand, sizeof(udpCommand));
-    bool sent = udp.endPacket();
+void flushFeederQueue(uint8_t feederId) {
+    if (feederId >= TOTAL_FEEDERS) {
+        return;
+    }
 
-    if (sent) {
-        brainUdpStats.commandsSent++;
-        // 更新最后通信时间
-        connectedHands[feederId].lastSeen = millis();
-        
-        // 通知Web界面命令已发送
-        if (command.commandType == CMD_FEEDER_ADVANCE) {
-            notifyCommandReceived(feederId, command.feedLength);
+    FeederCommandQueue& queue = feederQueues[feederId];
+    while (queue.count > 0) {
+        if (queue.items[queue.head].needTcpReply) {
+            sendFeederError(feederId, "offline", queue.items[queue.head].lineCount);
         }
-    } else {
-        brainUdpStats.errors++;
+        queue.head = (queue.head + 1) % FEEDER_QUEUE_DEPTH;
+        queue.count--;
     }
+}
 
-    return sent;
+bool getPendingCommand(uint8_t feederId, PendingCommandInfo& info) {
+    uint32_t now = millis();
+    for (int i = 0; i < MAX_PENDING_COMMANDS; i++) {
+        if (pendingCommands[i].waiting && pendingCommands[i].feederId == feederId) {
+            info.sequence = pendingCommands[i].sequence;
+            info.elapsedMs = now - pendingCommands[i].sentTime;
+            info.timeoutMs = pendingCommands[i].timeoutMs;
+            info.commandType = pendingCommands[i].commandType;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool adoptPendingCommand(uint8_t feederId, const PendingCommandInfo& info) {
+    if (feederId >= TOTAL_FEEDERS || info.elapsedMs >= info.timeoutMs) {
+        return false;
+    }
+
+    uint32_t sentTime = millis() - info.elapsedMs;
+    for (int i = 0; i < MAX_PENDING_COMMANDS; i++) {
+        if (!pendingCommands[i].waiting) {
+            pendingCommands[i].sequence = info.sequence;
+            pendingCommands[i].feederId = feederId;
+            pendingCommands[i].sentTime = sentTime;
+            pendingCommands[i].timeoutMs = info.timeoutMs;
+            pendingCommands[i].waiting = true;
+            pendingCommands[i].needTcpReply = false;    // 发出命令的TCP连接在对端
+            pendingCommands[i].lineCount = 1;
+            pendingCommands[i].commandType = info.commandType;
+            pendingCommands[i].feedLength = 0;
+            pendingCommands[i].acked = true;            // 没有命令内容，不重发，只等待响应
+            pendingCommands[i].retries = 0;
+            pendingCommands[i].ackGaveUp = false;
+            pendingCommands[i].lastSendTime = sentTime;
+            pendingCommands[i].sentUs = micros();
+
+            feederStatusArray[feederId].waitingForResponse = true;
+            feederStatusArray[feederId].commandSentTime = sentTime;
+            feederStatusArray[feederId].timeoutMs = info.timeoutMs;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t getNextSequence() {
+    return nextSequence;
+}
+
+void setNextSequence(uint32_t sequence) {
+    nextSequence = sequence;
+}
+
+void resetCommandState() {
+    for (int i = 0; i < MAX_PENDING_COMMANDS; i++) {
+        pendingCommands[i].waiting = false;
+    }
+    for (int i = 0; i < TOTAL_FEEDERS; i++) {
+        feederQueues[i].head = 0;
+        feederQueues[i].count = 0;
+        feederStatusArray[i].waitingForResponse = false;
+    }
+}
+
+int announceBrainToHands() {
+    int count = 0;
+    for (int i = 0; i < TOTAL_FEEDERS; i++) {
+        // 多通道Hand只通知首个通道
+        if (connectedHands[i].isOnline && connectedHands[i].channel == 0) {
+            if (sendDiscoveryResponse(connectedHands[i].ip, connectedHands[i].port, i)) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+uint8_t getFeederQueueLength(uint8_t feederId) {
+    if (feederId >= TOTAL_FEEDERS) {
+        return 0;
+    }
+    return feederQueues[feederId].count;
+}
+
+bool sendCommandToHand(uint8_t feederId, const ESPNowPacket& command, uint32_t timeoutMs) {
+    DispatchResult result = dispatchCommandToHand(feederId, command, timeoutMs, false);
+    return result == DISPATCH_SENT || result == DISPATCH_QUEUED;
+}
+
+bool sendCommandToHand(uint8_t feederId, const ESPNowPacket& command, uint32_t timeoutMs, bool needTcpReply) {
+    DispatchResult result = dispatchCommandToHand(feederId, command, timeoutMs, needTcpReply);
+    return result == DISPATCH_SENT || result == DISPATCH_QUEUED;
 }
 
 void sendHeartbeatToAllHands() {
@@ -234,13 +582,14 @@ void sendHeartbeatToAllHands() {
     heartbeat.deviceId = 0; // Brain ID
     heartbeat.timestamp_low = getTimestampLow();  // 使用优化后的低16位时间戳
     heartbeat.status = 0; // 正常状态
+    heartbeat.feederCount = 0;
+    // Brain不上报主循环统计（见/api/loop）
 
     int sentCount = 0;
     for (int i = 0; i < TOTAL_FEEDERS; i++) {
-        if (connectedHands[i].isOnline) {
-            udp.beginPacket(connectedHands[i].ip, connectedHands[i].port);
-            udp.write((uint8_t*)&heartbeat, sizeof(heartbeat));
-            if (udp.endPacket()) {
+        // 多通道Hand只向首个通道发送一次
+        if (connectedHands[i].isOnline && connectedHands[i].channel == 0) {
+            if (sendToAddress(connectedHands[i].address, (uint8_t*)&heartbeat, UDP_HEARTBEAT_BASE_SIZE)) {
                 sentCount++;
                 connectedHands[i].lastSeen = millis();
                 DEBUG_PRINTF("UDP: 心跳已发送到Hand %d (%s:%d)\n", 
@@ -269,65 +618,170 @@ int getOnlineHandCount() {
 // 内部UDP处理函数实现
 // =============================================================================
 
+// 处理命令通道收到的一个包（任一链路）
+static void handleMainPacket(size_t len, const TransportAddress& from) {
+    // 录制格式只有IP字段，ESP-NOW的包不录制
+    if (from.type == TRANSPORT_UDP) {
+        recordUdpPacket(TRAFFIC_UDP_MAIN, transportAddressIP(from), brainUdpBuffer, len, micros());
+    }
+    // printUDPPacket(brainUdpBuffer, len, true); // 打印接收的UDP包信息
+
+    UDPPacketType packetType = (UDPPacketType)brainUdpBuffer[0];
+
+    switch (packetType) {
+        case UDP_PKT_RESPONSE:
+            if (len >= UDP_RESPONSE_LEGACY_SIZE) {
+                // 兼容不带timing的旧固件（timing为0）
+                UDPResponsePacket response;
+                memset(&response, 0, sizeof(response));
+                memcpy(&response, brainUdpBuffer, min(len, sizeof(response)));
+                handleHandResponse(response, from);
+            }
+            break;
+
+        case UDP_PKT_ACK:
+            if (len >= sizeof(UDPAckPacket)) {
+                handleHandAck(*(UDPAckPacket*)brainUdpBuffer, from);
+            }
+            break;
+
+        case UDP_PKT_HEARTBEAT:
+            if (len >= UDP_HEARTBEAT_LEGACY_SIZE) {
+                // 兼容不带feederCount或主循环统计的旧固件（缺少的字段为0）
+                UDPHeartbeatPacket heartbeat;
+                memset(&heartbeat, 0, sizeof(heartbeat));
+                memcpy(&heartbeat, brainUdpBuffer, min(len, sizeof(heartbeat)));
+                handleHandHeartbeat(heartbeat, from);
+            }
+            break;
+
+        case UDP_PKT_DISCOVERY_REQUEST:
+            // ESP-NOW没有单独的发现端口，发现请求在命令通道上广播
+            if (from.type != TRANSPORT_UDP && len >= sizeof(UDPDiscoveryRequest)) {
+                handleDiscoveryRequest(*(UDPDiscoveryRequest*)brainUdpBuffer, from);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
 void processBrainUDPData() {
-    // 处理主UDP端口的数据
-    int packetSize = udp.parsePacket();
-    if (packetSize > 0) {
-        IPAddress remoteIP = udp.remoteIP();
-        uint16_t remotePort = udp.remotePort();
-        
-        size_t len = udp.read(brainUdpBuffer, sizeof(brainUdpBuffer));
+    // 处理命令通道的数据，每个链路每轮处理一个包
+    for (int i = 0; i < TRANSPORT_TYPE_COUNT; i++) {
+        if (brainTransports[i] == nullptr) {
+            continue;
+        }
+        TransportAddress from;
+        size_t len = brainTransports[i]->receive(brainUdpBuffer, sizeof(brainUdpBuffer), from);
         if (len > 0) {
-            // printUDPPacket(brainUdpBuffer, len, true); // 打印接收的UDP包信息
-            
-            UDPPacketType packetType = (UDPPacketType)brainUdpBuffer[0];
-            
-            switch (packetType) {
-                case UDP_PKT_RESPONSE:
-                    if (len >= sizeof(UDPResponsePacket)) {
-                        handleHandResponse(*(UDPResponsePacket*)brainUdpBuffer, remoteIP);
-                    }
-                    break;
-                    
-                case UDP_PKT_HEARTBEAT:
-                    if (len >= sizeof(UDPHeartbeatPacket)) {
-                        handleHandHeartbeat(*(UDPHeartbeatPacket*)brainUdpBuffer, remoteIP);
-                    }
-                    break;
-                    
-                default:
-                    break;
-            }
+            handleMainPacket(len, from);
         }
     }
 
     // 处理发现端口的数据
-    packetSize = discoveryUdp.parsePacket();
+    int packetSize = discoveryUdp.parsePacket();
     if (packetSize > 0) {
         IPAddress remoteIP = discoveryUdp.remoteIP();
         uint16_t remotePort = discoveryUdp.remotePort();
         
         size_t len = discoveryUdp.read(brainUdpBuffer, sizeof(brainUdpBuffer));
+        if (len > 0) {
+            recordUdpPacket(TRAFFIC_UDP_DISCOVERY, remoteIP, brainUdpBuffer, len, micros());
+        }
         if (len > 0 && brainUdpBuffer[0] == UDP_PKT_DISCOVERY_REQUEST) {
-            if (len >= sizeof(UDPDiscoveryRequest)) {
-                handleDiscoveryRequest(*(UDPDiscoveryRequest*)brainUdpBuffer, remoteIP, remotePort);
+            if (len >= UDP_DISCOVERY_REQUEST_LEGACY_SIZE) {
+                // 兼容不带feederCount的旧固件
+                UDPDiscoveryRequest request;
+                memset(&request, 0, sizeof(request));
+                memcpy(&request, brainUdpBuffer, min(len, sizeof(request)));
+                handleDiscoveryRequest(request, udpTransportAddress(remoteIP, remotePort));
             }
         }
     }
 }
 
-void handleDiscoveryRequest(const UDPDiscoveryRequest& request, IPAddress fromIP, uint16_t fromPort) {
+static void fillDiscoveryResponse(UDPDiscoveryResponse& response) {
+    response.packetType = UDP_PKT_DISCOVERY_RESPONSE;
+    response.brainId = 0; // Brain ID
+    response.timestamp_low = getTimestampLow();  // 使用优化后的低16位时间戳
+    
+    // 将IP地址转换为字节数组
+    response.brainIP[0] = WiFi.localIP()[0];
+    response.brainIP[1] = WiFi.localIP()[1];
+    response.brainIP[2] = WiFi.localIP()[2];
+    response.brainIP[3] = WiFi.localIP()[3];
+    
+    response.brainPort = UDP_BRAIN_PORT;
+    snprintf(response.brainInfo, sizeof(response.brainInfo), "Brain-ESP32");
+}
+
+void handleDiscoveryRequest(const UDPDiscoveryRequest& request, const TransportAddress& from) {
+    // 备机不响应，否则Hand会切换到备机
+    if (!isBrainActive()) {
+        return;
+    }
+
     handDiscoveryCount++;
     brainUdpStats.discoveryRequests++;
     
-    // 发送发现响应
-    sendDiscoveryResponse(fromIP, UDP_HAND_PORT, request.handId);
+    // 发送发现响应：UDP的请求来自发现端口，命令发往Hand主端口；ESP-NOW直接回复发送方
+    TransportAddress handAddress = from;
+    if (from.type == TRANSPORT_UDP) {
+        IPAddress handIP = transportAddressIP(from);
+        sendDiscoveryResponse(handIP, UDP_HAND_PORT, request.handId);
+        handAddress = udpTransportAddress(handIP, UDP_HAND_PORT);
+    } else {
+        UDPDiscoveryResponse response;
+        fillDiscoveryResponse(response);
+        if (sendToAddress(from, (uint8_t*)&response, sizeof(response))) {
+            brainUdpStats.discoveryResponses++;
+        } else {
+            brainUdpStats.errors++;
+        }
+    }
     
-    // 更新Hand信息
-    updateHandInfo(request.handId, fromIP, UDP_HAND_PORT, request.handInfo);
+    // 更新Hand信息，多通道Hand登记整个连续ID范围
+    uint8_t count = handFeederCount(request.handId, request.feederCount);
+    for (uint8_t ch = 0; ch < count; ch++) {
+        updateHandInfo(request.handId + ch, handAddress, request.handInfo, ch);
+        // 重新连接的Hand可能换了固件，收到确认后才按往返时间重发
+        if (request.handId + ch < TOTAL_FEEDERS) {
+            handAcks[request.handId + ch] = false;
+            feederHeardMs[request.handId + ch] = millis();
+        }
+    }
 }
 
-void handleHandResponse(const UDPResponsePacket& response, IPAddress fromIP) {
+void handleHandAck(const UDPAckPacket& ack, const TransportAddress& from) {
+    uint8_t feederId = ack.feederId;
+    if (feederId >= TOTAL_FEEDERS) {
+        return;
+    }
+    handAcks[feederId] = true;
+    connectedHands[feederId].lastSeen = millis();
+    feederHeardMs[feederId] = millis();
+
+    int index = findPendingCommand(pendingCommands, MAX_PENDING_COMMANDS, ack.sequence, feederId);
+    if (index < 0 || pendingCommands[index].acked) {
+        return;
+    }
+    PendingCommand& pending = pendingCommands[index];
+    pending.acked = true;
+    // 重发过的命令无法区分确认对应哪一次发送，不作为样本
+    if (pending.retries == 0) {
+        handRtt[feederId].addSample(micros() - pending.sentUs);
+    }
+    // 从现在起等待送料完成，再留一个重传超时给响应在路上的时间
+    uint32_t rtoMs = handRtt[feederId].rtoMs(UDP_RTO_INITIAL_MS, UDP_RTO_MIN_MS, UDP_RTO_MAX_MS);
+    pending.timeoutMs = (millis() - pending.sentTime) + rtoMs
+                      + actuationBudgetMs(feederId, pending.commandType, pending.feedLength);
+    feederStatusArray[feederId].timeoutMs = pending.timeoutMs;
+}
+
+void handleHandResponse(const UDPResponsePacket& response, const TransportAddress& from) {
+    uint32_t arrivalUs = micros();
     uint8_t feederId = response.response.handId;
     
     brainUdpStats.responsesReceived++;
@@ -335,76 +789,100 @@ void handleHandResponse(const UDPResponsePacket& response, IPAddress fromIP) {
     // 更新Hand最后通信时间
     if (feederId < TOTAL_FEEDERS) {
         connectedHands[feederId].lastSeen = millis();
+        feederHeardMs[feederId] = millis();
         
-        // 更新IP地址（可能发生变化）
-        if (connectedHands[feederId].ip != fromIP) {
-            connectedHands[feederId].ip = fromIP;
-        }
+        // 更新地址（IP可能变化，Hand也可能换了链路）
+        setHandAddress(connectedHands[feederId], from);
     }
     
     // 清除对应的待命令并处理TCP回复
-    for (int i = 0; i < 10; i++) {
-        if (pendingCommands[i].waiting && 
-            pendingCommands[i].sequence == response.sequence &&
-            pendingCommands[i].feederId == feederId) {
-            
-            // 如果需要TCP回复，发送给TCP客户端
-            if (pendingCommands[i].needTcpReply) {
-                WiFiClient* tcpClient = getCurrentTcpClient();
-                if (tcpClient && tcpClient->connected()) {
-                    String tcpResponse;
-                    if (response.response.status == STATUS_OK) {
-                        tcpResponse = "ok ";
-                        switch (pendingCommands[i].commandType) {
-                            case CMD_FEEDER_ADVANCE:
-                                tcpResponse += "Feed completed - " + String(response.response.message);
-                                break;
-                            default:
-                                tcpResponse += String(response.response.message);
-                                break;
-                        }
-                    } else {
-                        tcpResponse = "error " + String(response.response.message);
-                    }
-                    
-                    tcpClient->println(tcpResponse);
-                    tcpClient->flush();
-                }
-            }
-            
-            // 通知Web界面命令已完成
-            if (pendingCommands[i].commandType == CMD_FEEDER_ADVANCE) {
-                bool success = (response.response.status == STATUS_OK);
-                notifyCommandCompleted(feederId, success, response.response.message);
+    int index = findPendingCommand(pendingCommands, MAX_PENDING_COMMANDS, response.sequence, feederId);
+    if (index < 0) {
+        return;
+    }
+    PendingCommand& pending = pendingCommands[index];
+
+    traceHandResponse(feederId, response.sequence, response.timing, arrivalUs);
+
+    // 旧固件不回复确认：往返时间 = 总耗时 - Hand从收到命令到发送响应的时间
+    // 更旧的固件连timing也不带，总耗时里分不出送料时间，不作为样本
+    uint32_t totalUs = arrivalUs - pending.sentUs;
+    bool timed = hasHandTiming(response.timing);
+    if (timed && !pending.acked && pending.retries == 0 && totalUs > response.timing.receiveOffsetUs) {
+        handRtt[feederId].addSample(totalUs - response.timing.receiveOffsetUs);
+    }
+    if (timed && pending.commandType == CMD_FEEDER_ADVANCE && response.response.status == STATUS_OK) {
+        feederActuation[feederId].addSample(pending.feedLength,
+            response.timing.servoStartOffsetUs - response.timing.servoEndOffsetUs);
+    }
+    if (pending.commandType == CMD_FEEDER_ADVANCE) {
+        feederLastStatus[feederId] = response.response.status;
+        feederLastReason[feederId] = response.response.reason;
+    }
+
+    // 如果需要TCP回复，发送给TCP客户端
+    if (pending.needTcpReply) {
+        if (isTcpClientConnected()) {
+            uint32_t replyStartUs = micros();
+            char tcpResponse[64];
+            formatHandReply(tcpResponse, sizeof(tcpResponse), pending.commandType, response.response);
+
+            // 合并的送料命令每行都回复
+            for (uint8_t line = 0; line < pending.lineCount; line++) {
+                tcpSendLine(tcpResponse);
             }
-            
-            pendingCommands[i].waiting = false;
-            break;
+            traceTcpReply(feederId, response.sequence, replyStartUs, micros());
+        }
+    }
+    
+    // 通知Web界面命令已完成
+    if (pending.commandType == CMD_FEEDER_ADVANCE) {
+        bool success = (response.response.status == STATUS_OK);
+        // 合并的送料命令每行送出一个零件，M621的剩余数量按行扣减
+        uint8_t parts = success ? pending.lineCount : 1;
+        for (uint8_t part = 0; part < parts; part++) {
+            updateFeederStats(feederId, success);
         }
+        notifyCommandCompleted(feederId, success, response.response.message);
     }
+    
+    pending.waiting = false;
+    completeFeederCommand(feederId);
 }
 
-void handleHandHeartbeat(const UDPHeartbeatPacket& heartbeat, IPAddress fromIP) {
+void handleHandHeartbeat(const UDPHeartbeatPacket& heartbeat, const TransportAddress& from) {
     uint8_t feederId = heartbeat.deviceId;
     
-    DEBUG_PRINTF("UDP: 收到Hand %d心跳 from %s\n", feederId, fromIP.toString().c_str());
+    DEBUG_PRINTF("UDP: 收到Hand %d心跳 via %s\n", feederId, from.type == TRANSPORT_UDP ? "udp" : "espnow");
     
-    // 更新Hand信息
+    // 更新Hand信息，多通道Hand的心跳覆盖整个连续ID范围
     if (feederId < TOTAL_FEEDERS) {
-        bool wasOnline = connectedHands[feederId].isOnline;
-        connectedHands[feederId].ip = fromIP;
-        connectedHands[feederId].port = UDP_HAND_PORT;
-        connectedHands[feederId].lastSeen = millis();
-        connectedHands[feederId].isOnline = true;
-        connectedHands[feederId].feederId = feederId;
-        snprintf(connectedHands[feederId].handInfo, sizeof(connectedHands[feederId].handInfo), "Hand-%d", feederId);
-        
-        // 如果之前离线，现在上线了，通知Web界面
-        if (!wasOnline) {
-            notifyHandOnline(feederId);
+        uint8_t count = handFeederCount(feederId, heartbeat.feederCount);
+        for (uint8_t ch = 0; ch < count; ch++) {
+            uint8_t id = feederId + ch;
+            bool wasOnline = connectedHands[id].isOnline;
+            setHandAddress(connectedHands[id], from);
+            connectedHands[id].lastSeen = millis();
+            feederHeardMs[id] = millis();
+            connectedHands[id].isOnline = true;
+            connectedHands[id].feederId = id;
+            connectedHands[id].channel = ch;
+            if (ch == 0) {
+                snprintf(connectedHands[id].handInfo, sizeof(connectedHands[id].handInfo), "Hand-%d", feederId);
+                connectedHands[id].loopStats = heartbeat.loop;
+                recordHandHealth(feederId, heartbeat);
+            } else {
+                snprintf(connectedHands[id].handInfo, sizeof(connectedHands[id].handInfo), "Hand-%d ch%d", feederId, ch);
+            }
+            
+            // 如果之前离线，现在上线了，通知Web界面
+            if (!wasOnline) {
+                notifyHandOnline(id);
+            }
         }
-    } else if (feederId == 255) {
-        // 处理未分配的Hand设备（ID=255）
+    } else if (feederId == 255 && from.type == TRANSPORT_UDP) {
+        // 处理未分配的Hand设备（ID=255），网页按IP设置ID，未分配的Hand总是使用UDP
+        IPAddress fromIP = transportAddressIP(from);
         DEBUG_PRINTF("UDP: 处理未分配Hand设备心跳 from %s\n", fromIP.toString().c_str());
         
         // 查找或创建未分配设备条目
@@ -463,18 +941,7 @@ void handleHandHeartbeat(const UDPHeartbeatPacket& heartbeat, IPAddress fromIP)
 
 bool sendDiscoveryResponse(IPAddress handIP, uint16_t handPort, uint8_t handId) {
     UDPDiscoveryResponse response;
-    response.packetType = UDP_PKT_DISCOVERY_RESPONSE;
-    response.brainId = 0; // Brain ID
-    response.timestamp_low = getTimestampLow();  // 使用优化后的低16位时间戳
-    
-    // 将IP地址转换为字节数组
-    response.brainIP[0] = WiFi.localIP()[0];
-    response.brainIP[1] = WiFi.localIP()[1];
-    response.brainIP[2] = WiFi.localIP()[2];
-    response.brainIP[3] = WiFi.localIP()[3];
-    
-    response.brainPort = UDP_BRAIN_PORT;
-    snprintf(response.brainInfo, sizeof(response.brainInfo), "Brain-ESP32");
+    fillDiscoveryResponse(response);
 
     discoveryUdp.beginPacket(handIP, UDP_DISCOVERY_PORT);
     discoveryUdp.write((uint8_t*)&response, sizeof(response));
@@ -498,6 +965,7 @@ void checkHandConnections() {
             if (now - connectedHands[i].lastSeen > 60000) { // 60秒无通信
                 connectedHands[i].isOnline = false;
                 disconnectedCount++;
+                flushFeederQueue(i);
                 
                 // 通知Web界面Hand离线
                 notifyHandOffline(i);
@@ -506,17 +974,17 @@ void checkHandConnections() {
     }
 }
 
-void updateHandInfo(uint8_t feederId, IPAddress ip, uint16_t port, const char* info) {
+void updateHandInfo(uint8_t feederId, const TransportAddress& address, const char* info, uint8_t channel) {
     if (feederId >= TOTAL_FEEDERS) {
         return;
     }
     
     bool wasOnline = connectedHands[feederId].isOnline;
-    connectedHands[feederId].ip = ip;
-    connectedHands[feederId].port = port;
+    setHandAddress(connectedHands[feederId], address);
     connectedHands[feederId].lastSeen = millis();
     connectedHands[feederId].isOnline = true;
     connectedHands[feederId].feederId = feederId;
+    connectedHands[feederId].channel = channel;
     
     strncpy(connectedHands[feederId].handInfo, info, sizeof(connectedHands[feederId].handInfo) - 1);
     connectedHands[feederId].handInfo[sizeof(connectedHands[feederId].handInfo) - 1] = '\0';
@@ -537,18 +1005,25 @@ bool sendFeederAdvanceCommand(uint8_t feederId, uint8_t feedLength, uint32_t tim
     command.feederId = feederId;
     command.feedLength = feedLength;
     memset(command.reserved, 0, sizeof(command.reserved));
+    command.flags = 0;
     
     return sendCommandToHand(feederId, command, timeoutMs);
 }
 
 bool sendFeederAdvanceCommand(uint8_t feederId, uint8_t feedLength, uint32_t timeoutMs, bool needTcpReply) {
+    DispatchResult result = dispatchFeederAdvanceCommand(feederId, feedLength, timeoutMs, needTcpReply);
+    return result == DISPATCH_SENT || result == DISPATCH_QUEUED;
+}
+
+DispatchResult dispatchFeederAdvanceCommand(uint8_t feederId, uint8_t feedLength, uint32_t timeoutMs, bool needTcpReply, bool overrideError) {
     ESPNowPacket command;
     command.commandType = CMD_FEEDER_ADVANCE;
     command.feederId = feederId;
     command.feedLength = feedLength;
     memset(command.reserved, 0, sizeof(command.reserved));
+    command.flags = overrideError ? CMD_FLAG_OVERRIDE_ERROR : 0;
     
-    return sendCommandToHand(feederId, command, timeoutMs, needTcpReply);
+    return dispatchCommandToHand(feederId, command, timeoutMs, needTcpReply);
 }
 
 bool sendSetFeederIDCommand(uint8_t feederId, uint8_t newFeederID) {
@@ -557,6 +1032,7 @@ bool sendSetFeederIDCommand(uint8_t feederId, uint8_t newFeederID) {
     command.feederId = 255; // 广播
     command.feedLength = newFeederID; // 新ID放在feedLength字段
     memset(command.reserved, 0, sizeof(command.reserved));
+    command.flags = 0;
     
     // 发送到所有在线Hand（广播模式）
     bool anySent = false;
@@ -586,6 +1062,7 @@ bool sendSetFeederIDCommandToDevice(IPAddress targetIP, uint16_t targetPort, uin
     udpCommand.command.feederId = 255; // 广播模式
     udpCommand.command.feedLength = newFeederID; // 新ID放在feedLength字段
     memset(udpCommand.command.reserved, 0, sizeof(udpCommand.command.reserved));
+    udpCommand.command.flags = 0;
     
     // 发送UDP包到指定设备
     bool sent = false;
@@ -627,6 +1104,7 @@ bool sendFindMeCommand(uint8_t feederId) {
     command.feederId = feederId;
     command.feedLength = 0; // Find Me命令不需要feedLength
     memset(command.reserved, 0, sizeof(command.reserved));
+    command.flags = 0;
     
     return sendCommandToHand(feederId, command, UDP_COMMAND_TIMEOUT_MS);
 }
@@ -646,6 +1124,7 @@ bool sendFindMeCommandToDevice(IPAddress targetIP, uint16_t targetPort) {
     udpCommand.command.feederId = 255; // 未分配设备使用255
     udpCommand.command.feedLength = 0; // Find Me命令不需要feedLength
     memset(udpCommand.command.reserved, 0, sizeof(udpCommand.command.reserved));
+    udpCommand.command.flags = 0;
     
     // 发送UDP包到指定设备
     bool sent = false;
@@ -803,36 +1282,44 @@ void getUnassignedHandsList(String &response) {
     }
 }
 
-void getOnlineHandDetails(String &response) {
+size_t getOnlineHandDetails(char* buffer, size_t size) {
     DEBUG_PRINTF("Brain UDP: 获取在线Hand详细信息\n");
-    
-    response = "在线Hand设备详情:\n";
+
+    // 直接写入调用者的缓冲区，最后留出64字节给结尾一行，放不下时以截断标记结尾
+    static const char truncated[] = "...(已截断)\n";
+    size_t limit = size - 64;
+    size_t length = snprintf(buffer, size, "在线Hand设备详情:\n");
     uint32_t currentTime = millis();
     int onlineCount = 0;
-    
+
     for (int i = 0; i < TOTAL_FEEDERS; i++) {
         if (connectedHands[i].isOnline) {
             uint32_t timeSinceLastSeen = currentTime - connectedHands[i].lastSeen;
             if (timeSinceLastSeen < 30000) { // 30秒内有通信认为在线
-                response += "Feeder " + String(i) + ": ";
-                response += "IP=" + connectedHands[i].ip.toString();
-                response += " 端口=" + String(connectedHands[i].port);
-                response += " 状态=" + String(getHandStatusString(i));
-                response += " 信息=" + String(connectedHands[i].handInfo);
-                response += " 最后通信=" + String(timeSinceLastSeen / 1000) + "秒前";
-                response += " 总送料=" + String(feederStatusArray[i].totalFeedCount);
-                response += " 会话送料=" + String(feederStatusArray[i].sessionFeedCount);
-                response += "\n";
+                const IPAddress& ip = connectedHands[i].ip;
+                int written = snprintf(buffer + length, limit - length,
+                                       "Feeder %d: IP=%u.%u.%u.%u 端口=%u 状态=%s 信息=%s 最后通信=%lu秒前 总送料=%lu 会话送料=%u\n",
+                                       i, ip[0], ip[1], ip[2], ip[3], connectedHands[i].port, getHandStatusString(i),
+                                       connectedHands[i].handInfo, (unsigned long)(timeSinceLastSeen / 1000),
+                                       (unsigned long)feederStatusArray[i].totalFeedCount,
+                                       feederStatusArray[i].sessionFeedCount);
+                if (written < 0 || (size_t)written >= limit - length) {
+                    buffer[length] = '\0';
+                    strcat(buffer, truncated);
+                    return length + sizeof(truncated) - 1;
+                }
+                length += written;
                 onlineCount++;
             }
         }
     }
-    
+
     if (onlineCount == 0) {
-        response += "没有在线的Hand设备\n";
+        length += snprintf(buffer + length, size - length, "没有在线的Hand设备\n");
     } else {
-        response += "总计: " + String(onlineCount) + " 个在线设备\n";
+        length += snprintf(buffer + length, size - length, "总计: %d 个在线设备\n", onlineCount);
     }
+    return length;
 }
 
 void loadFeederConfig() {
@@ -870,3 +1357,58 @@ void updateFeederStats(uint8_t feederId, bool success) {
         DEBUG_PRINTF("Brain UDP: Feeder %d 送料失败\n", feederId);
     }
 }
+
+void getFeederState(uint8_t feederId, FeederStateSnapshot& state) {
+    const HandInfo& hand = connectedHands[feederId];
+    state.online = hand.isOnline;
+    state.busy = feederStatusArray[feederId].waitingForResponse;
+    state.queued = feederQueues[feederId].count;
+    state.lastStatus = feederLastStatus[feederId];
+    state.lastReason = feederLastReason[feederId];
+    state.healthWarnings = getHandHealthWarnings(feederId - hand.channel);
+    state.remainingParts = feederStatusArray[feederId].remainingPartCount;
+    state.heard = feederHeardMs[feederId] != 0;
+    state.ageMs = millis() - feederHeardMs[feederId];
+
+    if (state.online && (!state.heard || state.ageMs > FEEDER_STATE_MAX_AGE_MS) && !stateProbeRequested[feederId]) {
+        stateProbeRequested[feederId] = true;
+        stateProbeCount++;
+    }
+}
+
+void getLinkEstimatesJSON(String& result) {
+    const size_t capacity = JSON_OBJECT_SIZE(9) + JSON_ARRAY_SIZE(TOTAL_FEEDERS)
+                          + TOTAL_FEEDERS * JSON_OBJECT_SIZE(10) + 128;
+    DynamicJsonDocument doc(capacity);
+
+    doc["commandsSent"] = brainUdpStats.commandsSent;
+    doc["retransmits"] = brainUdpStats.retransmits;
+    doc["timeouts"] = brainUdpStats.timeouts;
+    doc["noAcks"] = noAckFailures;
+    doc["coalesced"] = coalescedCommands;
+    doc["stateProbes"] = stateProbesSent;
+    doc["defaultUsPerMm"] = ACTUATION_DEFAULT_US_PER_MM;
+    doc["espnow"] = brainTransports[TRANSPORT_ESPNOW] != nullptr;
+
+    JsonArray feeders = doc.createNestedArray("feeders");
+    for (int i = 0; i < TOTAL_FEEDERS; i++) {
+        const RttEstimator& rtt = handRtt[i];
+        const ActuationModel& actuation = feederActuation[i];
+        if (rtt.samples == 0 && actuation.samples == 0) {
+            continue;
+        }
+        JsonObject object = feeders.createNestedObject();
+        object["feederId"] = i;
+        object["link"] = connectedHands[i].address.type == TRANSPORT_ESPNOW ? "espnow" : "udp";
+        object["acks"] = handAcks[i];
+        object["rttSamples"] = rtt.samples;
+        object["srttUs"] = rtt.srttUs;
+        object["rttvarUs"] = rtt.rttvarUs;
+        object["rtoMs"] = rtt.rtoMs(UDP_RTO_INITIAL_MS, UDP_RTO_MIN_MS, UDP_RTO_MAX_MS);
+        object["feedSamples"] = actuation.samples;
+        object["usPerMm"] = actuation.usPerMm;
+        object["devUs"] = actuation.devUs;
+    }
+
+    serializeJson(doc, result);
+}
@@ -5,6 +5,7 @@
 #include <WiFi.h>
 #include <WiFiUdp.h>
 #include "common/udp_protocol.h"
+#include "common/udp_transport.h"
 #include "brain_config.h"
 
 // =============================================================================
@@ -15,14 +16,21 @@
 struct HandInfo {
     IPAddress ip;                       // Hand IP地址
     uint16_t port;                      // Hand端口
+    TransportAddress address;           // 命令通道地址：最近一次收到该Hand主通道包的链路（UDP或ESP-NOW）
     uint32_t lastSeen;                  // 最后通信时间
     bool isOnline;                      // 是否在线
     uint8_t feederId;                   // 喂料器ID
+    uint8_t channel;                    // 在所属Hand中的通道号（多通道Hand占用连续ID，0为首个）
     char handInfo[20];                  // Hand设备信息
+    UDPLoopStats loopStats;             // 最近一次心跳上报的主循环耗时（只在首个通道中保存）
 };
 
 // Brain端UDP状态
 extern HandInfo connectedHands[TOTAL_FEEDERS];
+
+// 各链路类型的传输实现（按TransportAddress.type索引，未开启的为nullptr），
+// 主机测试时可替换为LoopbackTransport
+extern Transport* brainTransports[TRANSPORT_TYPE_COUNT];
 extern uint32_t handDiscoveryCount;
 extern UDPStats brainUdpStats;
 
@@ -36,6 +44,26 @@ void brain_udp_setup();
 // Brain端UDP主循环处理
 void brain_udp_update();
 
+// 命令调度结果
+typedef enum {
+    DISPATCH_SENT = 0,                  // 已立即发送
+    DISPATCH_QUEUED = 1,                // Hand忙碌，已排队
+    DISPATCH_BUSY = 2,                  // 队列已满，拒绝
+    DISPATCH_FAILED = 3                 // Hand离线或发送失败
+} DispatchResult;
+
+// 调度命令到指定Hand：空闲时立即发送，忙碌时排队，队列满时返回DISPATCH_BUSY
+DispatchResult dispatchCommandToHand(uint8_t feederId, const ESPNowPacket& command, uint32_t timeoutMs, bool needTcpReply);
+
+// 当前命令完成（响应或超时），发送该Feeder队列中的下一条命令
+void completeFeederCommand(uint8_t feederId);
+
+// 丢弃Feeder队列中的命令（Hand离线时）
+void flushFeederQueue(uint8_t feederId);
+
+// 获取Feeder排队命令数量
+uint8_t getFeederQueueLength(uint8_t feederId);
+
 // 发送命令到指定Hand
 bool sendCommandToHand(uint8_t feederId, const ESPNowPacket& command, uint32_t timeoutMs = UDP_COMMAND_TIMEOUT_MS);
 
@@ -48,6 +76,34 @@ void sendHeartbeatToAllHands();
 // 获取在线Hand数量
 int getOnlineHandCount();
 
+// =============================================================================
+// 主备同步接口（brain_peer.cpp使用）
+// =============================================================================
+
+// 在途命令信息
+struct PendingCommandInfo {
+    uint32_t sequence;
+    uint32_t elapsedMs;                 // 已等待的时间
+    uint32_t timeoutMs;
+    uint8_t commandType;
+};
+
+// 查询Feeder的在途命令，没有时返回false
+bool getPendingCommand(uint8_t feederId, PendingCommandInfo& info);
+
+// 接管对端的在途命令：继续等待Hand响应（超时从对端已等待的时间算起），完成时不回复TCP
+bool adoptPendingCommand(uint8_t feederId, const PendingCommandInfo& info);
+
+// 下一个命令序列号
+uint32_t getNextSequence();
+void setNextSequence(uint32_t sequence);
+
+// 丢弃所有在途和排队的命令（不回复TCP，不通知Web），角色切换时使用
+void resetCommandState();
+
+// 向所有在线Hand发送发现响应，使其改为与本机通信，返回通知的Hand数量
+int announceBrainToHands();
+
 // =============================================================================
 // Web通知函数（在brain_web.cpp中实现）
 // =============================================================================
@@ -65,14 +121,17 @@ void notifyHandOffline(uint8_t feederId);
 // 处理接收到的UDP数据
 void processBrainUDPData();
 
-// 处理发现请求
-void handleDiscoveryRequest(const UDPDiscoveryRequest& request, IPAddress fromIP, uint16_t fromPort);
+// 处理发现请求（UDP发现端口或ESP-NOW广播）
+void handleDiscoveryRequest(const UDPDiscoveryRequest& request, const TransportAddress& from);
 
 // 处理Hand响应
-void handleHandResponse(const UDPResponsePacket& response, IPAddress fromIP);
+void handleHandResponse(const UDPResponsePacket& response, const TransportAddress& from);
+
+// 处理Hand的命令确认：记录往返时间，按送料耗时模型重新计算等待响应的时间
+void handleHandAck(const UDPAckPacket& ack, const TransportAddress& from);
 
 // 处理Hand心跳
-void handleHandHeartbeat(const UDPHeartbeatPacket& heartbeat, IPAddress fromIP);
+void handleHandHeartbeat(const UDPHeartbeatPacket& heartbeat, const TransportAddress& from);
 
 // 发送发现响应
 bool sendDiscoveryResponse(IPAddress handIP, uint16_t handPort, uint8_t handId);
@@ -80,8 +139,8 @@ bool sendDiscoveryResponse(IPAddress handIP, uint16_t handPort, uint8_t handId);
 // 检查Hand连接状态
 void checkHandConnections();
 
-// 更新Hand信息
-void updateHandInfo(uint8_t feederId, IPAddress ip, uint16_t port, const char* info);
+// 更新Hand信息，命令通道地址改为address
+void updateHandInfo(uint8_t feederId, const TransportAddress& address, const char* info, uint8_t channel = 0);
 
 // =============================================================================
 // 兼容函数（保持与原ESP-NOW接口兼容）
@@ -93,6 +152,9 @@ bool sendFeederAdvanceCommand(uint8_t feederId, uint8_t feedLength, uint32_t tim
 // 发送喂料命令（支持TCP回复）
 bool sendFeederAdvanceCommand(uint8_t feederId, uint8_t feedLength, uint32_t timeoutMs, bool needTcpReply);
 
+// 调度喂料命令（支持TCP回复），返回调度结果
+DispatchResult dispatchFeederAdvanceCommand(uint8_t feederId, uint8_t feedLength, uint32_t timeoutMs, bool needTcpReply, bool overrideError = false);
+
 // 发送设置ID命令（兼容原接口）
 bool sendSetFeederIDCommand(uint8_t feederId, uint8_t newFeederID);
 
@@ -112,7 +174,7 @@ bool sendFindMeCommandToDevice(IPAddress targetIP, uint16_t targetPort);
 void getUnassignedHandsList(String &response);
 
 // 获取在线Hand详细信息（兼容原接口）
-void getOnlineHandDetails(String &response);
+size_t getOnlineHandDetails(char* buffer, size_t size); // M620详情，返回写入的字节数
 
 // =============================================================================
 // 调试和统计函数
@@ -127,6 +189,25 @@ void resetBrainUDPStats();
 // 获取Hand状态字符串
 const char* getHandStatusString(uint8_t feederId);
 
+// Feeder状态快照（M621），全部取自Brain缓存的状态
+struct FeederStateSnapshot {
+    bool online;
+    bool busy;                          // 有在途命令
+    uint8_t queued;                     // 排队的命令数
+    uint8_t lastStatus;                 // 最近一次送料结果(ESPNowStatusCode)，无应答为STATUS_TIMEOUT
+    uint8_t lastReason;                 // 最近一次送料的错误原因码(ESPNowErrorReason)
+    uint8_t healthWarnings;             // 所属Hand的健康告警位(brain_health.h)
+    uint16_t remainingParts;
+    bool heard;                         // 是否收到过该Feeder的包
+    uint32_t ageMs;                     // 距最近一次收到该Feeder的包的时间
+};
+
+// 获取Feeder状态快照，不等待Hand；状态过旧时请求在brain_udp_update中探测Hand，本次仍返回缓存值
+void getFeederState(uint8_t feederId, FeederStateSnapshot& state);
+
+// 导出各Feeder的往返时间和送料耗时估计JSON（/api/link）
+void getLinkEstimatesJSON(String& result);
+
 // =============================================================================
 // 兼容ESP-NOW的数据结构和变量（保持原有接口）
 // =============================================================================
@@ -2,6 +2,13 @@
 #include "brain_config.h"
 #include "brain_udp.h"     // 替换ESP-NOW为UDP
 #include "gcode.h"
+#include "brain_trace.h"
+#include "brain_record.h"
+#include "brain_log.h"
+#include "brain_loop.h"
+#include "brain_peer.h"
+#include "brain_ota.h"
+#include "brain_health.h"
 #include <ESPAsyncWebServer.h>
 #include <ArduinoJson.h>
 #if defined(ESP32)
@@ -48,6 +55,8 @@ String getFeederStatusJSON() {
             feeder["lastSeen"] = -1;
         }
         
+        feeder["queued"] = getFeederQueueLength(i);
+        
         // 添加统计信息
         feeder["totalFeedCount"] = feederStatusArray[i].totalFeedCount;
         feeder["sessionFeedCount"] = feederStatusArray[i].sessionFeedCount;
@@ -70,11 +79,11 @@ String getFeederStatusJSON() {
 // WebSocket事件处理
 void onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
     if (type == WS_EVT_CONNECT) {
-        Serial.printf("WebSocket client #%u connected\n", client->id());
+        LOG_INFO(WEB, "WebSocket client #%u connected", client->id());
         // 发送初始状态
         client->text(getFeederStatusJSON());
     } else if (type == WS_EVT_DISCONNECT) {
-        Serial.printf("WebSocket client #%u disconnected\n", client->id());
+        LOG_INFO(WEB, "WebSocket client #%u disconnected", client->id());
     } else if (type == WS_EVT_DATA) {
         AwsFrameInfo *info = (AwsFrameInfo*)arg;
         if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT) {
@@ -221,6 +230,140 @@ void web_setup() {
         request->send(200, "application/json", result);
     });
     
+    // 调试API：导出送料链路追踪（Chrome/Perfetto trace JSON，可直接在ui.perfetto.dev打开）
+    webServer.on("/api/trace", HTTP_GET, [](AsyncWebServerRequest *request){
+        String result;
+        getFeedTraceJSON(result);
+        request->send(200, "application/json", result);
+    });
+    
+    // 调试API：清空送料链路追踪
+    webServer.on("/api/trace", HTTP_DELETE, [](AsyncWebServerRequest *request){
+        clearFeedTrace();
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+    
+    // 调试API：主循环各阶段耗时统计（含各Hand心跳上报的统计）
+    webServer.on("/api/loop", HTTP_GET, [](AsyncWebServerRequest *request){
+        String result;
+        getLoopProfileJSON(result);
+        request->send(200, "application/json", result);
+    });
+
+    // 调试API：清空Brain主循环统计
+    webServer.on("/api/loop", HTTP_DELETE, [](AsyncWebServerRequest *request){
+        clearLoopProfile();
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+
+    // 命令超时估计：各Feeder的往返时间、重传超时和送料耗时模型
+    webServer.on("/api/link", HTTP_GET, [](AsyncWebServerRequest *request){
+        String result;
+        getLinkEstimatesJSON(result);
+        request->send(200, "application/json", result);
+    });
+
+    // Hand健康状态：信号、堆、循环耗时、重启和送料错误，标出超过阈值的Hand
+    webServer.on("/api/health", HTTP_GET, [](AsyncWebServerRequest *request){
+        String result;
+        getHandHealthJSON(result);
+        request->send(200, "application/json", result);
+    });
+
+    // 清空各Hand的最差值和重启统计
+    webServer.on("/api/health", HTTP_DELETE, [](AsyncWebServerRequest *request){
+        clearHandHealth();
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+
+    // 主备状态：本机角色、对端和接管统计
+    webServer.on("/api/peer", HTTP_GET, [](AsyncWebServerRequest *request){
+        String result;
+        getBrainPeerStatusJSON(result);
+        request->send(200, "application/json", result);
+    });
+
+    // Hand固件组播升级：上传镜像（multipart，保存到LittleFS）
+    static bool otaUploadOk = false;
+    webServer.on("/api/ota/image", HTTP_POST, [](AsyncWebServerRequest *request){
+        if (otaUploadOk) {
+            request->send(200, "application/json", "{\"success\":true}");
+        } else {
+            request->send(409, "application/json", "{\"success\":false,\"error\":\"Update running or write failed\"}");
+        }
+    }, [](AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t len, bool final){
+        if (index == 0) {
+            otaUploadOk = true;
+        }
+        if (otaUploadOk) {
+            otaUploadOk = storeHandFirmware(index, data, len, final);
+        }
+    });
+
+    // Hand固件组播升级：开始
+    webServer.on("/api/ota", HTTP_POST, [](AsyncWebServerRequest *request){
+        if (!requestFleetUpdate()) {
+            request->send(409, "application/json", "{\"success\":false,\"error\":\"No image or update running\"}");
+            return;
+        }
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+
+    // Hand固件组播升级：进度和各Hand状态
+    webServer.on("/api/ota", HTTP_GET, [](AsyncWebServerRequest *request){
+        String result;
+        getFleetUpdateStatusJSON(result);
+        request->send(200, "application/json", result);
+    });
+
+    // Hand固件组播升级：取消
+    webServer.on("/api/ota", HTTP_DELETE, [](AsyncWebServerRequest *request){
+        requestFleetUpdateAbort();
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+
+    // 调试API：读取并取出延迟日志（与串口输出共用同一缓冲区，已读取的不会再输出到串口）
+    webServer.on("/api/log", HTTP_GET, [](AsyncWebServerRequest *request){
+        AsyncResponseStream *response = request->beginResponseStream("text/plain; charset=utf-8");
+        logDrain(*response, LOG_RING_DEPTH * LOG_LINE_LENGTH);
+        request->send(response);
+    });
+
+    // 调试API：通信录制状态
+    webServer.on("/api/record/status", HTTP_GET, [](AsyncWebServerRequest *request){
+        String result;
+        getTrafficRecordStatusJSON(result);
+        request->send(200, "application/json", result);
+    });
+
+    // 调试API：开始/停止通信录制（/api/record?enable=1）
+    webServer.on("/api/record", HTTP_POST, [](AsyncWebServerRequest *request){
+        if (!request->hasParam("enable")) {
+            request->send(400, "application/json", "{\"success\":false,\"error\":\"Missing enable\"}");
+            return;
+        }
+        setTrafficRecording(request->getParam("enable")->value().toInt() != 0);
+        String result;
+        getTrafficRecordStatusJSON(result);
+        request->send(200, "application/json", result);
+    });
+
+    // 调试API：下载录制文件（二进制，用tools/traffic_replay.py解析和回放）
+    // 下载前先停止录制，避免导出过程中主循环继续写入
+    webServer.on("/api/record", HTTP_GET, [](AsyncWebServerRequest *request){
+        setTrafficRecording(false);
+        AsyncResponseStream *response = request->beginResponseStream("application/octet-stream");
+        response->addHeader("Content-Disposition", "attachment; filename=\"traffic.pnpr\"");
+        writeTrafficRecording(*response);
+        request->send(response);
+    });
+
+    // 调试API：清空录制
+    webServer.on("/api/record", HTTP_DELETE, [](AsyncWebServerRequest *request){
+        clearTrafficRecording();
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+    
     // API端点：获取未分配Hand列表
     webServer.on("/api/unassigned", HTTP_GET, [](AsyncWebServerRequest *request){
         String response;
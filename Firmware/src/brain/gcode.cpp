@@ -3,8 +3,14 @@
 #include "lcd.h"
 #include <WiFi.h>
 #include "brain_tcp.h"
+#include "brain_trace.h"
+#include "gcode_parse.h"
+#include "gcode_reply.h"
+#include "brain_record.h"
+#include "brain_log.h"
+#include "brain_peer.h"
 
-String inputBuffer = ""; // Buffer for incoming G-Code lines
+String inputBuffer = ""; // 当前正在处理的G-code行
 
 // Add these lines if not already defined elsewhere:
 #define FEEDER_ENABLED 1
@@ -18,154 +24,63 @@ uint8_t feederEnabled = FEEDER_DISABLED;
 // Function to check if the feeder number is valid
 bool validFeederNo(int8_t signedFeederNo, uint8_t feederNoMandatory = 0)
 {
-    if (signedFeederNo == -1 && feederNoMandatory >= 1)
-    {
-        // no number given (-1) but it is mandatory.
-        return false;
-    }
-    else
-    {
-        // state now: number is given, check for valid range
-        if (signedFeederNo < 0 || signedFeederNo > (NUMBER_OF_FEEDER - 1))
-        {
-            // error, number not in a valid range
-            return false;
-        }
-        else
-        {
-            // perfectly fine number
-            return true;
-        }
-    }
+    return isValidFeederNumber(signedFeederNo, feederNoMandatory >= 1, NUMBER_OF_FEEDER);
 }
 
-void sendAnswer(uint8_t error, String message)
+// 回复缓冲区：每条回复只格式化一次，串口和TCP共用，不做堆分配
+static char replyBuffer[GCODE_REPLY_BUFFER_SIZE];
+
+void sendAnswer(uint8_t error, const char* message)
 {
-    String response;
-    if (error == 0)
+    uint32_t startUs = micros();
+    const char* prefix = (error == 0) ? "ok" : "error";
+    int length = formatGcodeAnswer(replyBuffer, sizeof(replyBuffer), error, message);
+
+    if (length > 0 && (size_t)length < sizeof(replyBuffer))
     {
-        Serial.print(F("ok "));
-        response = "ok " + message;
+        Serial.print(replyBuffer);
+        // 一次非阻塞发送，不再flush等待
+        bool sent = tcpSend(replyBuffer, length);
+        LOG_DEBUG(GCODE, "TCP回复%s，%d字节", sent ? "已发送" : "未发送", length);
     }
     else
     {
-        Serial.print(F("error "));
-        response = "error " + message;
-    }
-
-    Serial.println(message);
-    
-    // 如果有TCP客户端连接，也发送给TCP客户端
-    WiFiClient* tcpClient = getCurrentTcpClient();
-    if (tcpClient && tcpClient->connected()) {
-        String fullResponse = "";
-        if (error == 0) {
-            tcpClient->print("ok ");
-            fullResponse = "ok ";
-        } else {
-            tcpClient->print("error ");
-            fullResponse = "error ";
-        }
-        tcpClient->println(message);
-        fullResponse += message;
-        tcpClient->flush(); // 确保数据发送
-        
-        // 添加调试信息
-        Serial.print("TCP回复已发送: ");
-        Serial.println(fullResponse);
-    } else {
-        // 添加调试信息
-        Serial.println("TCP客户端未连接或获取失败");
-        if (tcpClient) {
-            Serial.print("TCP客户端连接状态: ");
-            Serial.println(tcpClient->connected() ? "已连接" : "已断开");
-        } else {
-            Serial.println("TCP客户端指针为空");
+        // 超长回复（如M620详情）不拼接，前缀、内容和换行分段写出，在TCP上作为一整条发送
+        const char* parts[] = {prefix, " ", message, "\r\n"};
+        const size_t lengths[] = {strlen(prefix), 1, strlen(message), 2};
+        for (size_t i = 0; i < 4; i++)
+        {
+            Serial.write((const uint8_t*)parts[i], lengths[i]);
         }
+        bool sent = tcpSendParts(parts, lengths, 4);
+        LOG_DEBUG(GCODE, "TCP回复%s，%u字节", sent ? "已发送" : "未发送", lengths[0] + lengths[2] + 3);
+        snprintf(replyBuffer, sizeof(replyBuffer), "%s %s", prefix, message);
     }
+    traceAnswer(startUs, micros());
 
 #if HAS_LCD
     // 添加防抖逻辑，避免短时间内重复更新LCD
     static unsigned long last_lcd_update = 0;
-    static String last_response = "";
+    static char last_response[GCODE_REPLY_BUFFER_SIZE] = "";
     unsigned long now = millis();
 
+    // LCD只显示回复内容，去掉行尾的\r\n
+    replyBuffer[strcspn(replyBuffer, "\r\n")] = '\0';
+
     // 只在响应内容改变或距离上次更新超过200ms时才更新LCD
-    if (response != last_response || (now - last_lcd_update > 200))
+    if (strcmp(replyBuffer, last_response) != 0 || (now - last_lcd_update > 200))
     {
-        lcd_update_gcode("", response.c_str());
+        lcd_update_gcode("", replyBuffer);
         last_lcd_update = now;
-        last_response = response;
+        strcpy(last_response, replyBuffer);
     }
 #endif
 }
 
 void sendAnswer(int error, const __FlashStringHelper *message)
 {
-    // 构建响应
-    String response = "";
-    String msg = String(message); // 正确转换FlashStringHelper
-
-    if (error == 0)
-    {
-        Serial.print(F("ok "));
-        response = "ok";
-        if (msg.length() > 0)
-        {
-            response += " " + msg;
-        }
-    }
-    else
-    {
-        Serial.print(F("error "));
-        response = "error " + msg;
-    }
-
-    Serial.println(msg);
-    
-    // 如果有TCP客户端连接，也发送给TCP客户端
-    WiFiClient* tcpClient = getCurrentTcpClient();
-    if (tcpClient && tcpClient->connected()) {
-        String fullResponse = "";
-        if (error == 0) {
-            tcpClient->print("ok ");
-            fullResponse = "ok ";
-        } else {
-            tcpClient->print("error ");
-            fullResponse = "error ";
-        }
-        tcpClient->println(msg);
-        fullResponse += msg;
-        tcpClient->flush(); // 确保数据发送
-        
-        // 添加调试信息
-        Serial.print("TCP回复已发送: ");
-        Serial.println(fullResponse);
-    } else {
-        // 添加调试信息
-        Serial.println("TCP客户端未连接或获取失败");
-        if (tcpClient) {
-            Serial.print("TCP客户端连接状态: ");
-            Serial.println(tcpClient->connected() ? "已连接" : "已断开");
-        } else {
-            Serial.println("TCP客户端指针为空");
-        }
-    }
-
-#if HAS_LCD
-    // 添加防抖逻辑，避免短时间内重复更新LCD
-    static unsigned long last_lcd_update = 0;
-    static String last_response = "";
-    unsigned long now = millis();
-
-    // 只在响应内容改变或距离上次更新超过200ms时才更新LCD
-    if (response != last_response || (now - last_lcd_update > 200))
-    {
-        lcd_update_gcode("", response.c_str());
-        last_lcd_update = now;
-        last_response = response;
-    }
-#endif
+    // ESP32上F()字符串位于可直接寻址的flash中
+    sendAnswer((uint8_t)error, reinterpret_cast<const char*>(message));
 }
 
 /**
@@ -176,18 +91,8 @@ void sendAnswer(int error, const __FlashStringHelper *message)
  **/
 float parseParameter(char code, float defaultVal)
 {
-    int codePosition = inputBuffer.indexOf(code);
-    if (codePosition != -1)
-    {
-        int delimiterPosition = inputBuffer.indexOf(" ", codePosition + 1);
-        if (delimiterPosition == -1) delimiterPosition = inputBuffer.length();
-        float parsedNumber = inputBuffer.substring(codePosition + 1, delimiterPosition).toFloat();
-        return parsedNumber;
-    }
-    else
-    {
-        return defaultVal;
-    }
+    // 直接在缓冲区上解析，不再为每个参数创建substring
+    return parseGcodeParameter(inputBuffer.c_str(), code, defaultVal);
 }
 
 /**
@@ -195,6 +100,8 @@ float parseParameter(char code, float defaultVal)
  */
 void processCommand()
 {
+    uint32_t parseStartUs = micros();
+
 #if HAS_LCD
     // 在LCD上显示接收到的G-code命令
     if (inputBuffer.length() > 0)
@@ -206,10 +113,7 @@ void processCommand()
     // get the command, default -1 if no command found
     int cmd = parseParameter('M', -1);
 
-#ifdef DEBUG
-    Serial.print("command found: M");
-    Serial.println(cmd);
-#endif
+    LOG_DEBUG(GCODE, "command found: M%d", cmd);
 
     switch (cmd)
     {
@@ -232,9 +136,8 @@ void processCommand()
         }
         else if (_feederEnabled == -1)
         {
-            String statusMsg = "current powerState: ";
-            statusMsg += (feederEnabled == FEEDER_ENABLED) ? "enabled" : "disabled";
-            sendAnswer(0, statusMsg);
+            sendAnswer(0, (feederEnabled == FEEDER_ENABLED) ? "current powerState: enabled"
+                                                            : "current powerState: disabled");
         }
         else
         {
@@ -254,48 +157,33 @@ void processCommand()
         //     break;
         // }
 
-        int8_t signedFeederNo = (int)parseParameter('N', -1);
-        int8_t overrideErrorRaw = (int)parseParameter('X', -1);
-        bool overrideError = false;
-        if (overrideErrorRaw >= 1)
+        // 参数解析和检查在gcode_parse.h中（可在主机上测试）
+        FeedAdvanceArgs args;
+        const char* argsError = parseFeedAdvanceArgs(inputBuffer.c_str(), NUMBER_OF_FEEDER, args);
+        if (argsError != nullptr)
         {
-            overrideError = true;
-        }
-
-        // 检查是否存在必需的 FeederNo
-        if (!validFeederNo(signedFeederNo, 1))
-        {
-            sendAnswer(1, F("feederNo missing or invalid"));
+            sendAnswer(1, argsError);
             break;
         }
 
-        // 确定送料长度
-        uint8_t feedLength;
-        // 如果有提供送料长度则获取，否则使用默认配置的 feed_length
-        feedLength = (uint8_t)parseParameter('F', 2);
+        LOG_DEBUG(GCODE, "Determined feedLength %u", args.feedLength);
 
-        if (((feedLength % 2) != 0) || feedLength < 2 || feedLength > 24)
-        {
-            // 送料长度必须为2的倍数且在2-18mm范围内
-            sendAnswer(1, F("Invalid feedLength, must be even number 2-24"));
-            break;
-        }
-
-#ifdef DEBUG
-        Serial.print("Determined feedLength ");
-        Serial.print(feedLength);
-        Serial.println();
-#endif
+        traceParseDone(parseStartUs, micros());
 
         // start feeding
         // 通过UDP发送命令到Hand，并等待响应后回复TCP客户端
-        bool triggerFeedOK = sendFeederAdvanceCommand((uint8_t)signedFeederNo, feedLength, UDP_COMMAND_TIMEOUT_MS, true);
-        if (!triggerFeedOK)
+        DispatchResult dispatch = dispatchFeederAdvanceCommand(args.feederNo, args.feedLength, UDP_COMMAND_TIMEOUT_MS, true, args.overrideError);
+        if (dispatch == DISPATCH_BUSY)
+        {
+            // Feeder队列已满，立即告知OpenPnP稍后重试
+            sendAnswer(1, F("busy"));
+        }
+        else if (dispatch == DISPATCH_FAILED)
         {
             // UDP发送失败，立即报告错误
             sendAnswer(1, F("Failed to send feeder advance command"));
         }
-        // 如果UDP发送成功，不立即回复
+        // 如果UDP发送成功或已排队，不立即回复
         // 等待Hand处理完成后通过UDP响应处理自动回复TCP客户端
 
         break;
@@ -303,9 +191,72 @@ void processCommand()
 
     case MCODE_GET_FEEDER_ID: // M620 N0
     {
-        String response;
-        getOnlineHandDetails(response);
-        sendAnswer(0, response);
+        static char details[GCODE_DETAILS_BUFFER_SIZE];
+        getOnlineHandDetails(details, sizeof(details));
+        sendAnswer(0, details);
+        break;
+    }
+
+    case MCODE_GET_FEEDER_STATE: // M621 N0
+    {
+        int8_t signedFeederNo = (int)parseParameter('N', -1);
+        if (!validFeederNo(signedFeederNo, 1))
+        {
+            sendAnswer(1, F("feederNo missing or invalid"));
+            break;
+        }
+
+        // 一行回复：O在线 B有在途命令 Q排队数 S/E最近一次送料的状态码/原因码 W健康告警位 R剩余零件 A状态的毫秒数（-1为从未收到）
+        FeederStateSnapshot state;
+        getFeederState((uint8_t)signedFeederNo, state);
+        char stateLine[80];
+        snprintf(stateLine, sizeof(stateLine), "N%d O%d B%d Q%u S%u E%u W%u R%u A%ld",
+                 signedFeederNo, state.online, state.busy, state.queued, state.lastStatus, state.lastReason,
+                 state.healthWarnings, state.remainingParts, state.heard ? (long)state.ageMs : -1L);
+        sendAnswer(0, stateLine);
+        break;
+    }
+
+    case MCODE_CALIBRATE_SETTLE: // M640 N0 S1
+    case MCODE_PICK_FAILED:      // M641 N0
+    {
+        int8_t signedFeederNo = (int)parseParameter('N', -1);
+        if (!validFeederNo(signedFeederNo, 1))
+        {
+            sendAnswer(1, F("feederNo missing or invalid"));
+            break;
+        }
+
+        ESPNowPacket command;
+        command.feederId = (uint8_t)signedFeederNo;
+        memset(command.reserved, 0, sizeof(command.reserved));
+        command.flags = 0;
+        if (cmd == MCODE_CALIBRATE_SETTLE)
+        {
+            command.commandType = CMD_CALIBRATE_SETTLE;
+            command.feedLength = (uint8_t)parseParameter('S', 2); // 0=结束 1=开始 2=查询
+            if (command.feedLength > 2)
+            {
+                sendAnswer(1, F("Invalid S, must be 0, 1 or omitted"));
+                break;
+            }
+        }
+        else
+        {
+            command.commandType = CMD_PICK_FAILED;
+            command.feedLength = 0;
+        }
+
+        // 与送料命令走同一队列，保证在该Feeder上一次送料完成后才处理
+        DispatchResult dispatch = dispatchCommandToHand(command.feederId, command, UDP_COMMAND_TIMEOUT_MS, true);
+        if (dispatch == DISPATCH_BUSY)
+        {
+            sendAnswer(1, F("busy"));
+        }
+        else if (dispatch == DISPATCH_FAILED)
+        {
+            sendAnswer(1, F("Failed to send command to feeder"));
+        }
         break;
     }
 
@@ -328,35 +279,128 @@ void processCommand()
     }
 }
 
-void listenToSerialStream()
+// =============================================================================
+// G-code输入：串口和TCP共用的行队列
+// =============================================================================
+
+static QueueHandle_t gcodeLineQueue = nullptr;
+static GcodeLine waitedLine;                // waitForGcodeLine已取出、尚未处理的行
+static bool hasWaitedLine = false;
+
+bool queueGcodeLine(const GcodeLine& line)
 {
+    return xQueueSend(gcodeLineQueue, &line, 0) == pdTRUE;
+}
 
-    while (Serial.available())
-    {
+static void replySerialBusy(const char* data, size_t length)
+{
+    Serial.write((const uint8_t*)data, length);
+    LOG_WARN(GCODE, "行队列已满，串口回复busy");
+}
+
+static GcodeLineReceiver serialReceiver(GCODE_SOURCE_SERIAL, queueGcodeLine, replySerialBusy);
 
-        // get the received byte, convert to char for adding to buffer
-        char receivedChar = (char)Serial.read();
+// 串口接收事件：把驱动缓冲区中的字节拼成完整行
+static void drainSerial()
+{
+    char bytes[64];
+    int available;
+    while ((available = Serial.available()) > 0)
+    {
+        size_t count = Serial.readBytes((uint8_t*)bytes, available < (int)sizeof(bytes) ? available : sizeof(bytes));
+        serialReceiver.receive(bytes, count, micros());
+    }
+}
 
-// print back for debugging
-#ifdef DEBUG
-        Serial.print(receivedChar);
+#if ARDUINO_USB_CDC_ON_BOOT && ARDUINO_USB_MODE
+// 原生USB（USB Serial/JTAG）：收到数据包时触发
+static void onSerialEvent(void* arg, esp_event_base_t base, int32_t id, void* data)
+{
+    drainSerial();
+}
 #endif
 
-        // add to buffer
-        inputBuffer += receivedChar;
+void gcode_setup()
+{
+    gcodeLineQueue = xQueueCreate(GCODE_LINE_QUEUE_DEPTH, sizeof(GcodeLine));
+    serialReceiver.reset();
+#if ARDUINO_USB_CDC_ON_BOOT && ARDUINO_USB_MODE
+    Serial.onEvent(ARDUINO_HW_CDC_RX_EVENT, onSerialEvent);
+#else
+    // UART：FIFO达到阈值或接收超时时触发
+    Serial.onReceive(drainSerial);
+#endif
+}
 
-        // if the received character is a newline, processCommand
-        if (receivedChar == '\n')
+static void processGcodeLine(GcodeLine& line)
+{
+    clearLineTrace();
+    if (line.source == GCODE_SOURCE_TCP)
+    {
+        traceLineReceived(line.rxStartUs, line.rxEndUs);
+        recordTcpLine(line.text, strlen(line.text), line.rxEndUs);
+    }
+    else
+    {
+        // remove comments
+        char* comment = strchr(line.text, ';');
+        if (comment)
         {
+            *comment = '\0';
+            size_t length = strlen(line.text);
+            while (length > 0 && line.text[length - 1] == ' ')
+            {
+                line.text[--length] = '\0';
+            }
+        }
+    }
+
+    if (line.overflow)
+    {
+        sendAnswer(1, F("line too long"));
+        return;
+    }
 
-            // remove comments
-            inputBuffer.remove(inputBuffer.indexOf(";"));
-            inputBuffer.trim();
+    if (!isBrainActive())
+    {
+        // 备机只镜像主机状态，不执行命令
+        sendAnswer(1, F("Brain is standby"));
+        return;
+    }
 
-            processCommand();
+    DEBUG_PRINTF("Received %s command: %s\n", line.source == GCODE_SOURCE_TCP ? "TCP" : "serial", line.text);
 
-            // clear buffer
-            inputBuffer = "";
-        }
+    // inputBuffer只在此处赋值，容量足够时复用原有内存
+    inputBuffer = line.text;
+    processCommand();
+    inputBuffer = "";
+}
+
+void processGcodeLines()
+{
+    if (hasWaitedLine)
+    {
+        hasWaitedLine = false;
+        processGcodeLine(waitedLine);
+    }
+
+    GcodeLine line;
+    while (xQueueReceive(gcodeLineQueue, &line, 0) == pdTRUE)
+    {
+        processGcodeLine(line);
+    }
+}
+
+bool waitForGcodeLine(uint32_t timeoutMs)
+{
+    if (hasWaitedLine)
+    {
+        return true;
+    }
+    // 阻塞等待代替delay：有新行时立即唤醒主循环，取出的行留到下一次processGcodeLines处理
+    if (xQueueReceive(gcodeLineQueue, &waitedLine, pdMS_TO_TICKS(timeoutMs)) == pdTRUE)
+    {
+        hasWaitedLine = true;
     }
+    return hasWaitedLine;
 }
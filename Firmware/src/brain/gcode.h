@@ -2,18 +2,26 @@
 #define GCODE_H
 #include <Arduino.h>
 #include "brain_config.h"    // 使用brain_config.h中的定义
+#include "gcode_line.h"
 
 // #define NUMBER_OF_FEEDER 50 // 已在brain_config.h中定义
 
 #define MCODE_ADVANCE 600 // 送料指令
 #define MCODE_SET_FEEDER_ENABLE 610 // 启用或禁用送料器
 #define MCODE_GET_FEEDER_ID 620 // 获取全部在线送料器ID
+#define MCODE_GET_FEEDER_STATE 621 // 查询单个送料器状态（Brain缓存，不等待Hand）
 // #define MCODE_LIST_UNASSIGNED 630 // 列出未分配ID的Hand - 已迁移到Web界面
 // #define MCODE_SET_HAND_ID 631 // 设置Hand的Feeder ID - 已迁移到Web界面
+#define MCODE_CALIBRATE_SETTLE 640 // 稳定时间校准：S1开始 S0结束 无S查询
+#define MCODE_PICK_FAILED 641 // 报告取料失败（校准模式下用于判断定位是否正确）
 
 
-void listenToSerialStream();
-void sendAnswer(uint8_t error, String message);
+void gcode_setup();                         // 创建输入队列并注册串口接收事件
+bool queueGcodeLine(const GcodeLine& line); // 在接收回调中调用，队列满时返回false
+void processGcodeLines();                   // 在主循环中处理已收到的完整行
+bool waitForGcodeLine(uint32_t timeoutMs);  // 等待新行到达（代替主循环末尾的delay），有新行时提前返回true
+void sendAnswer(uint8_t error, const char* message);
 void sendAnswer(int error, const __FlashStringHelper* message);
+inline void sendAnswer(uint8_t error, const String& message) { sendAnswer(error, message.c_str()); }
 void processCommand();
 #endif // GCODE_H
\ No newline at end of file
@@ -0,0 +1,79 @@
+#ifndef GCODE_LINE_H
+#define GCODE_LINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "brain_config.h"
+#include "line_assembler.h"
+
+// =============================================================================
+// G-code行接收 - 串口和TCP的接收回调共用，不依赖Arduino，不分配内存
+// =============================================================================
+
+// G-code输入来源
+typedef enum {
+    GCODE_SOURCE_SERIAL = 0,
+    GCODE_SOURCE_TCP = 1
+} GcodeSource;
+
+// 已拼好的一行G-code：TCP和串口在各自的接收回调中拼行，放入同一个队列由主循环依次处理
+struct GcodeLine {
+    char text[MAX_GCODE_LINE_LENGTH + 1];
+    uint32_t rxStartUs;                 // 第一个字节的到达时间（链路追踪）
+    uint32_t rxEndUs;                   // 换行符的到达时间
+    uint8_t source;                     // GcodeSource
+    bool overflow;                      // 超过MAX_GCODE_LINE_LENGTH被截断
+};
+
+#define GCODE_BUSY_REPLY "error busy\r\n"   // 行队列已满时立即回复给该行的来源
+
+// 把收到的字节拼成GcodeLine交给queue。OpenPnP每行都等待ok/error，
+// 所以队列满时不能丢弃了事，而是通过reply立即回复GCODE_BUSY_REPLY
+class GcodeLineReceiver {
+private:
+    LineAssembler<MAX_GCODE_LINE_LENGTH> assembler;
+    uint32_t lineStartUs = 0;
+    uint32_t busyCount = 0;
+    uint8_t source;
+    bool (*queue)(const GcodeLine& line);
+    void (*reply)(const char* data, size_t length);
+
+public:
+    GcodeLineReceiver(uint8_t source, bool (*queue)(const GcodeLine& line),
+                      void (*reply)(const char* data, size_t length))
+        : source(source), queue(queue), reply(reply) {}
+
+    // 输入一段数据，nowUs为这段数据的到达时间，返回其中完整行的数量
+    size_t receive(const char* bytes, size_t length, uint32_t nowUs) {
+        size_t lines = 0;
+        for (size_t i = 0; i < length; i++) {
+            if (assembler.isLineStart()) {
+                lineStartUs = nowUs;
+            }
+            if (!assembler.push(bytes[i])) {
+                continue;
+            }
+
+            GcodeLine line;
+            memcpy(line.text, assembler.line(), assembler.lineLength() + 1);
+            line.rxStartUs = lineStartUs;
+            line.rxEndUs = nowUs;
+            line.source = source;
+            line.overflow = assembler.isOverflow();
+            if (!queue(line)) {
+                busyCount++;
+                reply(GCODE_BUSY_REPLY, sizeof(GCODE_BUSY_REPLY) - 1);
+            }
+            lines++;
+        }
+        return lines;
+    }
+
+    // 新连接开始时丢弃上一个连接未完成的行
+    void reset() { assembler.reset(); }
+
+    uint32_t getBusyCount() const { return busyCount; }
+};
+
+#endif // GCODE_LINE_H
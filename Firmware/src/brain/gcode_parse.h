@@ -0,0 +1,65 @@
+#ifndef GCODE_PARSE_H
+#define GCODE_PARSE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// =============================================================================
+// G-code参数解析 - 纯计算，不依赖Arduino，不分配内存
+// =============================================================================
+
+// 在line中查找字符code，读取其后紧跟的数值；未找到时返回defaultVal
+// 与原String::substring().toFloat()实现行为一致：code后紧跟空格或行尾时返回0
+inline float parseGcodeParameter(const char* line, char code, float defaultVal)
+{
+    const char* found = strchr(line, code);
+    if (found == nullptr) {
+        return defaultVal;
+    }
+
+    const char* number = found + 1;
+    if (*number == '\0' || *number == ' ') {
+        return 0;
+    }
+    return strtof(number, nullptr);
+}
+
+// Feeder编号检查：-1表示未给出（mandatory时无效），其余必须在[0, feederCount)内
+inline bool isValidFeederNumber(int8_t signedFeederNo, bool mandatory, uint8_t feederCount)
+{
+    if (signedFeederNo == -1 && mandatory) {
+        return false;
+    }
+    return signedFeederNo >= 0 && signedFeederNo < feederCount;
+}
+
+// M600 N<feeder> F<length> X<override>的参数
+struct FeedAdvanceArgs {
+    uint8_t feederNo;
+    uint8_t feedLength;
+    bool overrideError;
+};
+
+// 解析并检查M600参数，有效时返回nullptr，否则返回回复给OpenPnP的错误消息
+inline const char* parseFeedAdvanceArgs(const char* line, uint8_t feederCount, FeedAdvanceArgs& args)
+{
+    int8_t signedFeederNo = (int)parseGcodeParameter(line, 'N', -1);
+    int8_t overrideErrorRaw = (int)parseGcodeParameter(line, 'X', -1);
+    if (!isValidFeederNumber(signedFeederNo, true, feederCount)) {
+        return "feederNo missing or invalid";
+    }
+
+    // 未给出F时送2mm；送料长度必须为2的倍数且在2-24mm范围内
+    uint8_t feedLength = (uint8_t)parseGcodeParameter(line, 'F', 2);
+    if ((feedLength % 2) != 0 || feedLength < 2 || feedLength > 24) {
+        return "Invalid feedLength, must be even number 2-24";
+    }
+
+    args.feederNo = (uint8_t)signedFeederNo;
+    args.feedLength = feedLength;
+    args.overrideError = overrideErrorRaw >= 1;
+    return nullptr;
+}
+
+#endif // GCODE_PARSE_H
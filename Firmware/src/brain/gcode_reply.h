@@ -0,0 +1,37 @@
+#ifndef GCODE_REPLY_H
+#define GCODE_REPLY_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "../common/udp_packets.h"
+
+// =============================================================================
+// G-code回复格式化 - 写入调用者的固定缓冲区，不依赖Arduino，不分配内存
+// =============================================================================
+
+// sendAnswer的回复行："ok <message>\r\n"或"error <message>\r\n"，message为空时只有前缀
+// 返回snprintf的结果：>= size表示缓冲区放不下（内容已截断）
+inline int formatGcodeAnswer(char* buffer, size_t size, uint8_t error, const char* message)
+{
+    const char* prefix = (error == 0) ? "ok" : "error";
+    return snprintf(buffer, size, message[0] ? "%s %s\r\n" : "%s\r\n", prefix, message);
+}
+
+// handleHandResponse回复TCP客户端的一行（不含换行符），commandType为在途命令的类型
+// response.message不保证以'\0'结尾，按字段长度截断
+inline int formatHandReply(char* buffer, size_t size, uint8_t commandType, const ESPNowResponse& response)
+{
+    int messageLength = strnlen(response.message, sizeof(response.message));
+    if (response.status == STATUS_OK) {
+        return snprintf(buffer, size, commandType == CMD_FEEDER_ADVANCE ? "ok Feed completed - %.*s" : "ok %.*s",
+                        messageLength, response.message);
+    }
+    if (response.reason != REASON_NONE) {
+        return snprintf(buffer, size, "error %.*s (%s)", messageLength, response.message,
+                        getErrorReasonName(response.reason));
+    }
+    return snprintf(buffer, size, "error %.*s", messageLength, response.message);
+}
+
+#endif // GCODE_REPLY_H
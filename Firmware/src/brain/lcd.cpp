@@ -1,12 +1,18 @@
 
 #include "lcd.h"
+#include "brain_log.h"
 #if HAS_LCD
 #include <LCDI2C_Multilingual_MCD.h>
 #include <WiFi.h>
+#include <Wire.h>
+#include "lcd_framebuffer.h"
 
 // LCD对象 - 修改为1602 (16列2行)
 LCDI2C_Generic lcd(0x27, 16, 2);
 
+// 显示函数只写入帧缓冲，lcd_update每次只把少量变化的字符发送到LCD
+static LcdFramebuffer<16, 2> screen;
+
 // 全局状态变量
 static LCDDisplayMode current_mode = LCD_MODE_STARTUP;
 static SystemStatus system_status = SYSTEM_INIT;
@@ -14,8 +20,8 @@ static int online_hands = 0;
 static int total_hands = 0;
 static unsigned long startup_time = 0;
 static String error_message = "";
-static String current_gcode = "";
-static String gcode_status = "";
+static char current_gcode[MAX_GCODE_LINE_LENGTH + 1] = "";
+static char gcode_status[GCODE_REPLY_BUFFER_SIZE] = "";
 static unsigned long gcode_display_time = 0;
 static int gcode_scroll_offset = 0;                // 用于滚动显示
 static unsigned long heartbeat_animation_time = 0; // 心跳动画时间
@@ -91,6 +97,7 @@ uint8_t tcp_disconnected_char[8] = {
 void lcd_setup()
 {
     lcd.init();
+    Wire.setClock(LCD_I2C_CLOCK_HZ); // PCF8574支持400kHz，缩短每次传输的时间
     lcd.backlight();
 
     // 创建自定义字符
@@ -101,16 +108,44 @@ void lcd_setup()
     lcd.createChar(4, tcp_connected_char);     // TCP连接图标
     lcd.createChar(5, tcp_disconnected_char);  // TCP断开图标
 
+    // init后屏幕为空白，与帧缓冲的初始内容一致
     startup_time = millis();
     lcd_show_startup();
 }
 
+// 把帧缓冲中变化的字符发送到LCD，每次最多LCD_FLUSH_CHARS个（含光标定位），剩余的留到下一轮循环
+static void lcd_flush()
+{
+    uint8_t budget = LCD_FLUSH_CHARS;
+    uint8_t chars[16];
+    uint8_t row;
+    uint8_t col;
+
+    while (budget > 1)
+    {
+        uint8_t length = screen.nextChangedRun(row, col, chars, budget - 1);
+        if (length == 0)
+        {
+            break;
+        }
+        lcd.setCursor(col, row);
+        for (uint8_t i = 0; i < length; i++)
+        {
+            lcd.write(chars[i]);
+        }
+        budget -= length + 1;
+    }
+}
+
 void lcd_update()
 {
+    // 每次调用都发送一小块变化的内容，不会长时间占用主循环
+    lcd_flush();
+
     static unsigned long last_update = 0;
     unsigned long now = millis();
 
-    // 每500ms更新一次显示
+    // 每秒刷新一次显示内容（只写入帧缓冲）
     if (now - last_update < 1000)
     {
         return;
@@ -139,7 +174,7 @@ void lcd_update()
     }
 
     case LCD_MODE_GCODE:
-        lcd_show_gcode(current_gcode.c_str(), gcode_status.c_str());
+        lcd_show_gcode(current_gcode, gcode_status);
         // G-code显示5秒后自动切换回状态显示
         if (now - gcode_display_time > 5000)
         {
@@ -149,74 +184,67 @@ void lcd_update()
     }
 }
 
+// 在当前位置显示text的前maxLength个字符
+static void printClipped(const char *text, size_t maxLength)
+{
+    screen.write((const uint8_t *)text, min(strlen(text), maxLength));
+}
+
 void lcd_show_startup()
 {
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("ESP-NOW PNP");
-    lcd.setCursor(0, 1);
-    lcd.print("Brain v");
-    lcd.print(BRAIN_VERSION);
-    lcd.write(1); // 显示OK图标
+    screen.clear();
+    screen.setCursor(0, 0);
+    screen.print("ESP-NOW PNP");
+    screen.setCursor(0, 1);
+    screen.print("Brain v");
+    screen.print(BRAIN_VERSION);
+    screen.write(1); // 显示OK图标
 }
 
 void lcd_show_system_info()
 {
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("ESP-NOW Ready");
-    lcd.write(1); // OK图标
+    screen.clear();
+    screen.setCursor(0, 0);
+    screen.print("ESP-NOW Ready");
+    screen.write(1); // OK图标
 
-    lcd.setCursor(0, 1);
-    lcd.print("MAC:");
+    screen.setCursor(0, 1);
+    screen.print("MAC:");
     String mac = WiFi.macAddress();
-    lcd.print(mac.substring(12)); // 显示后4位MAC
+    screen.print(mac.substring(12)); // 显示后4位MAC
 }
 
 void lcd_show_status(int online, int total, unsigned long uptime)
 {
-    // 使用静态变量记录上次显示的内容，避免不必要的更新
-    static unsigned long last_uptime = 0;
-    static bool last_heartbeat = false;
-
-    // 只清除并更新第一行
-    lcd.setCursor(0, 0);
-    lcd.print("                "); // 清除第一行
-
-    lcd.setCursor(0, 0);
-    lcd.print("Feeder:");
-    lcd.print(online);
-    lcd.print("/");
-    lcd.print(total);
+    // 整屏重画到帧缓冲，只有变化的字符会发送到LCD
+    screen.clear();
+    screen.setCursor(0, 0);
+    screen.print("Feeder:");
+    screen.print(online);
+    screen.print("/");
+    screen.print(total);
 
     // 显示连接状态指示
-    lcd.setCursor(12, 0);
+    screen.setCursor(12, 0);
     if (online == total && total > 0)
     {
-        lcd.write(1); // 全部在线 - OK图标
+        screen.write(1); // 全部在线 - OK图标
     }
     else if (online > 0)
     {
-        lcd.print("~"); // 部分在线
+        screen.print("~"); // 部分在线
     }
     else
     {
-        lcd.write(2); // 全部离线 - 错误图标
+        screen.write(2); // 全部离线 - 错误图标
     }
 
-    // TCP连接状态显示（在第13位置）- 每次都更新显示
-    lcd.setCursor(13, 0);
-    if (tcp_connected)
-    {
-        lcd.write(4); // TCP连接图标 - 字母T
-    }
-    else
-    {
-        lcd.write(5); // TCP断开图标 - 字母T带下划线
-    }
+    // TCP连接状态显示（在第13位置）
+    screen.setCursor(13, 0);
+    screen.write(tcp_connected ? 4 : 5); // 字母T / 字母T带下划线
 
-    // 心跳动画（在最后一个位置）- 独立更新
-    lcd.setCursor(15, 0);
+    // 心跳动画（在最后一个位置）
+    screen.setCursor(15, 0);
     if (online > 0)
     {
         // 每500ms切换一次心跳动画
@@ -227,190 +255,115 @@ void lcd_show_status(int online, int total, unsigned long uptime)
             heartbeat_animation = !heartbeat_animation;
             last_heartbeat_anim = now;
         }
+        screen.write(heartbeat_animation ? 3 : ' '); // 心形图标
+    }
 
-        // 只在心跳状态改变时更新
-        if (last_heartbeat != heartbeat_animation)
-        {
-            if (heartbeat_animation)
-            {
-                lcd.write(3); // 使用心形图标
-            }
-            else
-            {
-                lcd.print(" ");
-            }
-            last_heartbeat = heartbeat_animation;
-        }
+    // 第二行显示运行时间 (格式: XXh XXm 或 XXXXs)
+    screen.setCursor(0, 1);
+    screen.print("Up:");
+    if (uptime >= 3600)
+    {
+        screen.print(uptime / 3600);
+        screen.print("h ");
+        screen.print((uptime % 3600) / 60);
+        screen.print("m");
     }
-    else
+    else if (uptime >= 60)
     {
-        if (last_heartbeat != false)
-        {
-            lcd.print(" "); // 没有在线设备时不显示动画
-            last_heartbeat = false;
-        }
+        screen.print(uptime / 60);
+        screen.print("m ");
+        screen.print(uptime % 60);
+        screen.print("s");
     }
-
-    // 检查是否需要更新第二行（运行时间）
-    // 只在秒数变化时更新，减少更新频率
-    if (last_uptime != uptime)
+    else
     {
-        lcd.setCursor(0, 1);
-        lcd.print("                "); // 清除第二行
-
-        lcd.setCursor(0, 1);
-        lcd.print("Up:");
-
-        // 显示运行时间 (格式: XXh XXm 或 XXXXs)
-        if (uptime >= 3600)
-        {
-            lcd.print(uptime / 3600);
-            lcd.print("h ");
-            lcd.print((uptime % 3600) / 60);
-            lcd.print("m");
-        }
-        else if (uptime >= 60)
-        {
-            lcd.print(uptime / 60);
-            lcd.print("m ");
-            lcd.print(uptime % 60);
-            lcd.print("s");
-        }
-        else
-        {
-            lcd.print(uptime);
-            lcd.print("s");
-        }
-
-        last_uptime = uptime;
+        screen.print(uptime);
+        screen.print("s");
     }
 }
 
 void lcd_show_error(const char *error_msg)
 {
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.write(2); // 错误图标
-    lcd.print(" ERROR");
-
-    lcd.setCursor(0, 1);
-    String msg = String(error_msg);
-    if (msg.length() > 16)
-    {
-        lcd.print(msg.substring(0, 16));
-    }
-    else
-    {
-        lcd.print(msg);
-    }
+    screen.clear();
+    screen.setCursor(0, 0);
+    screen.write(2); // 错误图标
+    screen.print(" ERROR");
+
+    screen.setCursor(0, 1);
+    printClipped(error_msg, 16);
 }
 
 void lcd_show_gcode(const char *command, const char *status)
 {
-    // 清屏并显示G-code信息
-    lcd.clear();
+    // 清空帧缓冲并显示G-code信息
+    screen.clear();
 
-    if (strlen(status) > 0)
+    size_t statusLength = strlen(status);
+    if (statusLength > 0)
     {
         // 显示状态信息
-        lcd.setCursor(0, 0);
+        screen.setCursor(0, 0);
 
-        // 检查是否是Feed相关的状态消息
-        String statusStr = String(status);
-
-        // 处理包含 "Feed N" 的状态消息
-        if (statusStr.indexOf("Feed N") >= 0)
+        // 包含 "Feed N" 的状态消息超过16字符时滚动显示
+        bool scrolling = statusLength > 16 && strstr(status, "Feed N") != NULL;
+        if (scrolling)
         {
-            // 显示Feed状态，如果超过16字符则滚动显示
-            if (statusStr.length() > 16)
-            {
-                // 实现滚动显示
-                static unsigned long last_scroll_time = 0;
-                static int scroll_offset = 0;
-                unsigned long now = millis();
+            static unsigned long last_scroll_time = 0;
+            static size_t scroll_offset = 0;
+            unsigned long now = millis();
 
-                if (now - last_scroll_time > 800) // 每800ms滚动一次
+            if (now - last_scroll_time > 800) // 每800ms滚动一次
+            {
+                if (scroll_offset + 16 >= statusLength)
                 {
-                    if (scroll_offset + 16 >= statusStr.length())
-                    {
-                        scroll_offset = 0; // 重置滚动
-                    }
-                    else
-                    {
-                        scroll_offset++;
-                    }
-                    last_scroll_time = now;
+                    scroll_offset = 0; // 重置滚动
                 }
-
-                String displayText = statusStr.substring(scroll_offset, scroll_offset + 16);
-                lcd.print(displayText);
-
-                // 在右下角显示滚动指示器
-                lcd.setCursor(15, 1);
-                lcd.print(">");
+                else
+                {
+                    scroll_offset++;
+                }
+                last_scroll_time = now;
             }
-            else
+            if (scroll_offset >= statusLength)
             {
-                lcd.print(statusStr);
+                scroll_offset = 0;
             }
+
+            printClipped(status + scroll_offset, 16);
+
+            // 在右下角显示滚动指示器
+            screen.setCursor(15, 1);
+            screen.print(">");
         }
         else
         {
-            // 普通状态消息
-            if (strlen(status) <= 16)
-            {
-                lcd.print(status);
-            }
-            else
-            {
-                // 如果状态消息太长，显示前16个字符
-                String shortStatus = String(status).substring(0, 16);
-                lcd.print(shortStatus);
-            }
+            // 普通状态消息，太长时显示前16个字符
+            printClipped(status, 16);
         }
 
-        // 第二行显示命令（如果有）
-        if (strlen(command) > 0)
+        // 第二行显示命令（第一行没有滚动时）
+        if (strlen(command) > 0 && statusLength <= 16)
         {
-            lcd.setCursor(0, 1);
-            if (statusStr.length() <= 16) // 第一行没有滚动时才显示命令
-            {
-                lcd.print("Cmd: ");
-                if (strlen(command) <= 11)
-                {
-                    lcd.print(command);
-                }
-                else
-                {
-                    String shortCommand = String(command).substring(0, 11);
-                    lcd.print(shortCommand);
-                }
-            }
+            screen.setCursor(0, 1);
+            screen.print("Cmd: ");
+            printClipped(command, 11);
         }
     }
     else if (strlen(command) > 0)
     {
         // 只显示命令
-        lcd.setCursor(0, 0);
-        lcd.print("G-Code:");
-        lcd.setCursor(0, 1);
-        if (strlen(command) <= 16)
-        {
-            lcd.print(command);
-        }
-        else
-        {
-            String shortCommand = String(command).substring(0, 16);
-            lcd.print(shortCommand);
-        }
+        screen.setCursor(0, 0);
+        screen.print("G-Code:");
+        screen.setCursor(0, 1);
+        printClipped(command, 16);
     }
     else
     {
         // 没有命令和状态时的默认显示
-        lcd.setCursor(0, 0);
-        lcd.print("G-Code Mode");
-        lcd.setCursor(0, 1);
-        lcd.print("Ready...");
+        screen.setCursor(0, 0);
+        screen.print("G-Code Mode");
+        screen.setCursor(0, 1);
+        screen.print("Ready...");
     }
 }
 
@@ -418,7 +371,7 @@ void lcd_set_mode(LCDDisplayMode mode)
 {
     current_mode = mode;
 
-    // 根据模式立即显示相应内容
+    // 根据模式立即绘制相应内容（下一次lcd_update开始发送）
     switch (mode)
     {
     case LCD_MODE_STARTUP:
@@ -434,7 +387,7 @@ void lcd_set_mode(LCDDisplayMode mode)
         break;
     }
     case LCD_MODE_GCODE:
-        lcd_show_gcode(current_gcode.c_str(), gcode_status.c_str());
+        lcd_show_gcode(current_gcode, gcode_status);
         break;
     }
 }
@@ -464,8 +417,11 @@ void lcd_update_hand_count(int online, int total)
 
 void lcd_update_gcode(const char *command, const char *status)
 {
-    current_gcode = String(command);
-    gcode_status = String(status);
+    // 在sendAnswer中调用：只复制字符串和写帧缓冲，不做I2C传输
+    strncpy(current_gcode, command, sizeof(current_gcode) - 1);
+    current_gcode[sizeof(current_gcode) - 1] = '\0';
+    strncpy(gcode_status, status, sizeof(gcode_status) - 1);
+    gcode_status[sizeof(gcode_status) - 1] = '\0';
     gcode_display_time = millis();
     gcode_scroll_offset = 0; // 重置滚动偏移量
 
@@ -486,31 +442,22 @@ void triggerHeartbeatAnimation()
     // 如果当前在状态显示模式，立即更新心跳指示器位置
     if (current_mode == LCD_MODE_STATUS)
     {
-        lcd.setCursor(15, 0); // 心跳指示器位置 (最后一列)
-        lcd.write(3);         // 显示心形图标
+        screen.setCursor(15, 0); // 心跳指示器位置 (最后一列)
+        screen.write(3);         // 显示心形图标
     }
 }
 
 void lcd_update_tcp_status(bool connected)
 {
     tcp_connected = connected;
-    Serial.printf("LCD TCP status updated: %s\n", connected ? "Connected" : "Disconnected");
-    
+    LOG_DEBUG(LCD, "LCD TCP status updated: %s", connected ? "Connected" : "Disconnected");
+
     // 如果在状态显示模式，立即更新TCP状态指示器
     if (current_mode == LCD_MODE_STATUS)
     {
-        lcd.setCursor(13, 0); // TCP状态指示器位置
-        if (connected)
-        {
-            lcd.write(4); // TCP连接图标 - 字母T
-            Serial.println("LCD: Displaying 'T' for TCP connected");
-        }
-        else
-        {
-            lcd.write(5); // TCP断开图标 - 字母T带下划线
-            Serial.println("LCD: Displaying 'T_' for TCP disconnected");
-        }
+        screen.setCursor(13, 0); // TCP状态指示器位置
+        screen.write(connected ? 4 : 5); // 字母T / 字母T带下划线
     }
 }
 
-#endif // HAS_LCD
\ No newline at end of file
+#endif // HAS_LCD
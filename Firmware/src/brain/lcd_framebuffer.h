@@ -0,0 +1,83 @@
+#ifndef LCD_FRAMEBUFFER_H
+#define LCD_FRAMEBUFFER_H
+
+#include <Arduino.h>
+
+// =============================================================================
+// LCD影子帧缓冲 - 显示函数只写入内存，flush时逐块找出与屏幕不同的字符发送
+// 接口与LCD库的setCursor/print/write一致，自定义字符(0-7)直接写入字节值
+// =============================================================================
+
+template <uint8_t COLS, uint8_t ROWS>
+class LcdFramebuffer : public Print {
+private:
+    uint8_t target[ROWS][COLS];         // 希望显示的内容
+    uint8_t shown[ROWS][COLS];          // 屏幕上当前的内容
+    uint8_t cursorCol = 0;
+    uint8_t cursorRow = 0;
+    uint8_t scanRow = 0;                // 下一次查找差异的起始位置
+    uint8_t scanCol = 0;
+
+public:
+    LcdFramebuffer() {
+        memset(target, ' ', sizeof(target));
+        memset(shown, ' ', sizeof(shown));
+    }
+
+    // 只清空帧缓冲，不向LCD发送清屏命令
+    void clear() {
+        memset(target, ' ', sizeof(target));
+        cursorCol = 0;
+        cursorRow = 0;
+    }
+
+    void setCursor(uint8_t col, uint8_t row) {
+        cursorCol = col;
+        cursorRow = row;
+    }
+
+    // 超出行尾的字符丢弃（与LCD不同，不会写到屏幕外的DDRAM）
+    size_t write(uint8_t c) override {
+        if (cursorRow >= ROWS || cursorCol >= COLS) {
+            return 1;
+        }
+        target[cursorRow][cursorCol++] = c;
+        return 1;
+    }
+    using Print::write;
+
+    bool isDirty() const {
+        return memcmp(target, shown, sizeof(target)) != 0;
+    }
+
+    // 从上次位置继续查找下一段连续的不同字符，最多maxLength个，
+    // 找到时填写位置和内容并视为已显示，返回字符数；没有差异时返回0
+    uint8_t nextChangedRun(uint8_t& row, uint8_t& col, uint8_t* chars, uint8_t maxLength) {
+        for (uint8_t scanned = 0; scanned < ROWS * COLS; scanned++) {
+            uint8_t r = scanRow;
+            uint8_t c = scanCol;
+            if (++scanCol >= COLS) {
+                scanCol = 0;
+                scanRow = (scanRow + 1) % ROWS;
+            }
+            if (target[r][c] == shown[r][c]) {
+                continue;
+            }
+
+            uint8_t length = 0;
+            while (c + length < COLS && length < maxLength && target[r][c + length] != shown[r][c + length]) {
+                chars[length] = target[r][c + length];
+                shown[r][c + length] = target[r][c + length];
+                length++;
+            }
+            row = r;
+            col = c;
+            scanRow = (c + length >= COLS) ? (r + 1) % ROWS : r;
+            scanCol = (c + length >= COLS) ? 0 : c + length;
+            return length;
+        }
+        return 0;
+    }
+};
+
+#endif // LCD_FRAMEBUFFER_H
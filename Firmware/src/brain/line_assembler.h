@@ -0,0 +1,71 @@
+#ifndef LINE_ASSEMBLER_H
+#define LINE_ASSEMBLER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// =============================================================================
+// G-code行拼装 - 固定缓冲区逐字节拼出完整行，不依赖Arduino，不分配内存
+// =============================================================================
+
+template <size_t N>
+class LineAssembler {
+private:
+    char buffer[N + 1];
+    size_t length = 0;
+    bool overflow = false;              // 本行超过N字节，多余部分已丢弃
+    bool started = false;               // 本行已收到第一个非空白字符
+
+public:
+    // 输入一个字节，得到非空的完整行时返回true，此时可读取line()，下一次push前有效
+    // 去掉\r和首尾空白；超长行返回true且isOverflow()为true，内容为截断后的前N字节
+    bool push(char c) {
+        if (c == '\n') {
+            if (!started) {
+                // 空行
+                reset();
+                return false;
+            }
+            // 去掉行尾空白
+            while (length > 0 && (buffer[length - 1] == ' ' || buffer[length - 1] == '\t')) {
+                length--;
+            }
+            buffer[length] = '\0';
+            started = false;
+            return true;
+        }
+
+        if (c == '\r' || (!started && (c == ' ' || c == '\t'))) {
+            return false;
+        }
+        if (!started) {
+            // 新一行的第一个有效字符，清空上一行
+            length = 0;
+            overflow = false;
+            started = true;
+        }
+
+        if (length < N) {
+            buffer[length++] = c;
+        } else {
+            overflow = true;
+        }
+        return false;
+    }
+
+    // 当前行是否刚开始（用于记录第一个字节的到达时间）
+    bool isLineStart() const { return !started; }
+
+    const char* line() const { return buffer; }
+    size_t lineLength() const { return length; }
+    bool isOverflow() const { return overflow; }
+
+    void reset() {
+        length = 0;
+        overflow = false;
+        started = false;
+        buffer[0] = '\0';
+    }
+};
+
+#endif // LINE_ASSEMBLER_H
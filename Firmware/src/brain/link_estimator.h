@@ -0,0 +1,73 @@
+#ifndef LINK_ESTIMATOR_H
+#define LINK_ESTIMATOR_H
+
+#include <stdint.h>
+
+// =============================================================================
+// 命令超时估计 - 每个Hand的往返时间和每个Feeder的送料动作耗时，
+// 由brain_udp.cpp用于计算重发间隔和等待响应的时间
+// =============================================================================
+
+// 往返时间的平滑值和平均偏差（Jacobson/Karels算法，与TCP的重传超时计算相同），单位微秒
+struct RttEstimator {
+    uint32_t srttUs;                    // 平滑往返时间
+    uint32_t rttvarUs;                  // 平均偏差
+    uint32_t samples;                   // 样本数，0表示还没有测量
+
+    void addSample(uint32_t rttUs) {
+        if (samples == 0) {
+            srttUs = rttUs;
+            rttvarUs = rttUs / 2;
+        } else {
+            uint32_t error = rttUs > srttUs ? rttUs - srttUs : srttUs - rttUs;
+            rttvarUs = rttvarUs - rttvarUs / 4 + error / 4;
+            srttUs = srttUs - srttUs / 8 + rttUs / 8;
+        }
+        samples++;
+    }
+
+    // 重传超时 = 平滑值 + 4倍偏差，没有样本时用initialMs
+    uint32_t rtoMs(uint32_t initialMs, uint32_t minMs, uint32_t maxMs) const {
+        if (samples == 0) {
+            return initialMs;
+        }
+        uint32_t ms = (srttUs + 4 * rttvarUs + 999) / 1000;
+        return ms < minMs ? minMs : (ms > maxMs ? maxMs : ms);
+    }
+};
+
+// 送料动作耗时模型：每mm耗时的平滑值和预测偏差，单位微秒
+struct ActuationModel {
+    uint32_t usPerMm;
+    uint32_t devUs;                     // 预测值与实际耗时之差的平均
+    uint32_t samples;
+
+    void addSample(uint8_t lengthMm, uint32_t durationUs) {
+        if (lengthMm == 0) {
+            return;
+        }
+        uint32_t perMm = durationUs / lengthMm;
+        if (samples == 0) {
+            usPerMm = perMm;
+            devUs = durationUs / 4;
+        } else {
+            uint32_t predicted = usPerMm * lengthMm;
+            uint32_t error = durationUs > predicted ? durationUs - predicted : predicted - durationUs;
+            devUs = devUs - devUs / 4 + error / 4;
+            usPerMm = usPerMm - usPerMm / 8 + perMm / 8;
+        }
+        samples++;
+    }
+
+    // 预计耗时加4倍偏差（至少minMarginMs），没有样本时按defaultUsPerMm估计
+    uint32_t budgetMs(uint8_t lengthMm, uint32_t defaultUsPerMm, uint32_t minMarginMs) const {
+        uint32_t perMm = samples > 0 ? usPerMm : defaultUsPerMm;
+        uint32_t marginMs = samples > 0 ? 4 * devUs / 1000 : 0;
+        if (marginMs < minMarginMs) {
+            marginMs = minMarginMs;
+        }
+        return perMm * lengthMm / 1000 + marginMs;
+    }
+};
+
+#endif // LINK_ESTIMATOR_H
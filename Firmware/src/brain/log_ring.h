@@ -0,0 +1,69 @@
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// =============================================================================
+// 延迟日志记录 - 只保存格式字符串指针和整数参数，输出时再格式化
+// 不依赖Arduino，不分配内存；加锁由调用方负责
+// =============================================================================
+
+#define LOG_MAX_ARGS 4
+
+struct LogRecord {
+    uint32_t timeUs;                    // 记录时间(micros)
+    const char* format;                 // 格式字符串（常量，地址即格式ID）
+    uint8_t level;
+    uint8_t argCount;
+    uint32_t args[LOG_MAX_ARGS];
+};
+
+// 固定容量记录队列，写满后丢弃新记录并计数
+template <size_t N>
+class LogRing {
+private:
+    LogRecord records[N];
+    size_t head = 0;                    // 最旧记录的位置
+    size_t count = 0;
+    uint32_t dropped = 0;
+
+public:
+    bool push(const LogRecord& record) {
+        if (count >= N) {
+            dropped++;
+            return false;
+        }
+        records[(head + count) % N] = record;
+        count++;
+        return true;
+    }
+
+    // 查看最旧的记录，队列为空时返回false
+    bool peek(LogRecord& record) const {
+        if (count == 0) {
+            return false;
+        }
+        record = records[head];
+        return true;
+    }
+
+    void pop() {
+        if (count > 0) {
+            head = (head + 1) % N;
+            count--;
+        }
+    }
+
+    // 读取并清零丢弃计数
+    uint32_t takeDropped() {
+        uint32_t value = dropped;
+        dropped = 0;
+        return value;
+    }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return N; }
+};
+
+#endif // LOG_RING_H
@@ -0,0 +1,39 @@
+#ifndef PENDING_COMMAND_H
+#define PENDING_COMMAND_H
+
+#include <stdint.h>
+#include "../common/espnow_protocol.h"
+
+// =============================================================================
+// 等待Hand响应的命令表 - 纯计算，不依赖Arduino，确认和响应按序列号+Feeder ID匹配
+// =============================================================================
+
+struct PendingCommand {
+    uint32_t sequence;
+    uint8_t feederId;
+    uint32_t sentTime;
+    uint32_t timeoutMs;   // 从sentTime算起等待响应的时间，收到确认后按送料耗时模型重新计算
+    bool waiting;
+    bool needTcpReply;    // 是否需要TCP回复
+    uint8_t lineCount;    // 合并到这条命令的G-code行数，每行都要回复
+    uint8_t commandType;  // 命令类型，用于生成回复消息
+    uint8_t feedLength;   // 送料长度（送料耗时模型的样本）
+    bool acked;           // 已收到Hand的确认
+    uint8_t retries;      // 已重发次数，重发过的命令不作为往返时间样本
+    bool ackGaveUp;       // 重发用完仍未确认：Hand可能已在送料，不再重发，等到超时再判定失败
+    uint32_t lastSendTime;
+    uint32_t sentUs;      // 首次发送时间（往返时间样本）
+    ESPNowPacket command; // 重发用
+};
+
+// 查找等待feederId的sequence响应的命令，没有时返回-1
+inline int findPendingCommand(const PendingCommand* commands, int count, uint32_t sequence, uint8_t feederId) {
+    for (int i = 0; i < count; i++) {
+        if (commands[i].waiting && commands[i].sequence == sequence && commands[i].feederId == feederId) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#endif // PENDING_COMMAND_H
@@ -1,7 +1,10 @@
 #ifndef COMMON_CONFIG_H
 #define COMMON_CONFIG_H
 
+// 配置文件只有宏定义，主机单元测试（pio test -e native）不带Arduino.h也能包含
+#ifdef ARDUINO
 #include <Arduino.h>
+#endif
 
 // =============================================================================
 // 通用配置 - 所有设备共享
@@ -13,13 +16,20 @@
 // 喂料器系统配置
 #define TOTAL_FEEDERS 50        // 总喂料器数量
 #define NUMBER_OF_FEEDER 50     // 支持的喂料器总数（与TOTAL_FEEDERS保持一致）
-#define FEEDERS_PER_HAND 1      // 每个手控制的喂料器数量
+#ifndef FEEDERS_PER_HAND
+#define FEEDERS_PER_HAND 1      // 每个手控制的喂料器数量（多通道Hand通过编译标志设置）
+#endif
 
 // WiFi配置 - 统一配置点
 #define WIFI_SSID "WIFI_SSID"  // WiFi SSID
 #define WIFI_PASSWORD "WIFI_PASSWORD"
 #define WIFI_POWER_MAX true     // 设置WiFi功率到最大
 
+// ESP-NOW传输配置（见common/espnow_transport.h）
+#define ESPNOW_MAX_PAYLOAD 250      // ESP-NOW单帧最大载荷
+#define ESPNOW_RX_QUEUE_DEPTH 8     // 接收队列深度（每项约260字节）
+#define ESPNOW_MAX_PEERS 16         // 同时登记的对端数量，满时替换最久未用的（芯片上限为20）
+
 // 超时配置
 #define COMMAND_TIMEOUT_MS 2000
 #define HEARTBEAT_INTERVAL_MS 5000
@@ -28,12 +38,16 @@
 // 默认喂料器参数
 #define DEFAULT_FULL_ADVANCE_ANGLE 90
 #define DEFAULT_RETRACT_ANGLE 0
+#define DEFAULT_HALF_ADVANCE_ANGLE 45   // 半步推进位置(2mm)，约为推进角的一半，需按机构微调
+#define FEEDER_MECHANICAL_ADVANCE_LENGTH 4 // 一次完整推进的长度(mm)，由机构决定
 #define DEFAULT_FEED_LENGTH 4
 #define DEFAULT_SETTLE_TIME 300
 
 // EEPROM配置
 #define EEPROM_SIZE 512         // EEPROM大小
 #define FEEDER_ID_ADDR 0        // Feeder ID存储地址
+#define SETTLE_TIME_MAGIC_ADDR 4 // 稳定时间已校准标识地址
+#define SETTLE_TIME_ADDR 8      // 稳定时间存储起始地址（每个喂料器一个uint16_t）
 
 // 调试配置宏定义
 #define DEBUG_MODE_ENABLED 1    // 开发模式
@@ -1,7 +1,7 @@
 #ifndef ESPNOW_PROTOCOL_H
 #define ESPNOW_PROTOCOL_H
 
-#include <Arduino.h>
+#include <stdint.h>
 
 // =============================================================================
 // ESP-NOW通信协议定义
@@ -18,6 +18,8 @@ typedef enum {
     CMD_SET_FEEDER_ID = 0x0B,        // 设置喂料器ID命令
     CMD_LIST_UNASSIGNED = 0x0C,      // 列出未分配ID的Hand
     CMD_FIND_ME = 0x0D,              // Find Me LED指示命令
+    CMD_CALIBRATE_SETTLE = 0x0E,     // 稳定时间校准命令(feedLength: 0=停止 1=开始 2=查询)
+    CMD_PICK_FAILED = 0x0F,          // OpenPnP取料失败报告
 } ESPNowCommandType;
 
 // 状态码枚举
@@ -29,12 +31,24 @@ typedef enum {
     STATUS_INVALID_PARAM = 0x04
 } ESPNowStatusCode;
 
+// 错误原因码 - status非STATUS_OK时由ESPNowResponse.reason给出具体原因
+typedef enum {
+    REASON_NONE = 0x00,
+    REASON_TAPE_ERROR = 0x01,        // 反馈线报告盖膜未卷紧(卡料或料带用完)
+    REASON_INVALID_LENGTH = 0x02,    // 送料长度不是半步的整数倍
+    REASON_QUEUE_FULL = 0x03,        // Hand送料队列已满
+} ESPNowErrorReason;
+
+// 命令标志位(ESPNowPacket.flags)
+#define CMD_FLAG_OVERRIDE_ERROR 0x01 // 忽略反馈线错误继续送料(M600 X1)
+
 // ESP-NOW数据包结构 (保持32字节以内以提高可靠性)
 struct ESPNowPacket {
     uint8_t commandType;             // 命令类型
     uint8_t feederId;                // 喂料器ID (用于注册)
     uint8_t feedLength;              // 喂料长度
-    uint8_t reserved[4];             // 保留字段
+    uint8_t flags;                   // 命令标志位(CMD_FLAG_*)，旧固件为0
+    uint8_t reserved[3];             // 保留字段
 } __attribute__((packed));
 
 // 响应数据包结构
@@ -42,7 +56,8 @@ struct ESPNowResponse {
     uint8_t handId;                  // 手部ID
     uint8_t commandType;             // 原始命令类型
     uint8_t status;                  // 状态码
-    uint8_t reserved[3];             // 保留字段
+    uint8_t reason;                  // 错误原因码(ESPNowErrorReason)
+    uint8_t reserved[2];             // 保留字段
     uint32_t sequence;               // 对应的序列号
     uint32_t timestamp;              // 时间戳
     char message[16];                // 状态消息
@@ -0,0 +1,151 @@
+#include "espnow_transport.h"
+#if defined ESP32
+#include <WiFi.h>
+#include <esp_now.h>
+#include <esp_idf_version.h>
+#elif defined ESP8266
+#include <ESP8266WiFi.h>
+#include <espnow.h>
+#endif
+
+// 接收队列：回调（WiFi任务）写入，主循环读取，单生产者单消费者不需要加锁
+struct EspNowFrame {
+    uint8_t mac[6];
+    uint8_t length;
+    uint8_t data[ESPNOW_MAX_PAYLOAD];
+};
+
+static EspNowFrame rxQueue[ESPNOW_RX_QUEUE_DEPTH];
+static volatile uint8_t rxHead = 0;         // 回调写入位置
+static volatile uint8_t rxTail = 0;         // 主循环读取位置
+static volatile uint32_t rxDropped = 0;
+
+// 已登记的对端（单播前必须登记）
+struct EspNowPeer {
+    uint8_t mac[6];
+    uint32_t lastUsed;
+    bool used;
+};
+
+static EspNowPeer peers[ESPNOW_MAX_PEERS];
+
+static void queueFrame(const uint8_t* mac, const uint8_t* data, int length) {
+    uint8_t next = (rxHead + 1) % ESPNOW_RX_QUEUE_DEPTH;
+    if (next == rxTail || length <= 0 || length > ESPNOW_MAX_PAYLOAD) {
+        rxDropped++;
+        return;
+    }
+    EspNowFrame& frame = rxQueue[rxHead];
+    memcpy(frame.mac, mac, sizeof(frame.mac));
+    frame.length = length;
+    memcpy(frame.data, data, length);
+    __sync_synchronize();                   // 数据写完后再移动写入位置
+    rxHead = next;
+}
+
+#if defined ESP32
+#if ESP_IDF_VERSION_MAJOR >= 5
+static void onReceive(const esp_now_recv_info_t* info, const uint8_t* data, int length) {
+    queueFrame(info->src_addr, data, length);
+}
+#else
+static void onReceive(const uint8_t* mac, const uint8_t* data, int length) {
+    queueFrame(mac, data, length);
+}
+#endif
+#elif defined ESP8266
+static void onReceive(uint8_t* mac, uint8_t* data, uint8_t length) {
+    queueFrame(mac, data, length);
+}
+#endif
+
+static bool addPeer(const uint8_t* mac) {
+#if defined ESP32
+    esp_now_peer_info_t info;
+    memset(&info, 0, sizeof(info));
+    memcpy(info.peer_addr, mac, sizeof(info.peer_addr));
+    info.channel = 0;                       // 使用当前信道
+    info.ifidx = WIFI_IF_STA;
+    info.encrypt = false;
+    return esp_now_add_peer(&info) == ESP_OK;
+#elif defined ESP8266
+    return esp_now_add_peer((uint8_t*)mac, ESP_NOW_ROLE_COMBO, WiFi.channel(), NULL, 0) == 0;
+#endif
+}
+
+// 确保对端已登记，登记表满时替换最久未用的对端
+static bool ensurePeer(const uint8_t* mac) {
+    uint32_t now = millis();
+    int freeSlot = -1;
+    int oldest = -1;
+    for (int i = 0; i < ESPNOW_MAX_PEERS; i++) {
+        if (!peers[i].used) {
+            if (freeSlot < 0) {
+                freeSlot = i;
+            }
+        } else if (memcmp(peers[i].mac, mac, sizeof(peers[i].mac)) == 0) {
+            peers[i].lastUsed = now;
+            return true;
+        } else if (oldest < 0 || now - peers[i].lastUsed > now - peers[oldest].lastUsed) {
+            oldest = i;
+        }
+    }
+
+    int slot = freeSlot;
+    if (slot < 0) {
+        slot = oldest;
+        esp_now_del_peer(peers[slot].mac);
+        peers[slot].used = false;
+    }
+    if (!addPeer(mac)) {
+        return false;
+    }
+    memcpy(peers[slot].mac, mac, sizeof(peers[slot].mac));
+    peers[slot].lastUsed = now;
+    peers[slot].used = true;
+    return true;
+}
+
+bool EspNowTransport::begin() {
+#if defined ESP32
+    if (esp_now_init() != ESP_OK) {
+        return false;
+    }
+#elif defined ESP8266
+    if (esp_now_init() != 0) {
+        return false;
+    }
+    esp_now_set_self_role(ESP_NOW_ROLE_COMBO);
+#endif
+    esp_now_register_recv_cb(onReceive);
+    return true;
+}
+
+bool EspNowTransport::send(const TransportAddress& to, const uint8_t* data, size_t length) {
+    if (to.type != TRANSPORT_ESPNOW || length > ESPNOW_MAX_PAYLOAD || !ensurePeer(to.bytes)) {
+        return false;
+    }
+#if defined ESP32
+    return esp_now_send(to.bytes, data, length) == ESP_OK;
+#elif defined ESP8266
+    return esp_now_send((uint8_t*)to.bytes, (uint8_t*)data, length) == 0;
+#endif
+}
+
+size_t EspNowTransport::receive(uint8_t* buffer, size_t size, TransportAddress& from) {
+    if (rxTail == rxHead) {
+        return 0;
+    }
+    const EspNowFrame& frame = rxQueue[rxTail];
+    from.type = TRANSPORT_ESPNOW;
+    memcpy(from.bytes, frame.mac, sizeof(from.bytes));
+    size_t length = frame.length < size ? frame.length : size;
+    memcpy(buffer, frame.data, length);
+    __sync_synchronize();                   // 数据读完后再释放该项
+    rxTail = (rxTail + 1) % ESPNOW_RX_QUEUE_DEPTH;
+    return length;
+}
+
+uint32_t EspNowTransport::droppedFrames() const {
+    return rxDropped;
+}
@@ -0,0 +1,25 @@
+#ifndef ESPNOW_TRANSPORT_H
+#define ESPNOW_TRANSPORT_H
+
+#include <Arduino.h>
+#include "common_config.h"
+#include "transport.h"
+
+// ESP-NOW传输实现：设备之间直接收发，不经过AP转发。
+// 需与WiFi STA在同一信道（Brain和Hand连接同一AP即可）；接收回调只把帧放入队列，由receive()在主循环中取出。
+// ESP-NOW回调是全局的，每台设备只能有一个实例
+class EspNowTransport : public Transport {
+public:
+    bool begin() override;
+    bool send(const TransportAddress& to, const uint8_t* data, size_t length) override;
+    size_t receive(uint8_t* buffer, size_t size, TransportAddress& from) override;
+
+    const char* name() const override {
+        return "espnow";
+    }
+
+    // 因接收队列满或超长而丢弃的帧数
+    uint32_t droppedFrames() const;
+};
+
+#endif // ESPNOW_TRANSPORT_H
@@ -0,0 +1,95 @@
+#ifndef FEED_TRACE_H
+#define FEED_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// =============================================================================
+// 送料链路追踪 - Brain与Hand共用的固定大小环形缓冲区
+// =============================================================================
+
+// 追踪阶段（按一次M600的先后顺序排列）
+typedef enum {
+    TRACE_GCODE_RECEIVED = 0,           // tcp_loop收到G-code行
+    TRACE_GCODE_PARSE = 1,              // processCommand解析参数
+    TRACE_SEND_TO_HAND = 2,             // sendCommandToHand发送UDP命令
+    TRACE_HAND_RECEIVE = 3,             // Hand收到命令到舵机开始动作
+    TRACE_SERVO_MOTION = 4,             // feedTapeAction舵机动作
+    TRACE_RESPONSE_SEND = 5,            // 舵机动作结束到Hand发出响应
+    TRACE_TCP_REPLY = 6,                // handleHandResponse回复TCP客户端
+    TRACE_STAGE_COUNT
+} FeedTraceStage;
+
+// 单个追踪区间（微秒时间戳）
+struct FeedTraceSpan {
+    uint32_t startUs;                   // 开始时间(micros)
+    uint32_t durationUs;                // 持续时间(us)
+    uint32_t sequence;                  // 对应的UDP命令序列号
+    uint8_t stage;                      // FeedTraceStage
+    uint8_t feederId;                   // 喂料器ID
+};
+
+// Hand在响应中回传的本端时间信息，均为相对响应发送时刻的偏移(us)
+struct UDPHandTiming {
+    uint32_t receiveOffsetUs;           // 收到命令距发送响应
+    uint32_t servoStartOffsetUs;        // 舵机开始距发送响应
+    uint32_t servoEndOffsetUs;          // 舵机结束距发送响应
+} __attribute__((packed));
+
+// 旧固件的响应不带timing（按0处理），这时不能作为往返时间和送料耗时样本
+inline bool hasHandTiming(const UDPHandTiming& timing) {
+    return timing.receiveOffsetUs != 0 || timing.servoStartOffsetUs != 0 || timing.servoEndOffsetUs != 0;
+}
+
+// 获取阶段名称（用于Chrome trace输出）
+inline const char* getFeedTraceStageName(uint8_t stage) {
+    switch (stage) {
+        case TRACE_GCODE_RECEIVED: return "gcode_received";
+        case TRACE_GCODE_PARSE:    return "gcode_parse";
+        case TRACE_SEND_TO_HAND:   return "send_to_hand";
+        case TRACE_HAND_RECEIVE:   return "hand_receive";
+        case TRACE_SERVO_MOTION:   return "servo_motion";
+        case TRACE_RESPONSE_SEND:  return "response_send";
+        case TRACE_TCP_REPLY:      return "tcp_reply";
+        default:                   return "unknown";
+    }
+}
+
+// 固定容量环形缓冲区，写满后覆盖最旧的记录，不做任何堆分配
+template <size_t N>
+class FeedTraceRing {
+private:
+    FeedTraceSpan spans[N];
+    size_t head = 0;                    // 下一个写入位置
+    size_t count = 0;                   // 有效记录数
+
+public:
+    void record(uint8_t stage, uint8_t feederId, uint32_t sequence, uint32_t startUs, uint32_t endUs) {
+        FeedTraceSpan& span = spans[head];
+        span.startUs = startUs;
+        span.durationUs = endUs - startUs;  // 无符号减法自动处理micros回绕
+        span.sequence = sequence;
+        span.stage = stage;
+        span.feederId = feederId;
+
+        head = (head + 1) % N;
+        if (count < N) {
+            count++;
+        }
+    }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return N; }
+
+    // 按时间顺序取第index条记录（0为最旧）
+    const FeedTraceSpan& at(size_t index) const {
+        return spans[(head + N - count + index) % N];
+    }
+
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+};
+
+#endif // FEED_TRACE_H
@@ -0,0 +1,130 @@
+#ifndef LOOP_PROFILER_H
+#define LOOP_PROFILER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// =============================================================================
+// 主循环耗时统计 - 按阶段累计每轮耗时，统计最小/平均/最大值和对数直方图
+// 不依赖Arduino，调用方用CPU周期计数器测量后换算成微秒传入
+//
+// 直方图第i个桶统计[2^i, 2^(i+1))us的样本（第0个桶含0us），
+// p99取累计达到99%的那个桶的上界，因此是不超过2倍的上估值
+// =============================================================================
+
+#define LOOP_HISTOGRAM_BUCKETS 20       // 最后一个桶包含所有>=2^19us(约0.5s)的样本
+
+struct LoopStageStats {
+    uint32_t count;                     // 样本数（循环轮数）
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+    uint32_t histogram[LOOP_HISTOGRAM_BUCKETS];
+};
+
+inline uint8_t loopHistogramBucket(uint32_t us) {
+    uint8_t bucket = 0;
+    while (us > 1 && bucket < LOOP_HISTOGRAM_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+inline void loopStatsAdd(LoopStageStats& stats, uint32_t us) {
+    if (stats.count == 0 || us < stats.minUs) {
+        stats.minUs = us;
+    }
+    if (us > stats.maxUs) {
+        stats.maxUs = us;
+    }
+    stats.count++;
+    stats.totalUs += us;
+    stats.histogram[loopHistogramBucket(us)]++;
+}
+
+inline uint32_t loopStatsAverage(const LoopStageStats& stats) {
+    return stats.count ? (uint32_t)(stats.totalUs / stats.count) : 0;
+}
+
+// 估算百分位数（返回所在桶的上界，不超过maxUs）
+inline uint32_t loopStatsPercentile(const LoopStageStats& stats, uint8_t percent) {
+    if (stats.count == 0) {
+        return 0;
+    }
+    uint32_t target = (uint32_t)(((uint64_t)stats.count * percent + 99) / 100);
+    uint32_t cumulative = 0;
+    for (uint8_t i = 0; i < LOOP_HISTOGRAM_BUCKETS; i++) {
+        cumulative += stats.histogram[i];
+        if (cumulative >= target) {
+            uint32_t upper = (2UL << i) - 1;
+            return upper < stats.maxUs ? upper : stats.maxUs;
+        }
+    }
+    return stats.maxUs;
+}
+
+template <size_t STAGES>
+class LoopProfiler {
+private:
+    LoopStageStats stages[STAGES];
+    LoopStageStats loop;                // 整轮循环
+    uint32_t current[STAGES];           // 本轮各阶段累计耗时（同一阶段可在一轮中多次记录）
+    uint8_t worstStage = 0;             // 最慢一轮中耗时最多的阶段
+    uint32_t worstStageUs = 0;
+    uint8_t lastWorstStage = 0;         // 最近一轮中耗时最多的阶段
+    uint32_t lastWorstStageUs = 0;
+
+public:
+    LoopProfiler() { clear(); }
+
+    void record(uint8_t stage, uint32_t us) {
+        if (stage < STAGES) {
+            current[stage] += us;
+        }
+    }
+
+    // 一轮循环结束，把本轮各阶段耗时计入统计，返回本轮总耗时
+    uint32_t endLoop() {
+        uint32_t loopUs = 0;
+        lastWorstStage = 0;
+        lastWorstStageUs = 0;
+        for (uint8_t i = 0; i < STAGES; i++) {
+            loopStatsAdd(stages[i], current[i]);
+            loopUs += current[i];
+            if (current[i] > lastWorstStageUs) {
+                lastWorstStage = i;
+                lastWorstStageUs = current[i];
+            }
+            current[i] = 0;
+        }
+
+        if (loopUs >= loop.maxUs) {
+            worstStage = lastWorstStage;
+            worstStageUs = lastWorstStageUs;
+        }
+        loopStatsAdd(loop, loopUs);
+        return loopUs;
+    }
+
+    void clear() {
+        memset(stages, 0, sizeof(stages));
+        memset(&loop, 0, sizeof(loop));
+        memset(current, 0, sizeof(current));
+        worstStage = 0;
+        worstStageUs = 0;
+        lastWorstStage = 0;
+        lastWorstStageUs = 0;
+    }
+
+    const LoopStageStats& stage(uint8_t index) const { return stages[index]; }
+    const LoopStageStats& loopStats() const { return loop; }
+    uint8_t getWorstStage() const { return worstStage; }
+    uint32_t getWorstStageUs() const { return worstStageUs; }
+    uint8_t getLastWorstStage() const { return lastWorstStage; }
+    uint32_t getLastWorstStageUs() const { return lastWorstStageUs; }
+    size_t stageCount() const { return STAGES; }
+};
+
+#endif // LOOP_PROFILER_H
@@ -0,0 +1,120 @@
+#ifndef LOOPBACK_TRANSPORT_H
+#define LOOPBACK_TRANSPORT_H
+
+#include "transport.h"
+
+// =============================================================================
+// 内存回环传输 - 在主机上把Brain和多个Hand的协议代码接在一起测试，不依赖Arduino。
+// 同一进程中的所有实例组成一个网络：send()把包放进地址匹配的实例（广播地址为所有其他实例）的接收队列
+// =============================================================================
+
+#ifndef LOOPBACK_QUEUE_DEPTH
+#define LOOPBACK_QUEUE_DEPTH 16
+#endif
+
+#ifndef LOOPBACK_PACKET_SIZE
+#define LOOPBACK_PACKET_SIZE 256
+#endif
+
+class LoopbackTransport : public Transport {
+public:
+    explicit LoopbackTransport(const TransportAddress& address)
+        : address(address), head(0), count(0), lossEvery(0), sendCount(0), next(registry()) {
+        registry() = this;
+    }
+
+    ~LoopbackTransport() {
+        for (LoopbackTransport** link = &registry(); *link != nullptr; link = &(*link)->next) {
+            if (*link == this) {
+                *link = next;
+                break;
+            }
+        }
+    }
+
+    bool begin() override {
+        return true;
+    }
+
+    bool send(const TransportAddress& to, const uint8_t* data, size_t length) override {
+        if (length > LOOPBACK_PACKET_SIZE) {
+            return false;
+        }
+        // 模拟丢包：每lossEvery个包丢一个（发送方仍认为已发出）
+        sendCount++;
+        if (lossEvery > 0 && sendCount % lossEvery == 0) {
+            return true;
+        }
+        bool broadcast = sameTransportAddress(to, broadcastTransportAddress(to.type));
+        bool delivered = false;
+        for (LoopbackTransport* peer = registry(); peer != nullptr; peer = peer->next) {
+            if (peer == this) {
+                continue;
+            }
+            if (broadcast ? peer->address.type == to.type : sameTransportAddress(peer->address, to)) {
+                delivered |= peer->enqueue(address, data, length);
+            }
+        }
+        return delivered;
+    }
+
+    size_t receive(uint8_t* buffer, size_t size, TransportAddress& from) override {
+        if (count == 0) {
+            return 0;
+        }
+        const Packet& packet = queue[head];
+        from = packet.from;
+        size_t length = packet.length < size ? packet.length : size;
+        memcpy(buffer, packet.data, length);
+        head = (head + 1) % LOOPBACK_QUEUE_DEPTH;
+        count--;
+        return length;
+    }
+
+    const char* name() const override {
+        return "loopback";
+    }
+
+    // 每everyN个发送的包丢弃一个，0为不丢包
+    void setLoss(uint32_t everyN) {
+        lossEvery = everyN;
+    }
+
+    size_t pending() const {
+        return count;
+    }
+
+private:
+    struct Packet {
+        TransportAddress from;
+        size_t length;
+        uint8_t data[LOOPBACK_PACKET_SIZE];
+    };
+
+    static LoopbackTransport*& registry() {
+        static LoopbackTransport* first = nullptr;
+        return first;
+    }
+
+    bool enqueue(const TransportAddress& from, const uint8_t* data, size_t length) {
+        if (count == LOOPBACK_QUEUE_DEPTH) {
+            return false;
+        }
+        Packet& packet = queue[(head + count) % LOOPBACK_QUEUE_DEPTH];
+        packet.from = from;
+        packet.length = length;
+        memcpy(packet.data, data, length);
+        count++;
+        return true;
+    }
+
+    TransportAddress address;
+    Packet queue[LOOPBACK_QUEUE_DEPTH];
+    size_t head;
+    size_t count;
+    uint32_t lossEvery;
+    uint32_t sendCount;
+    LoopbackTransport* next;
+};
+
+#endif // LOOPBACK_TRANSPORT_H
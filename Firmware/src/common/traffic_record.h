@@ -0,0 +1,154 @@
+#ifndef TRAFFIC_RECORD_H
+#define TRAFFIC_RECORD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// =============================================================================
+// 通信录制 - Brain收到的G-code行和UDP包按到达时间写入固定大小的字节环形缓冲区
+// 不依赖Arduino，导出格式与Firmware/tools/traffic_replay.py共用
+//
+// 导出文件 = TrafficFileHeader + 若干条(TrafficRecordHeader + payload)，小端序
+// =============================================================================
+
+#define TRAFFIC_FILE_MAGIC   0x52504E50UL  // "PNPR"
+#define TRAFFIC_FILE_VERSION 1
+
+// 记录来源
+typedef enum {
+    TRAFFIC_TCP_LINE = 0,               // TCP收到的一行G-code（不含换行符）
+    TRAFFIC_UDP_MAIN = 1,               // 主端口(8266)收到的UDP包
+    TRAFFIC_UDP_DISCOVERY = 2,          // 发现端口(8268)收到的UDP包
+} TrafficSource;
+
+struct TrafficFileHeader {
+    uint32_t magic;                     // TRAFFIC_FILE_MAGIC
+    uint8_t version;                    // TRAFFIC_FILE_VERSION
+    uint8_t reserved[3];
+    uint32_t recordCount;               // 记录条数
+    uint32_t droppedCount;              // 缓冲区写满后被覆盖的记录数
+} __attribute__((packed));
+
+struct TrafficRecordHeader {
+    uint32_t timeUs;                    // 到达时间(micros)
+    uint8_t source;                     // TrafficSource
+    uint8_t remoteIP[4];                // 发送方IP，TCP行为0
+    uint8_t reserved;
+    uint16_t length;                    // payload字节数
+} __attribute__((packed));
+
+// 固定容量字节环形缓冲区，写满后丢弃最旧的整条记录，不做任何堆分配
+template <size_t N>
+class TrafficRecordRing {
+private:
+    uint8_t data[N];
+    size_t head = 0;                    // 最旧记录的起始位置
+    size_t used = 0;                    // 已用字节数
+    uint32_t count = 0;                 // 有效记录数
+    uint32_t dropped = 0;
+
+    void copyIn(size_t pos, const void* src, size_t len) {
+        const uint8_t* bytes = (const uint8_t*)src;
+        for (size_t i = 0; i < len; i++) {
+            data[(pos + i) % N] = bytes[i];
+        }
+    }
+
+    void copyOut(size_t pos, void* dst, size_t len) const {
+        uint8_t* bytes = (uint8_t*)dst;
+        for (size_t i = 0; i < len; i++) {
+            bytes[i] = data[(pos + i) % N];
+        }
+    }
+
+    void dropOldest() {
+        TrafficRecordHeader header;
+        copyOut(head, &header, sizeof(header));
+        size_t size = sizeof(header) + header.length;
+        head = (head + size) % N;
+        used -= size;
+        count--;
+        dropped++;
+    }
+
+public:
+    // 记录一条数据，单条超过容量时返回false
+    bool record(uint8_t source, uint32_t timeUs, const uint8_t remoteIP[4], const uint8_t* payload, uint16_t length) {
+        size_t size = sizeof(TrafficRecordHeader) + length;
+        if (size > N) {
+            dropped++;
+            return false;
+        }
+        while (N - used < size) {
+            dropOldest();
+        }
+
+        TrafficRecordHeader header;
+        header.timeUs = timeUs;
+        header.source = source;
+        if (remoteIP) {
+            memcpy(header.remoteIP, remoteIP, 4);
+        } else {
+            memset(header.remoteIP, 0, 4);
+        }
+        header.reserved = 0;
+        header.length = length;
+
+        size_t tail = (head + used) % N;
+        copyIn(tail, &header, sizeof(header));
+        copyIn(tail + sizeof(header), payload, length);
+        used += size;
+        count++;
+        return true;
+    }
+
+    void clear() {
+        head = 0;
+        used = 0;
+        count = 0;
+        dropped = 0;
+    }
+
+    uint32_t size() const { return count; }
+    uint32_t droppedCount() const { return dropped; }
+    size_t bytesUsed() const { return used; }
+    size_t capacity() const { return N; }
+
+    // 导出后的总字节数
+    size_t exportSize() const { return sizeof(TrafficFileHeader) + used; }
+
+    void exportHeader(TrafficFileHeader& header) const {
+        header.magic = TRAFFIC_FILE_MAGIC;
+        header.version = TRAFFIC_FILE_VERSION;
+        memset(header.reserved, 0, sizeof(header.reserved));
+        header.recordCount = count;
+        header.droppedCount = dropped;
+    }
+
+    // 按时间顺序读取记录区第offset字节起的len字节（分块导出，不需要整块缓冲区）
+    size_t readBytes(size_t offset, uint8_t* out, size_t len) const {
+        if (offset >= used) {
+            return 0;
+        }
+        if (len > used - offset) {
+            len = used - offset;
+        }
+        copyOut(head + offset, out, len);
+        return len;
+    }
+
+    // 按时间顺序导出到out，out至少exportSize()字节，返回写入字节数
+    size_t exportTo(uint8_t* out, size_t outSize) const {
+        if (outSize < exportSize()) {
+            return 0;
+        }
+        TrafficFileHeader header;
+        exportHeader(header);
+        memcpy(out, &header, sizeof(header));
+        readBytes(0, out + sizeof(header), used);
+        return exportSize();
+    }
+};
+
+#endif // TRAFFIC_RECORD_H
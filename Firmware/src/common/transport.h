@@ -0,0 +1,51 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// =============================================================================
+// 命令通道传输层抽象 - Brain与Hand之间的命令/确认/响应/心跳只依赖此接口，
+// 实现有UDP（udp_transport.h）、ESP-NOW（espnow_transport.h）和主机测试用的内存回环（loopback_transport.h）
+// =============================================================================
+
+// 链路类型（也用于HAND_TRANSPORT配置）
+#define TRANSPORT_UDP       0
+#define TRANSPORT_ESPNOW    1
+#define TRANSPORT_TYPE_COUNT 2
+
+// 链路地址：UDP为IPv4地址+端口（小端），ESP-NOW为MAC地址
+struct TransportAddress {
+    uint8_t type;                       // TRANSPORT_UDP或TRANSPORT_ESPNOW
+    uint8_t bytes[6];
+};
+
+inline bool sameTransportAddress(const TransportAddress& a, const TransportAddress& b) {
+    return a.type == b.type && memcmp(a.bytes, b.bytes, sizeof(a.bytes)) == 0;
+}
+
+// 全FF为广播地址（ESP-NOW的发现请求发往广播MAC）
+inline TransportAddress broadcastTransportAddress(uint8_t type) {
+    TransportAddress address;
+    address.type = type;
+    memset(address.bytes, 0xFF, sizeof(address.bytes));
+    return address;
+}
+
+class Transport {
+public:
+    virtual ~Transport() {}
+
+    virtual bool begin() = 0;
+
+    // 发送一个包到to，交给链路层即返回true（送达由协议层的确认和重发保证）
+    virtual bool send(const TransportAddress& to, const uint8_t* data, size_t length) = 0;
+
+    // 取出一个收到的包，写入from并返回长度，没有时返回0
+    virtual size_t receive(uint8_t* buffer, size_t size, TransportAddress& from) = 0;
+
+    virtual const char* name() const = 0;
+};
+
+#endif // TRANSPORT_H
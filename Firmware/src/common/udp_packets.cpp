@@ -0,0 +1,68 @@
+#include "udp_packets.h"
+
+// =============================================================================
+// 命令通道包工具函数实现（不依赖Arduino）
+// =============================================================================
+
+// 全局序列号计数器
+static uint32_t g_sequenceCounter = 0;
+
+// 生成序列号
+uint32_t generateSequence() {
+    return ++g_sequenceCounter;
+}
+
+// 错误原因码名称
+const char* getErrorReasonName(uint8_t reason) {
+    switch (reason) {
+        case REASON_NONE:           return "none";
+        case REASON_TAPE_ERROR:     return "tape error";
+        case REASON_INVALID_LENGTH: return "invalid length";
+        case REASON_QUEUE_FULL:     return "queue full";
+        default:                    return "unknown";
+    }
+}
+
+const char* getHandLoopStageName(uint8_t stage) {
+    switch (stage) {
+        case HAND_LOOP_BUTTON:      return "button";
+        case HAND_LOOP_LED:         return "led";
+        case HAND_LOOP_SERVO:       return "servo";
+        case HAND_LOOP_UDP:         return "udp";
+        case HAND_LOOP_COMMAND:     return "command";
+        case HAND_LOOP_IDLE:        return "idle";
+        default:                    return "unknown";
+    }
+}
+
+// 验证UDP包合法性
+bool isValidUDPPacket(const uint8_t* data, size_t len, UDPPacketType expectedType) {
+    if (!data || len < 1) {
+        return false;
+    }
+    
+    UDPPacketType packetType = (UDPPacketType)data[0];
+    
+    // 检查包类型
+    if (packetType != expectedType) {
+        return false;
+    }
+    
+    // 检查包长度
+    switch (packetType) {
+        case UDP_PKT_DISCOVERY_REQUEST:
+            return len >= sizeof(UDPDiscoveryRequest);
+        case UDP_PKT_DISCOVERY_RESPONSE:
+            return len >= sizeof(UDPDiscoveryResponse);
+        case UDP_PKT_COMMAND:
+            return len >= sizeof(UDPCommandPacket);
+        case UDP_PKT_RESPONSE:
+            return len >= UDP_RESPONSE_LEGACY_SIZE;
+        case UDP_PKT_HEARTBEAT:
+            return len >= UDP_HEARTBEAT_LEGACY_SIZE;
+        case UDP_PKT_PING:
+            return len >= 1;  // Ping包只需要类型字段
+        default:
+            return false;
+    }
+}
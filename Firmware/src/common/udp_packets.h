@@ -0,0 +1,143 @@
+#ifndef UDP_PACKETS_H
+#define UDP_PACKETS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "espnow_protocol.h"  // 继承原有协议结构
+#include "feed_trace.h"       // 送料链路追踪
+
+// =============================================================================
+// 命令通道包格式（发现、命令、确认、响应、心跳）及其校验 - 纯计算，不依赖Arduino，
+// 可在主机上测试（pio test -e native）
+// =============================================================================
+
+// UDP包类型定义
+typedef enum {
+    UDP_PKT_DISCOVERY_REQUEST = 0x10,   // 发现请求
+    UDP_PKT_DISCOVERY_RESPONSE = 0x11,  // 发现响应
+    UDP_PKT_COMMAND = 0x12,             // 业务命令
+    UDP_PKT_RESPONSE = 0x13,            // 业务响应
+    UDP_PKT_HEARTBEAT = 0x14,           // 心跳包
+    UDP_PKT_PING = 0x15,                // Ping包
+    UDP_PKT_PEER_SYNC = 0x16,           // Brain主备状态同步
+    UDP_PKT_OTA_BEGIN = 0x17,           // 固件升级开始（组播）
+    UDP_PKT_OTA_CHUNK = 0x18,           // 固件数据片（组播）
+    UDP_PKT_OTA_CONTROL = 0x19,         // 固件升级控制：查询块状态/校验/重启/取消（组播）
+    UDP_PKT_OTA_STATUS = 0x1A,          // Hand升级状态（单播回复Brain）
+    UDP_PKT_ACK = 0x1B,                 // Hand收到命令的确认（执行完成后另发UDP_PKT_RESPONSE）
+} UDPPacketType;
+
+// UDP发现请求包 - 优化后更紧凑
+struct UDPDiscoveryRequest {
+    uint8_t packetType;                 // 包类型: UDP_PKT_DISCOVERY_REQUEST
+    uint8_t handId;                     // Hand设备ID
+    uint16_t timestamp_low;             // 时间戳低16位(减少包大小)
+    char handInfo[12];                  // Hand设备信息(缩短以减少网络负载)
+    uint8_t feederCount;                // 占用的连续Feeder ID数量(handId起)，旧固件不带此字段
+} __attribute__((packed));
+
+// UDP发现响应包 - 优化后更紧凑
+struct UDPDiscoveryResponse {
+    uint8_t packetType;                 // 包类型: UDP_PKT_DISCOVERY_RESPONSE
+    uint8_t brainId;                    // Brain设备ID
+    uint16_t timestamp_low;             // 时间戳低16位
+    uint8_t brainIP[4];                 // Brain IP地址(字节数组)
+    uint16_t brainPort;                 // Brain监听端口
+    char brainInfo[8];                  // Brain设备信息(缩短)
+} __attribute__((packed));
+
+// UDP命令包 (复用ESP-NOW的命令结构)
+struct UDPCommandPacket {
+    uint8_t packetType;                 // 包类型: UDP_PKT_COMMAND
+    uint32_t sequence;                  // 序列号
+    uint32_t timestamp;                 // 时间戳
+    ESPNowPacket command;               // 业务命令(复用原有结构)
+} __attribute__((packed));
+
+// UDP响应包 (复用ESP-NOW的响应结构)
+struct UDPResponsePacket {
+    uint8_t packetType;                 // 包类型: UDP_PKT_RESPONSE
+    uint32_t sequence;                  // 对应命令的序列号
+    uint32_t timestamp;                 // 响应时间戳
+    ESPNowResponse response;            // 业务响应(复用原有结构)
+    UDPHandTiming timing;               // Hand端处理耗时(用于链路追踪)
+} __attribute__((packed));
+
+// 命令确认包：Hand收到命令后立即回复，Brain据此测量往返时间，未确认的命令按重传超时重发
+struct UDPAckPacket {
+    uint8_t packetType;                 // 包类型: UDP_PKT_ACK
+    uint8_t feederId;                   // 命令中的Feeder ID
+    uint32_t sequence;                  // 对应命令的序列号
+} __attribute__((packed));
+
+// Hand主循环阶段（心跳中worstStage的取值）
+typedef enum {
+    HAND_LOOP_BUTTON = 0,
+    HAND_LOOP_LED,
+    HAND_LOOP_SERVO,
+    HAND_LOOP_UDP,
+    HAND_LOOP_COMMAND,                  // processReceivedCommand + processPendingResponse
+    HAND_LOOP_IDLE,                     // 循环末尾的delay(1)
+    HAND_LOOP_STAGE_COUNT
+} HandLoopStage;
+
+// Hand主循环耗时汇总，统计区间为上一次心跳到本次心跳
+struct UDPLoopStats {
+    uint32_t loops;                     // 循环轮数，0表示旧固件未携带
+    uint32_t maxUs;                     // 单轮最大耗时
+    uint16_t avgUs;                     // 平均耗时（超过65535按65535）
+    uint16_t p99Us;                     // p99估算值（直方图桶上界）
+    uint8_t worstStage;                 // 最慢一轮中耗时最多的阶段(HandLoopStage)
+    uint32_t worstStageUs;              // 该阶段耗时
+} __attribute__((packed));
+
+// Hand健康状态，随心跳上报（最大循环耗时见UDPLoopStats.maxUs）
+struct UDPHandHealth {
+    int8_t rssi;                        // WiFi信号强度(dBm)
+    uint8_t heapFragmentation;          // 堆碎片率(%)，100 - 最大空闲块/空闲堆
+    uint32_t freeHeap;                  // 空闲堆，0表示旧固件未携带
+    uint32_t maxFreeBlock;              // 最大可分配块
+    uint32_t servoCycles;               // 上电以来完成的送料动作次数
+    uint32_t uptimeS;                   // 运行时间(秒)
+    uint16_t resetCount;                // 上电以来的软件/看门狗/异常重启次数（断电清零）
+    uint8_t resetReason;                // 最近一次重启原因（平台原始值）
+    uint8_t lastError;                  // 最近一次送料失败原因(ESPNowErrorReason)
+    uint16_t errorCount;                // 上电以来送料失败次数
+} __attribute__((packed));
+
+// 心跳包status位
+#define HAND_STATUS_FEED_ERROR  0x01    // 最近一次送料失败
+#define HAND_STATUS_OTA         0x02    // 正在接收固件
+
+// UDP心跳包 - 最小化设计
+struct UDPHeartbeatPacket {
+    uint8_t packetType;                 // 包类型: UDP_PKT_HEARTBEAT
+    uint8_t deviceId;                   // 设备ID
+    uint16_t timestamp_low;             // 心跳时间戳低16位
+    uint8_t status;                     // 设备状态(HAND_STATUS_*)
+    uint8_t feederCount;                // Hand占用的连续Feeder ID数量，旧固件不带此字段
+    UDPLoopStats loop;                  // Hand主循环耗时，旧固件和Brain发出的心跳不带此字段
+    UDPHandHealth health;               // Hand健康状态，旧固件和Brain发出的心跳不带此字段
+} __attribute__((packed));
+
+// 不带feederCount字段的旧版包长度，按单通道Hand处理
+#define UDP_DISCOVERY_REQUEST_LEGACY_SIZE (sizeof(UDPDiscoveryRequest) - 1)
+#define UDP_HEARTBEAT_LEGACY_SIZE offsetof(UDPHeartbeatPacket, feederCount)
+// 不带Hand端处理耗时的旧版响应包长度，timing按0处理
+#define UDP_RESPONSE_LEGACY_SIZE offsetof(UDPResponsePacket, timing)
+// 不带主循环统计的心跳包长度
+#define UDP_HEARTBEAT_BASE_SIZE offsetof(UDPHeartbeatPacket, loop)
+
+// 生成序列号
+uint32_t generateSequence();
+
+// 验证UDP包合法性
+bool isValidUDPPacket(const uint8_t* data, size_t len, UDPPacketType expectedType);
+
+// 错误原因码名称 (用于回复OpenPnP)
+const char* getErrorReasonName(uint8_t reason);
+
+// Hand主循环阶段名称
+const char* getHandLoopStageName(uint8_t stage);
+
+#endif // UDP_PACKETS_H
@@ -4,51 +4,11 @@
 // UDP工具函数实现
 // =============================================================================
 
-// 全局序列号计数器
-static uint32_t g_sequenceCounter = 0;
-
-// 生成序列号
-uint32_t generateSequence() {
-    return ++g_sequenceCounter;
-}
-
 // 获取当前时间戳
 uint32_t getCurrentTimestamp() {
     return millis();
 }
 
-// 验证UDP包合法性
-bool isValidUDPPacket(const uint8_t* data, size_t len, UDPPacketType expectedType) {
-    if (!data || len < 1) {
-        return false;
-    }
-    
-    UDPPacketType packetType = (UDPPacketType)data[0];
-    
-    // 检查包类型
-    if (packetType != expectedType) {
-        return false;
-    }
-    
-    // 检查包长度
-    switch (packetType) {
-        case UDP_PKT_DISCOVERY_REQUEST:
-            return len >= sizeof(UDPDiscoveryRequest);
-        case UDP_PKT_DISCOVERY_RESPONSE:
-            return len >= sizeof(UDPDiscoveryResponse);
-        case UDP_PKT_COMMAND:
-            return len >= sizeof(UDPCommandPacket);
-        case UDP_PKT_RESPONSE:
-            return len >= sizeof(UDPResponsePacket);
-        case UDP_PKT_HEARTBEAT:
-            return len >= sizeof(UDPHeartbeatPacket);
-        case UDP_PKT_PING:
-            return len >= 1;  // Ping包只需要类型字段
-        default:
-            return false;
-    }
-}
-
 // 打印UDP包信息 (调试用)
 void printUDPPacket(const uint8_t* data, size_t len, bool isIncoming) {
     if (!data || len < 1) {
@@ -77,7 +37,7 @@ void printUDPPacket(const uint8_t* data, size_t len, bool isIncoming) {
             }
             break;
         case UDP_PKT_RESPONSE:
-            if (len >= sizeof(UDPResponsePacket)) {
+            if (len >= UDP_RESPONSE_LEGACY_SIZE) {
                 UDPResponsePacket* pkt = (UDPResponsePacket*)data;
                 Serial.printf("(响应) seq=%u status=0x%02X\n", pkt->sequence, pkt->response.status);
             } else {
@@ -107,17 +67,7 @@ uint16_t getTimestampLow() {
 
 // 检查包是否新鲜(基于低16位时间戳)
 bool isPacketFresh(uint16_t timestampLow, uint32_t maxAge) {
-    uint16_t currentLow = getTimestampLow();
-    
-    // 处理时间戳回绕
-    uint16_t diff;
-    if (currentLow >= timestampLow) {
-        diff = currentLow - timestampLow;
-    } else {
-        diff = (0xFFFF - timestampLow) + currentLow + 1;
-    }
-    
-    return diff < (maxAge & 0xFFFF);
+    return isTimestampLowFresh(getTimestampLow(), timestampLow, maxAge);
 }
 
 // 优化WiFi设置以提高性能
@@ -7,7 +7,9 @@
 #elif defined ESP8266
 #include <ESP8266WiFi.h>      // ESP8266的WiFi库
 #endif
-#include "espnow_protocol.h"  // 继承原有协议结构
+#include "udp_packets.h"      // 命令通道包格式（不依赖Arduino）
+#include "udp_timestamp.h"    // 16位时间戳工具
+#include "transport.h"        // 命令通道链路地址
 
 // =============================================================================
 // UDP通信协议定义
@@ -18,6 +20,9 @@
 #define UDP_HAND_PORT       8267        // Hand端监听端口
 #define UDP_DISCOVERY_PORT  8268        // 发现服务端口
 #define UDP_BROADCAST_PORT  8269        // 广播端口
+#define UDP_PEER_PORT       8270        // Brain主备同步端口（广播）
+#define UDP_OTA_PORT        8271        // Hand固件升级端口（Brain组播，Hand单播回复）
+#define UDP_OTA_MULTICAST_IP IPAddress(239, 80, 78, 80)  // 固件升级组播地址
 
 // UDP通信超时设置 - 优化后的性能参数
 #define UDP_DISCOVERY_TIMEOUT_MS    3000    // 发现超时3秒(减少等待时间)
@@ -30,58 +35,147 @@
 #define UDP_BUFFER_SIZE             256     // UDP缓冲区大小(减少内存使用)
 #define UDP_BATCH_SIZE              5       // 批量处理包数量
 
-// UDP包类型定义
+// Brain主备角色
 typedef enum {
-    UDP_PKT_DISCOVERY_REQUEST = 0x10,   // 发现请求
-    UDP_PKT_DISCOVERY_RESPONSE = 0x11,  // 发现响应
-    UDP_PKT_COMMAND = 0x12,             // 业务命令
-    UDP_PKT_RESPONSE = 0x13,            // 业务响应
-    UDP_PKT_HEARTBEAT = 0x14,           // 心跳包
-    UDP_PKT_PING = 0x15,                // Ping包
-} UDPPacketType;
-
-// UDP发现请求包 - 优化后更紧凑
-struct UDPDiscoveryRequest {
-    uint8_t packetType;                 // 包类型: UDP_PKT_DISCOVERY_REQUEST
-    uint8_t handId;                     // Hand设备ID
-    uint16_t timestamp_low;             // 时间戳低16位(减少包大小)
-    char handInfo[12];                  // Hand设备信息(缩短以减少网络负载)
+    BRAIN_ROLE_STARTUP = 0,             // 上电后等待对端，确定角色前不接管Hand和G-code
+    BRAIN_ROLE_ACTIVE = 1,              // 主机：服务G-code并控制Hand
+    BRAIN_ROLE_STANDBY = 2              // 备机：只镜像主机状态，主机失联后接管
+} BrainRole;
+
+// Brain主备同步包：包头 + entryCount个UDPPeerFeederEntry，同时作为对端心跳
+struct UDPPeerSyncHeader {
+    uint8_t packetType;                 // 包类型: UDP_PKT_PEER_SYNC
+    uint8_t role;                       // 发送方角色(BrainRole)
+    uint8_t priority;                   // 发送方优先级，两台都为主机时优先级低的退为备机
+    uint8_t entryCount;                 // 后续条目数
+    uint32_t nextSequence;              // 发送方下一个命令序列号，接管后从此继续
 } __attribute__((packed));
 
-// UDP发现响应包 - 优化后更紧凑
-struct UDPDiscoveryResponse {
-    uint8_t packetType;                 // 包类型: UDP_PKT_DISCOVERY_RESPONSE
-    uint8_t brainId;                    // Brain设备ID
-    uint16_t timestamp_low;             // 时间戳低16位
-    uint8_t brainIP[4];                 // Brain IP地址(字节数组)
-    uint16_t brainPort;                 // Brain监听端口
-    char brainInfo[8];                  // Brain设备信息(缩短)
+// 对端Feeder条目标志
+#define PEER_FEEDER_ONLINE  0x01        // Hand在线
+#define PEER_FEEDER_PENDING 0x02        // 有等待Hand响应的命令
+
+struct UDPPeerFeederEntry {
+    uint8_t feederId;
+    uint8_t flags;                      // PEER_FEEDER_*
+    uint8_t channel;                    // 在所属Hand中的通道号
+    uint8_t ip[4];                      // Hand IP
+    uint16_t lastSeenAgeS;              // 距最后通信的秒数
+    uint32_t totalFeedCount;
+    uint16_t sessionFeedCount;
+    uint32_t pendingSequence;           // 在途命令序列号（PEER_FEEDER_PENDING时有效）
+    uint16_t pendingElapsedMs;          // 在途命令已等待的时间
+    uint16_t pendingTimeoutMs;          // 在途命令超时时间
+    uint8_t pendingCommandType;
 } __attribute__((packed));
 
-// UDP命令包 (复用ESP-NOW的命令结构)
-struct UDPCommandPacket {
-    uint8_t packetType;                 // 包类型: UDP_PKT_COMMAND
-    uint32_t sequence;                  // 序列号
-    uint32_t timestamp;                 // 时间戳
-    ESPNowPacket command;               // 业务命令(复用原有结构)
+#define UDP_PEER_MAX_ENTRIES ((UDP_BUFFER_SIZE - sizeof(UDPPeerSyncHeader)) / sizeof(UDPPeerFeederEntry))
+
+// Hand固件组播升级：镜像按OTA_CHUNK_SIZE分片，每OTA_BLOCK_CHUNKS片为一块。
+// Brain组播一块后查询，各Hand回复该块缺失分片的位图，Brain补发所有Hand缺失分片的并集，
+// 全部Hand收齐后再发下一块；Hand收齐一块即写入Flash，最后用MD5校验，Brain确认后才重启
+#define OTA_CHUNK_SIZE 512                  // 每片字节数
+#define OTA_BLOCK_CHUNKS 8                  // 每块片数，一块4KB正好是一个Flash扇区（Hand块缓冲区大小，不超过32）
+
+// Hand升级状态
+typedef enum {
+    OTA_STATE_IDLE = 0,
+    OTA_STATE_RECEIVING = 1,            // 接收中
+    OTA_STATE_VERIFIED = 2,             // 镜像完整且MD5校验通过，等待重启命令
+    OTA_STATE_FAILED = 3
+} OtaState;
+
+// 升级失败原因
+typedef enum {
+    OTA_ERROR_NONE = 0,
+    OTA_ERROR_PARAMS = 1,               // 分片参数与本机不一致
+    OTA_ERROR_SPACE = 2,                // Flash空间不足（Update.begin失败）
+    OTA_ERROR_WRITE = 3,                // 写入Flash失败
+    OTA_ERROR_MISSED_BLOCK = 4,         // 错过了整块（Brain已放弃本机）
+    OTA_ERROR_VERIFY = 5,               // 镜像校验失败
+    OTA_ERROR_TIMEOUT = 6               // Brain端：多轮无回复或补发后仍缺失
+} OtaError;
+
+// 升级控制动作
+typedef enum {
+    OTA_ACTION_QUERY = 1,               // 回复blockIndex块的缺失位图
+    OTA_ACTION_END = 2,                 // 全部发送完毕，校验镜像
+    OTA_ACTION_REBOOT = 3,              // 已校验的Hand重启到新固件
+    OTA_ACTION_ABORT = 4                // 取消升级
+} OtaAction;
+
+struct UDPOtaBegin {
+    uint8_t packetType;                 // UDP_PKT_OTA_BEGIN
+    uint8_t blockChunks;                // 每块片数
+    uint16_t sessionId;                 // 每次升级不同，Hand据此区分重复的开始包
+    uint32_t imageSize;                 // 镜像字节数
+    uint16_t chunkSize;                 // 每片字节数
+    uint8_t md5[16];                    // 镜像MD5
 } __attribute__((packed));
 
-// UDP响应包 (复用ESP-NOW的响应结构)
-struct UDPResponsePacket {
-    uint8_t packetType;                 // 包类型: UDP_PKT_RESPONSE
-    uint32_t sequence;                  // 对应命令的序列号
-    uint32_t timestamp;                 // 响应时间戳
-    ESPNowResponse response;            // 业务响应(复用原有结构)
+// 后跟length字节数据
+struct UDPOtaChunkHeader {
+    uint8_t packetType;                 // UDP_PKT_OTA_CHUNK
+    uint8_t reserved;
+    uint16_t sessionId;
+    uint16_t chunkIndex;
+    uint16_t length;
 } __attribute__((packed));
 
-// UDP心跳包 - 最小化设计
-struct UDPHeartbeatPacket {
-    uint8_t packetType;                 // 包类型: UDP_PKT_HEARTBEAT
-    uint8_t deviceId;                   // 设备ID
-    uint16_t timestamp_low;             // 心跳时间戳低16位
-    uint8_t status;                     // 设备状态
+struct UDPOtaControl {
+    uint8_t packetType;                 // UDP_PKT_OTA_CONTROL
+    uint8_t action;                     // OtaAction
+    uint16_t sessionId;
+    uint16_t blockIndex;                // OTA_ACTION_QUERY查询的块
 } __attribute__((packed));
 
+struct UDPOtaStatus {
+    uint8_t packetType;                 // UDP_PKT_OTA_STATUS
+    uint8_t state;                      // OtaState
+    uint16_t sessionId;
+    uint8_t feederId;
+    uint8_t error;                      // OtaError
+    uint16_t blockIndex;                // missing对应的块
+    uint32_t missing;                   // 该块缺失分片位图（bit i为块内第i片）
+    uint32_t bytesWritten;              // 已写入Flash的字节数
+} __attribute__((packed));
+
+// 镜像分片计算（Brain和Hand共用）
+inline uint16_t otaChunkCount(uint32_t imageSize) {
+    return (imageSize + OTA_CHUNK_SIZE - 1) / OTA_CHUNK_SIZE;
+}
+
+inline uint16_t otaBlockCount(uint32_t imageSize) {
+    return (otaChunkCount(imageSize) + OTA_BLOCK_CHUNKS - 1) / OTA_BLOCK_CHUNKS;
+}
+
+// 第chunkIndex片的字节数（最后一片可能不满）
+inline uint16_t otaChunkLength(uint32_t imageSize, uint16_t chunkIndex) {
+    uint32_t offset = (uint32_t)chunkIndex * OTA_CHUNK_SIZE;
+    return offset >= imageSize ? 0 : (imageSize - offset > OTA_CHUNK_SIZE ? OTA_CHUNK_SIZE : imageSize - offset);
+}
+
+// 第blockIndex块包含的分片位图（最后一块可能不满）
+inline uint32_t otaBlockMask(uint32_t imageSize, uint16_t blockIndex) {
+    uint32_t first = (uint32_t)blockIndex * OTA_BLOCK_CHUNKS;
+    uint32_t total = otaChunkCount(imageSize);
+    if (first >= total) {
+        return 0;
+    }
+    uint32_t count = total - first < OTA_BLOCK_CHUNKS ? total - first : OTA_BLOCK_CHUNKS;
+    return count >= 32 ? 0xFFFFFFFFUL : (1UL << count) - 1;
+}
+
+// 第blockIndex块的字节数
+inline uint32_t otaBlockBytes(uint32_t imageSize, uint16_t blockIndex) {
+    uint32_t offset = (uint32_t)blockIndex * OTA_BLOCK_CHUNKS * OTA_CHUNK_SIZE;
+    if (offset >= imageSize) {
+        return 0;
+    }
+    uint32_t bytes = imageSize - offset;
+    return bytes > OTA_BLOCK_CHUNKS * OTA_CHUNK_SIZE ? OTA_BLOCK_CHUNKS * OTA_CHUNK_SIZE : bytes;
+}
+
 // UDP连接状态
 typedef enum {
     UDP_STATE_DISCONNECTED = 0,         // 未连接
@@ -94,6 +188,7 @@ typedef enum {
 struct BrainInfo {
     IPAddress ip;                       // Brain IP地址
     uint16_t port;                      // Brain端口
+    TransportAddress address;           // 命令通道地址（UDP为ip:port，ESP-NOW为Brain的MAC）
     uint32_t lastSeen;                  // 最后发现时间
     bool isActive;                      // 是否活跃
     char info[16];                      // 设备信息
@@ -108,18 +203,13 @@ struct UDPStats {
     uint32_t heartbeatsSent;            // 发送心跳次数
     uint32_t timeouts;                  // 超时次数
     uint32_t errors;                    // 错误次数
+    uint32_t retransmits;               // 未确认命令的重发次数（Brain端）
 };
 
 // =============================================================================
 // UDP工具函数声明
 // =============================================================================
 
-// 生成序列号
-uint32_t generateSequence();
-
-// 验证UDP包合法性
-bool isValidUDPPacket(const uint8_t* data, size_t len, UDPPacketType expectedType);
-
 // 打印UDP包信息 (调试用)
 void printUDPPacket(const uint8_t* data, size_t len, bool isIncoming = true);
 
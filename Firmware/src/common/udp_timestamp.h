@@ -0,0 +1,20 @@
+#ifndef UDP_TIMESTAMP_H
+#define UDP_TIMESTAMP_H
+
+#include <stdint.h>
+
+// =============================================================================
+// 16位时间戳工具 - 纯计算，不依赖Arduino
+// =============================================================================
+
+// 判断低16位时间戳是否在maxAgeMs以内，无符号减法自动处理65.5秒回绕
+// maxAgeMs超出16位范围时无法区分回绕次数，一律视为新鲜
+inline bool isTimestampLowFresh(uint16_t nowLow, uint16_t timestampLow, uint32_t maxAgeMs) {
+    if (maxAgeMs > 0xFFFF) {
+        return true;
+    }
+    uint16_t age = (uint16_t)(nowLow - timestampLow);
+    return age < maxAgeMs;
+}
+
+#endif // UDP_TIMESTAMP_H
@@ -0,0 +1,65 @@
+#ifndef UDP_TRANSPORT_H
+#define UDP_TRANSPORT_H
+
+#include <Arduino.h>
+#if defined ESP32
+#include <WiFi.h>
+#elif defined ESP8266
+#include <ESP8266WiFi.h>
+#endif
+#include <WiFiUdp.h>
+#include "transport.h"
+
+inline TransportAddress udpTransportAddress(IPAddress ip, uint16_t port) {
+    TransportAddress address;
+    address.type = TRANSPORT_UDP;
+    for (uint8_t i = 0; i < 4; i++) {
+        address.bytes[i] = ip[i];
+    }
+    address.bytes[4] = port & 0xFF;
+    address.bytes[5] = port >> 8;
+    return address;
+}
+
+inline IPAddress transportAddressIP(const TransportAddress& address) {
+    return IPAddress(address.bytes[0], address.bytes[1], address.bytes[2], address.bytes[3]);
+}
+
+inline uint16_t transportAddressPort(const TransportAddress& address) {
+    return address.bytes[4] | (address.bytes[5] << 8);
+}
+
+// 基于WiFiUDP的传输实现，socket在本端口上收发
+class UdpTransport : public Transport {
+public:
+    UdpTransport(WiFiUDP& socket, uint16_t localPort) : socket(socket), localPort(localPort) {}
+
+    bool begin() override {
+        return socket.begin(localPort);
+    }
+
+    bool send(const TransportAddress& to, const uint8_t* data, size_t length) override {
+        socket.beginPacket(transportAddressIP(to), transportAddressPort(to));
+        socket.write(data, length);
+        return socket.endPacket();
+    }
+
+    size_t receive(uint8_t* buffer, size_t size, TransportAddress& from) override {
+        if (socket.parsePacket() <= 0) {
+            return 0;
+        }
+        from = udpTransportAddress(socket.remoteIP(), socket.remotePort());
+        int length = socket.read(buffer, size);
+        return length > 0 ? length : 0;
+    }
+
+    const char* name() const override {
+        return "udp";
+    }
+
+private:
+    WiFiUDP& socket;
+    uint16_t localPort;
+};
+
+#endif // UDP_TRANSPORT_H
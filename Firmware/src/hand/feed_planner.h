@@ -0,0 +1,67 @@
+#ifndef FEED_PLANNER_H
+#define FEED_PLANNER_H
+
+#include <stdint.h>
+
+// =============================================================================
+// 送料步骤规划 - 纯计算，不依赖Arduino
+// 推进杆只在向前运动时带动料带：回退位→半步位送2mm，回退位→推进位送4mm，
+// 半步位→推进位送2mm；回退不送料。棘爪必须完整回退一个孔距才能钩住下一个孔，
+// 因此半步位只能继续向前，推进位只能回退。按此规则每一步都取当前可送的最大长度，
+// 任意偶数长度都能精确送出，且舵机移动次数最少
+// =============================================================================
+
+// 推进杆位置（移植自demo FeederClass），记录半步位置以支持2mm送料
+typedef enum {
+    LEVER_UNKNOWN = 0,
+    LEVER_FULL_ADVANCED = 1,
+    LEVER_HALF_ADVANCED = 2,
+    LEVER_RETRACTED = 3
+} LeverPosition;
+
+struct FeedStep {
+    uint8_t target;                     // 下一步的目标位置(LeverPosition)
+    uint8_t fedLength;                  // 这一步送出的长度(mm)
+};
+
+// 规划下一步：remaining为剩余长度(mm，>0且为偶数)，fullStroke为一次完整推进的长度
+inline FeedStep nextFeedStep(uint8_t position, uint8_t remaining, uint8_t fullStroke) {
+    uint8_t halfStroke = fullStroke / 2;
+    FeedStep step;
+
+    switch (position) {
+        case LEVER_RETRACTED:
+            if (remaining >= fullStroke) {
+                step.target = LEVER_FULL_ADVANCED;
+                step.fedLength = fullStroke;
+            } else {
+                step.target = LEVER_HALF_ADVANCED;
+                step.fedLength = halfStroke;
+            }
+            break;
+
+        case LEVER_HALF_ADVANCED:
+            step.target = LEVER_FULL_ADVANCED;
+            step.fedLength = halfStroke;
+            break;
+
+        default:
+            // 推进位或上电后位置未知：先回退
+            step.target = LEVER_RETRACTED;
+            step.fedLength = 0;
+            break;
+    }
+
+    if (step.fedLength > remaining) {
+        step.fedLength = remaining;
+    }
+    return step;
+}
+
+// 送料长度是否能被精确送出（半步的整数倍）
+inline bool isFeedLengthValid(uint8_t feedLength, uint8_t fullStroke) {
+    uint8_t halfStroke = fullStroke / 2;
+    return feedLength > 0 && halfStroke > 0 && feedLength % halfStroke == 0;
+}
+
+#endif // FEED_PLANNER_H
@@ -9,6 +9,11 @@ uint8_t currentFeederID = FEEDER_ID;
 #define EEPROM_MAGIC_BYTE 0xAB
 #define EEPROM_MAGIC_ADDR (FEEDER_ID_ADDR + 1)
 
+// 多通道Hand占用[feederID, feederID + FEEDERS_PER_HAND)，整个范围都必须有效
+static bool isValidFeederID(int feederID) {
+    return feederID >= 0 && feederID + FEEDERS_PER_HAND <= TOTAL_FEEDERS;
+}
+
 void initFeederID() {
     EEPROM.begin(EEPROM_SIZE);
     
@@ -20,7 +25,7 @@ void initFeederID() {
         uint8_t storedID = EEPROM.read(FEEDER_ID_ADDR);
         
         // 验证读取的ID是否有效（0-49范围内）
-        if (storedID < TOTAL_FEEDERS) {
+        if (isValidFeederID(storedID)) {
             currentFeederID = storedID;
             DEBUG_PRINTF("Feeder ID loaded from EEPROM: %d\n", currentFeederID);
         } else {
@@ -40,8 +45,8 @@ void initFeederID() {
 }
 
 bool saveFeederID(uint8_t feederID) {
-    if (feederID >= TOTAL_FEEDERS) {
-        DEBUG_PRINTF("Invalid Feeder ID: %d (must be 0-%d)\n", feederID, TOTAL_FEEDERS - 1);
+    if (!isValidFeederID(feederID)) {
+        DEBUG_PRINTF("Invalid Feeder ID: %d (must be 0-%d)\n", feederID, TOTAL_FEEDERS - FEEDERS_PER_HAND);
         return false;
     }
     
@@ -73,7 +78,7 @@ void processSerialCommand() {
             String idStr = command.substring(7);
             int newID = idStr.toInt();
             
-            if (newID >= 0 && newID < TOTAL_FEEDERS) {
+            if (isValidFeederID(newID)) {
                 if (saveFeederID((uint8_t)newID)) {
                     DEBUG_PRINTF("Feeder ID changed to: %d\n", newID);
                     DEBUG_PRINTLN("Restart required for ESP-NOW registration");
@@ -82,7 +87,7 @@ void processSerialCommand() {
                     DEBUG_PRINTLN("Failed to save new Feeder ID");
                 }
             } else {
-                DEBUG_PRINTF("Invalid ID: %d (must be 0-%d)\n", newID, TOTAL_FEEDERS - 1);
+                DEBUG_PRINTF("Invalid ID: %d (must be 0-%d)\n", newID, TOTAL_FEEDERS - FEEDERS_PER_HAND);
             }
         }
         else if (command == "GET_ID") {
@@ -119,7 +124,7 @@ bool isFeederIDUnassigned() {
 
 // 远程设置Feeder ID（由ESP-NOW命令调用）
 bool setFeederIDRemotely(uint8_t newID) {
-    if (newID >= TOTAL_FEEDERS) {
+    if (!isValidFeederID(newID)) {
         DEBUG_PRINTF("Remote set: Invalid Feeder ID: %d\n", newID);
         return false;
     }
@@ -1,7 +1,9 @@
 #ifndef HAND_CONFIG_H
 #define HAND_CONFIG_H
 
+#ifdef ARDUINO
 #include <Arduino.h>
+#endif
 #include "../common/common_config.h"
 
 // =============================================================================
@@ -23,10 +25,76 @@
 #define BUTTON_PIN ESP01S_GPIO3  // GPIO3 (RXD) 连接按钮
 #define BUTTON_ACTIVE_LOW true  // 按钮按下时为低电平（另一端接地）
 
+// 多通道Hand配置（通过PCA9685 I2C PWM扩展芯片驱动多个舵机）
+// 编译标志: -D HAND_PCA9685=1 -D FEEDERS_PER_HAND=16，Hand占用从Feeder ID开始的连续ID范围
+#ifndef HAND_PCA9685
+#define HAND_PCA9685 0
+#endif
+
+#if HAND_PCA9685
+#define PCA9685_I2C_ADDRESS 0x40       // A0-A5全部接地
+#define PCA9685_SDA_PIN ESP01S_GPIO0   // I2C占用GPIO0/GPIO2，SERVO_PIN不再使用
+#define PCA9685_SCL_PIN ESP01S_GPIO2
+#define PCA9685_I2C_CLOCK_HZ 400000
+#define PCA9685_STAGGER_TICKS 256      // 各通道脉冲起点依次错开约1.25ms，分散舵机起动电流
+#endif
+
 // 舵机测试配置
 // #define ENABLE_SERVO_STARTUP_TEST  // 启用开机舵机测试（注释掉则禁用）
 #define SERVO_TEST_DELAY 300       // 舵机测试每步延迟时间(毫秒)
 
+// 舵机脉冲配置（由硬件定时器波形发生器输出，不依赖主循环）
+#define SERVO_MIN_PULSE_US 500         // 0°对应脉宽
+#define SERVO_MAX_PULSE_US 2400        // 180°对应脉宽
+#define SERVO_PERIOD_US 20000          // 脉冲周期(50Hz)
+// #define SERVO_JITTER_PROBE          // 启用脉冲抖动测量（GPIO中断采样舵机引脚，仅调试用）
+
+// 舵机运动曲线配置（梯形速度曲线，每次移动的时长由角度差计算）
+#define SERVO_MAX_VELOCITY_DPS 600     // 最高角速度(°/s)，SG90/MG90S标称0.1s/60°
+#define SERVO_ACCELERATION_DPS2 6000   // 角加速度(°/s²)
+// 曲线结束后等待舵机跟上的稳定时间(毫秒)：没有实测依据，取已知可靠的保守值，也是M640校准的起始值；
+// 校准后各通道以EEPROM中测得的值为准
+#define SERVO_SETTLE_MARGIN_MS 100
+
+// 反馈线配置（料带盖膜张紧微动开关，低电平表示正常），-1表示未安装
+// ESP01S可接在GPIO0上，注意上电时开关不能处于按下状态
+#define FEEDBACK_PIN -1
+
+// 送料队列配置（送料执行中收到的新命令依次排队，而不是丢弃或阻塞）
+#define FEED_QUEUE_DEPTH 4
+
+// 稳定时间自整定配置
+#define SETTLE_TUNE_START_MS SERVO_SETTLE_MARGIN_MS // 校准从未校准时的默认值开始只向下缩短，结果不会比不校准更慢
+#define SETTLE_TUNE_MIN_MS 10          // 校准下限
+#define SETTLE_TUNE_STEP_MS 10         // 每次缩短的步长
+#define SETTLE_TUNE_SAFETY_MS 20       // 出错后在最后可靠值上增加的余量
+#define SETTLE_TUNE_CONFIRM_FEEDS 3    // 每个值需要连续正常的送料次数
+
+#if HAND_PCA9685
+#undef SERVO_JITTER_PROBE              // 抖动探针只适用于SERVO_PIN直连舵机
+#endif
+
+// 送料链路追踪配置
+#define HAND_TRACE_DEPTH 24        // Hand端环形缓冲区可保存的区间数量
+
+// 主循环耗时统计配置（随心跳上报）
+#define LOOP_STALL_US 20000        // 单轮循环超过该耗时时输出耗时最多的阶段（调试模式）
+
+// 组播固件升级配置（hand_ota.h）
+#define HAND_OTA_REBOOT_DELAY_MS 200   // 收到重启命令后等待状态回复发出的时间
+
+// 命令确认配置：Brain未收到确认时用同一序列号重发命令
+#define HAND_DUPLICATE_WINDOW_MS 1000  // 该时间内收到相同序列号的命令视为重发，只回复确认不再执行
+
+// 命令通道传输配置（common/transport.h）：TRANSPORT_ESPNOW时发现、命令、响应和心跳改走ESP-NOW，
+// 仍连接AP（固件升级和未分配ID时的配置使用UDP）。Brain需开启BRAIN_ESPNOW_ENABLED
+#ifndef HAND_TRANSPORT
+#define HAND_TRANSPORT TRANSPORT_UDP
+#endif
+
+// 健康状态配置（hand_health.h，随心跳上报）
+#define HAND_RTC_HEALTH_OFFSET 64      // 重启计数在RTC用户内存中的位置（4字节块，前128字节留给OTA）
+
 // 串口调试控制宏 - Hand正常模式
 // 开发模式: 启用串口日志和命令
 // 正常模式: 禁用串口，GPIO1可用作其他用途（如LED）
@@ -0,0 +1,99 @@
+#include "hand_health.h"
+#include "hand_servo.h"
+#include "hand_ota.h"
+#if defined ESP32
+#include <WiFi.h>
+#include <esp_system.h>
+#elif defined ESP8266
+#include <ESP8266WiFi.h>
+#include <user_interface.h>            // rst_info
+#endif
+
+#define RESET_COUNTER_MAGIC 0x48524354      // "HRCT"
+
+// RTC内存在软件重启、看门狗和异常重启后保留，断电后内容随机，用magic判断
+struct ResetCounter {
+    uint32_t magic;
+    uint32_t count;
+};
+
+#if defined ESP32
+RTC_NOINIT_ATTR static ResetCounter rtcResetCounter;
+#endif
+
+static uint16_t resetCount = 0;
+static uint8_t resetReason = 0;
+static uint8_t lastError = REASON_NONE;
+static uint16_t errorCount = 0;
+static bool lastFeedFailed = false;
+
+void health_setup() {
+    ResetCounter counter;
+#if defined ESP32
+    counter = rtcResetCounter;
+    resetReason = (uint8_t)esp_reset_reason();
+    bool powerOn = resetReason == ESP_RST_POWERON;
+#else
+    ESP.rtcUserMemoryRead(HAND_RTC_HEALTH_OFFSET, (uint32_t*)&counter, sizeof(counter));
+    resetReason = (uint8_t)ESP.getResetInfoPtr()->reason;
+    bool powerOn = resetReason == REASON_DEFAULT_RST;
+#endif
+
+    if (powerOn || counter.magic != RESET_COUNTER_MAGIC) {
+        counter.magic = RESET_COUNTER_MAGIC;
+        counter.count = 0;
+    } else {
+        counter.count++;
+    }
+    resetCount = counter.count > 0xFFFF ? 0xFFFF : counter.count;
+
+#if defined ESP32
+    rtcResetCounter = counter;
+#else
+    ESP.rtcUserMemoryWrite(HAND_RTC_HEALTH_OFFSET, (uint32_t*)&counter, sizeof(counter));
+#endif
+    DEBUG_PRINTF("Health: 重启原因 %d，上电以来重启 %d 次\n", resetReason, resetCount);
+}
+
+void noteFeedError(uint8_t reason) {
+    lastError = reason;
+    if (errorCount < 0xFFFF) {
+        errorCount++;
+    }
+    lastFeedFailed = true;
+}
+
+void noteFeedOk() {
+    lastFeedFailed = false;
+}
+
+uint8_t getHandStatusFlags() {
+    uint8_t flags = 0;
+    if (lastFeedFailed) {
+        flags |= HAND_STATUS_FEED_ERROR;
+    }
+    if (isOtaInProgress()) {
+        flags |= HAND_STATUS_OTA;
+    }
+    return flags;
+}
+
+void fillHandHealth(UDPHandHealth& health) {
+    uint32_t freeHeap = ESP.getFreeHeap();
+#if defined ESP32
+    uint32_t maxFreeBlock = ESP.getMaxAllocHeap();
+#else
+    uint32_t maxFreeBlock = ESP.getMaxFreeBlockSize();
+#endif
+
+    health.rssi = WiFi.RSSI();
+    health.heapFragmentation = freeHeap > 0 ? 100 - (uint8_t)((uint64_t)maxFreeBlock * 100 / freeHeap) : 0;
+    health.freeHeap = freeHeap;
+    health.maxFreeBlock = maxFreeBlock;
+    health.servoCycles = getServoCycleCount();
+    health.uptimeS = millis() / 1000;
+    health.resetCount = resetCount;
+    health.resetReason = resetReason;
+    health.lastError = lastError;
+    health.errorCount = errorCount;
+}
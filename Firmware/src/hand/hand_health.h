@@ -0,0 +1,28 @@
+#ifndef HAND_HEALTH_H
+#define HAND_HEALTH_H
+
+#include <Arduino.h>
+#include "hand_config.h"
+#include "common/udp_protocol.h"
+
+// =============================================================================
+// Hand健康状态 - WiFi信号、堆、送料次数、重启和送料错误，随心跳上报，
+// Brain汇总后通过/api/health查看
+// =============================================================================
+
+// 在setup()开头调用：读取重启原因并累加RTC内存中的重启计数
+void health_setup();
+
+// 记录一次送料失败（reason为ESPNowErrorReason）
+void noteFeedError(uint8_t reason);
+
+// 记录一次送料成功，清除心跳中的HAND_STATUS_FEED_ERROR
+void noteFeedOk();
+
+// 心跳中的status位(HAND_STATUS_*)
+uint8_t getHandStatusFlags();
+
+// 填写心跳中的健康状态
+void fillHandHealth(UDPHandHealth& health);
+
+#endif // HAND_HEALTH_H
@@ -3,43 +3,78 @@
 
 #if !DEBUG_MODE
 
-// LED闪烁状态结构
-struct LEDBlinkState {
-    bool isBlinking = false;
-    int blinkCount = 0;
-    int targetBlinks = 0;
-    unsigned long lastBlinkTime = 0;
-    unsigned long lastHeartbeatTime = 0;
-    unsigned long findMeEndTime = 0;
-    bool ledState = false;
-    LEDBlinkType currentType = LED_BLINK_FEED;
-    LEDStatus currentStatus = LED_STATUS_OFF;
-    unsigned long blinkInterval = 100; // 默认闪烁间隔
-    bool findMeActive = false;
+// 闪烁图案：亮onMs、灭offMs为一个周期，onMs为0表示常灭
+struct LEDPattern {
+    uint16_t onMs;
+    uint16_t offMs;
+};
+
+// 各闪烁类型的图案（按LEDBlinkType顺序）
+static const LEDPattern blinkPatterns[] = {
+    {100, 100},     // LED_BLINK_FEED - 快速闪烁
+    {200, 200},     // LED_BLINK_ERROR - 中速闪烁
+    {150, 150},     // LED_BLINK_SUCCESS - 中快闪烁
+    {80, 80},       // LED_BLINK_FIND_ME - 超快速闪烁，与心跳区别明显
+    {500, 500},     // LED_BLINK_WIFI_CONNECTING - 慢闪
+    {1000, 1000},   // LED_BLINK_WIFI_CONNECTED - 很慢闪
+    {2000, 2000}    // LED_BLINK_UNASSIGNED - 超慢闪
 };
 
-static LEDBlinkState ledState;
-
-// 不同类型闪烁的间隔设置
-static const unsigned long blinkIntervals[] = {
-    100,  // LED_BLINK_FEED - 快速闪烁
-    200,  // LED_BLINK_ERROR - 中速闪烁  
-    150,  // LED_BLINK_SUCCESS - 中快闪烁
-    80,   // LED_BLINK_FIND_ME - 超快速闪烁，与心跳区别明显
-    500,  // LED_BLINK_WIFI_CONNECTING - 慢闪
-    1000, // LED_BLINK_WIFI_CONNECTED - 很慢闪
-    2000  // LED_BLINK_UNASSIGNED - 超慢闪
+// 各状态的背景图案（按LEDStatus顺序），没有闪烁和Find Me时显示
+static const LEDPattern statusPatterns[] = {
+    {0, 0},         // LED_STATUS_OFF - 常灭
+    {50, 950},      // LED_STATUS_HEARTBEAT - 每秒短亮一次
+    {500, 500},     // LED_STATUS_WIFI_CONNECTING - 同LED_BLINK_WIFI_CONNECTING
+    {2000, 2000},   // LED_STATUS_WIFI_CONNECTED - 同LED_BLINK_UNASSIGNED，表示未分配ID
+    {50, 950},      // LED_STATUS_READY - 同心跳
+    {100, 100}      // LED_STATUS_WORKING - 同LED_BLINK_FEED
+};
+
+// LED状态：按优先级Find Me > 有限次闪烁 > 状态图案，只在handleLED中按时间切换亮灭，不阻塞
+struct LEDEngineState {
+    const LEDPattern* pattern = &statusPatterns[LED_STATUS_OFF];
+    int remainingCycles = 0;            // 剩余周期数，0表示持续
+    bool ledOn = false;
+    unsigned long phaseStartTime = 0;
+    bool blinkActive = false;           // 正在执行有限次或持续的闪烁
+    bool findMeActive = false;
+    unsigned long findMeStartTime = 0;
+    unsigned long findMeDurationMs = 0;
+    LEDStatus currentStatus = LED_STATUS_OFF;
 };
 
+static LEDEngineState ledState;
+
+static void writeLED(bool on) {
+    if (on != ledState.ledOn) {
+        ledState.ledOn = on;
+        digitalWrite(ESP01S_GPIO1, on ? HIGH : LOW);
+    }
+}
+
+// 从亮相位开始执行图案
+static void startPattern(const LEDPattern* pattern, int cycles) {
+    ledState.pattern = pattern;
+    ledState.remainingCycles = cycles;
+    ledState.phaseStartTime = millis();
+    writeLED(pattern->onMs > 0);
+}
+
+static void startStatusPattern() {
+    ledState.blinkActive = false;
+    startPattern(&statusPatterns[ledState.currentStatus], 0);
+}
+
 #endif
 
 void initLED() {
 #if !DEBUG_MODE
     pinMode(ESP01S_GPIO1, OUTPUT);
     digitalWrite(ESP01S_GPIO1, LOW);
-    ledState.lastHeartbeatTime = millis();
-    ledState.currentStatus = LED_STATUS_OFF;
+    ledState.ledOn = false;
     ledState.findMeActive = false;
+    ledState.currentStatus = LED_STATUS_OFF;
+    startStatusPattern();
 #endif
 }
 
@@ -49,46 +84,18 @@ void startLEDBlink(LEDBlinkType type, int blinks) {
     if (ledState.findMeActive && type != LED_BLINK_FIND_ME) {
         return;
     }
-    
-    ledState.isBlinking = true;
-    ledState.blinkCount = 0;
-    ledState.targetBlinks = blinks * 2; // 每次闪烁包含开和关
-    ledState.lastBlinkTime = millis();
-    ledState.ledState = false;
-    ledState.currentType = type;
-    ledState.blinkInterval = blinkIntervals[type];
-    digitalWrite(ESP01S_GPIO1, LOW);
+
+    ledState.blinkActive = true;
+    startPattern(&blinkPatterns[type], blinks); // blinks为0时持续闪烁
 #endif
 }
 
 void setLEDStatus(LEDStatus status) {
 #if !DEBUG_MODE
+    // 切换状态时结束正在进行的闪烁，Find Me期间只记录状态，结束后再显示
     ledState.currentStatus = status;
-    
-    // 根据状态设置相应的LED模式
-    switch (status) {
-        case LED_STATUS_OFF:
-            ledState.isBlinking = false;
-            digitalWrite(ESP01S_GPIO1, LOW);
-            break;
-            
-        case LED_STATUS_WIFI_CONNECTING:
-            startLEDBlink(LED_BLINK_WIFI_CONNECTING, 0); // 持续闪烁
-            break;
-            
-        case LED_STATUS_WIFI_CONNECTED:
-            startLEDBlink(LED_BLINK_UNASSIGNED, 0); // 慢闪表示未分配ID
-            break;
-            
-        case LED_STATUS_READY:
-        case LED_STATUS_HEARTBEAT:
-            ledState.isBlinking = false;
-            // 将在handleLED中处理心跳
-            break;
-            
-        case LED_STATUS_WORKING:
-            startLEDBlink(LED_BLINK_FEED, 3);
-            break;
+    if (!ledState.findMeActive) {
+        startStatusPattern();
     }
 #endif
 }
@@ -96,7 +103,8 @@ void setLEDStatus(LEDStatus status) {
 void startFindMe(int duration_seconds) {
 #if !DEBUG_MODE
     ledState.findMeActive = true;
-    ledState.findMeEndTime = millis() + (duration_seconds * 1000);
+    ledState.findMeStartTime = millis();
+    ledState.findMeDurationMs = (unsigned long)duration_seconds * 1000;
     startLEDBlink(LED_BLINK_FIND_ME, 0); // 持续闪烁直到超时
 #endif
 }
@@ -104,64 +112,43 @@ void startFindMe(int duration_seconds) {
 void handleLED() {
 #if !DEBUG_MODE
     unsigned long currentTime = millis();
-    
-    // 检查Find Me是否到期
-    if (ledState.findMeActive && currentTime >= ledState.findMeEndTime) {
+
+    // 检查Find Me是否到期，到期后恢复状态图案
+    if (ledState.findMeActive && currentTime - ledState.findMeStartTime >= ledState.findMeDurationMs) {
         ledState.findMeActive = false;
-        ledState.isBlinking = false;
-        // 恢复到之前的状态
-        setLEDStatus(ledState.currentStatus);
+        startStatusPattern();
         return;
     }
-    
-    if (ledState.isBlinking) {
-        // 处理特定闪烁模式
-        if (currentTime - ledState.lastBlinkTime >= ledState.blinkInterval) {
-            ledState.ledState = !ledState.ledState;
-            digitalWrite(ESP01S_GPIO1, ledState.ledState ? HIGH : LOW);
-            ledState.blinkCount++;
-            ledState.lastBlinkTime = currentTime;
-            
-            // 如果不是持续闪烁类型，检查是否完成
-            if (ledState.targetBlinks > 0 && ledState.blinkCount >= ledState.targetBlinks) {
-                ledState.isBlinking = false;
-                digitalWrite(ESP01S_GPIO1, LOW); // 确保LED最终关闭
-                
-                // 恢复到状态指示模式
-                if (!ledState.findMeActive) {
-                    setLEDStatus(ledState.currentStatus);
-                }
-            }
-        }
-    } else if (!ledState.findMeActive) {
-        // 正常状态指示
-        switch (ledState.currentStatus) {
-            case LED_STATUS_HEARTBEAT:
-            case LED_STATUS_READY:
-                // 心跳闪烁（正常状态指示） - 每秒快闪一次
-                if (currentTime - ledState.lastHeartbeatTime > 1000) {
-                    digitalWrite(ESP01S_GPIO1, HIGH);
-                    delay(50); // 短暂亮起
-                    digitalWrite(ESP01S_GPIO1, LOW);
-                    ledState.lastHeartbeatTime = currentTime;
-                }
-                break;
-                
-            case LED_STATUS_OFF:
-                digitalWrite(ESP01S_GPIO1, LOW);
-                break;
-                
-            default:
-                // 其他状态由闪烁处理
-                break;
-        }
+
+    const LEDPattern* pattern = ledState.pattern;
+    if (pattern->onMs == 0) {
+        return; // 常灭
+    }
+
+    unsigned long phaseMs = ledState.ledOn ? pattern->onMs : pattern->offMs;
+    if (currentTime - ledState.phaseStartTime < phaseMs) {
+        return;
+    }
+    ledState.phaseStartTime = currentTime;
+
+    if (ledState.ledOn) {
+        writeLED(false);
+        return;
+    }
+
+    // 灭相位结束，一个周期完成
+    if (ledState.remainingCycles > 0 && --ledState.remainingCycles == 0) {
+        // 有限次闪烁结束，恢复状态图案
+        startStatusPattern();
+        return;
     }
+    writeLED(true);
 #endif
 }
 
 bool isLEDBlinking() {
 #if !DEBUG_MODE
-    return ledState.isBlinking;
+    return ledState.blinkActive || ledState.findMeActive;
 #else
     return false;
 #endif
@@ -0,0 +1,44 @@
+#include "hand_loop.h"
+#include "common/loop_profiler.h"
+
+static LoopProfiler<HAND_LOOP_STAGE_COUNT> loopProfiler;
+static uint32_t stageStartCycles = 0;
+static uint32_t cyclesPerUs = 80;
+
+void loop_profile_setup() {
+    cyclesPerUs = ESP.getCpuFreqMHz();
+}
+
+void loopProfileBegin() {
+    stageStartCycles = ESP.getCycleCount();
+}
+
+void loopProfileStage(uint8_t stage) {
+    // 周期计数器32位回绕，差值在单次回绕内仍然正确
+    uint32_t now = ESP.getCycleCount();
+    loopProfiler.record(stage, (now - stageStartCycles) / cyclesPerUs);
+    stageStartCycles = now;
+}
+
+void loopProfileEnd() {
+    uint32_t loopUs = loopProfiler.endLoop();
+    if (loopUs > LOOP_STALL_US) {
+        DEBUG_PRINTF("Loop stall %uus, %s took %uus\n", loopUs,
+                     getHandLoopStageName(loopProfiler.getLastWorstStage()), loopProfiler.getLastWorstStageUs());
+    }
+}
+
+void takeLoopStats(UDPLoopStats& stats) {
+    const LoopStageStats& loop = loopProfiler.loopStats();
+    uint32_t avgUs = loopStatsAverage(loop);
+    uint32_t p99Us = loopStatsPercentile(loop, 99);
+
+    stats.loops = loop.count;
+    stats.maxUs = loop.maxUs;
+    stats.avgUs = avgUs > 0xFFFF ? 0xFFFF : avgUs;
+    stats.p99Us = p99Us > 0xFFFF ? 0xFFFF : p99Us;
+    stats.worstStage = loopProfiler.getWorstStage();
+    stats.worstStageUs = loopProfiler.getWorstStageUs();
+
+    loopProfiler.clear();
+}
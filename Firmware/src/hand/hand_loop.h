@@ -0,0 +1,26 @@
+#ifndef HAND_LOOP_H
+#define HAND_LOOP_H
+
+#include <Arduino.h>
+#include "hand_config.h"
+#include "common/udp_protocol.h"
+
+// =============================================================================
+// Hand主循环耗时统计，每次心跳上报并重新开始统计
+// =============================================================================
+
+void loop_profile_setup();
+
+// 每轮循环开始时调用
+void loopProfileBegin();
+
+// 记录从上一个标记点到现在的耗时，计入stage(HandLoopStage)
+void loopProfileStage(uint8_t stage);
+
+// 一轮循环结束，超过LOOP_STALL_US时输出耗时最多的阶段（调试模式）
+void loopProfileEnd();
+
+// 填写心跳中的统计并清空，开始下一个统计区间
+void takeLoopStats(UDPLoopStats& stats);
+
+#endif // HAND_LOOP_H
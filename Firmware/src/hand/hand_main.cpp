@@ -5,6 +5,9 @@
 #include "hand_servo.h"
 #include "hand_led.h"
 #include "hand_button.h"
+#include "hand_loop.h"
+#include "hand_ota.h"
+#include "hand_health.h"
 
 // 按钮双击回调函数
 void onFeedButtonDoubleClick() {
@@ -27,15 +30,22 @@ void setup()
     DEBUG_PRINTF("Version: %s\n", HAND_VERSION);
 #endif
 
+    loop_profile_setup();
+    health_setup(); // 记录重启原因和重启次数
+
     // 初始化按钮并设置回调
     initButton();
     setButtonDoubleClickCallback(onFeedButtonDoubleClick);
+#ifdef SERVO_JITTER_PROBE
+    setButtonSingleClickCallback(printServoJitter); // 单击打印舵机脉冲抖动统计
+#endif
 
     // 初始化Feeder ID管理器
     initFeederID();
 
     // 初始化UDP通信
     udp_setup();
+    hand_ota_setup(); // 加入固件升级组播组（需在WiFi连接后）
 
     // 初始化舵机
     setup_Servo();
@@ -45,22 +55,33 @@ void setup()
 
 void loop()
 {
+    loopProfileBegin();
+
     // 处理按钮事件
     handleButton();
+    loopProfileStage(HAND_LOOP_BUTTON);
     
     // 处理LED状态
     handleLED();
+    loopProfileStage(HAND_LOOP_LED);
 
-    // 调用舵机tick
-    servoTick();
+    // 推进各通道舵机状态机
+    servo_update();
+    loopProfileStage(HAND_LOOP_SERVO);
 
     // 处理UDP通信
     udp_update();
+    hand_ota_update();
+    loopProfileStage(HAND_LOOP_UDP);
     
     // 处理UDP命令和响应
     processReceivedCommand();
     processPendingResponse();
+    loopProfileStage(HAND_LOOP_COMMAND);
 
     // 简单延迟，避免看门狗
     delay(1);
+    loopProfileStage(HAND_LOOP_IDLE);
+
+    loopProfileEnd();
 }
\ No newline at end of file
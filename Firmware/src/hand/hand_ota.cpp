@@ -0,0 +1,232 @@
+#include "hand_ota.h"
+#include "feeder_id_manager.h"
+#if defined ESP32
+#include <WiFi.h>
+#include <Update.h>
+#elif defined ESP8266
+#include <ESP8266WiFi.h>
+#include <Updater.h>
+#endif
+#include <WiFiUdp.h>
+
+static WiFiUDP otaUdp;
+static uint8_t otaPacket[sizeof(UDPOtaChunkHeader) + OTA_CHUNK_SIZE];
+
+// 当前块的接收缓冲区，收齐后整块写入Flash
+static uint8_t blockBuffer[OTA_BLOCK_CHUNKS * OTA_CHUNK_SIZE];
+
+static uint8_t otaState = OTA_STATE_IDLE;
+static uint8_t otaError = OTA_ERROR_NONE;
+static uint16_t sessionId = 0;
+static uint32_t imageSize = 0;
+static uint16_t totalBlocks = 0;
+static uint16_t currentBlock = 0;           // 正在接收的块，之前的块已写入Flash
+static uint32_t receivedMask = 0;           // 当前块已收到的分片
+static uint32_t bytesWritten = 0;
+
+static bool rebootPending = false;
+static uint32_t rebootTime = 0;
+
+static void failOta(uint8_t error) {
+    if (Update.isRunning()) {
+        Update.end();                       // 未写完时end()会丢弃已写入的内容
+    }
+    otaState = OTA_STATE_FAILED;
+    otaError = error;
+    DEBUG_PRINTF("OTA: 升级失败 error=%d\n", error);
+}
+
+static void sendStatus(IPAddress brainIP, uint16_t blockIndex) {
+    UDPOtaStatus status;
+    status.packetType = UDP_PKT_OTA_STATUS;
+    status.state = otaState;
+    status.sessionId = sessionId;
+    status.feederId = getCurrentFeederID();
+    status.error = otaError;
+    status.blockIndex = blockIndex;
+    status.bytesWritten = bytesWritten;
+
+    // 已写入的块不缺失；当前块报告未收到的分片；之后的块全部缺失
+    status.missing = 0;
+    if (otaState == OTA_STATE_RECEIVING && blockIndex >= currentBlock) {
+        status.missing = otaBlockMask(imageSize, blockIndex);
+        if (blockIndex == currentBlock) {
+            status.missing &= ~receivedMask;
+        }
+    }
+
+    otaUdp.beginPacket(brainIP, UDP_OTA_PORT);
+    otaUdp.write((uint8_t*)&status, sizeof(status));
+    otaUdp.endPacket();
+}
+
+static void handleBegin(const UDPOtaBegin& begin, IPAddress fromIP) {
+    // 重复的开始包只回复状态
+    if (otaState != OTA_STATE_IDLE && begin.sessionId == sessionId) {
+        sendStatus(fromIP, currentBlock);
+        return;
+    }
+    if (otaState == OTA_STATE_RECEIVING) {
+        Update.end();                       // 放弃未完成的上一次升级
+    }
+
+    sessionId = begin.sessionId;
+    imageSize = begin.imageSize;
+    totalBlocks = otaBlockCount(imageSize);
+    currentBlock = 0;
+    receivedMask = 0;
+    bytesWritten = 0;
+    otaError = OTA_ERROR_NONE;
+    otaState = OTA_STATE_RECEIVING;
+
+    if (begin.chunkSize != OTA_CHUNK_SIZE || begin.blockChunks != OTA_BLOCK_CHUNKS || imageSize == 0) {
+        failOta(OTA_ERROR_PARAMS);
+    } else if (!Update.begin(imageSize)) {
+        failOta(OTA_ERROR_SPACE);
+    } else {
+        char md5[33];
+        for (uint8_t i = 0; i < 16; i++) {
+            snprintf(md5 + i * 2, 3, "%02x", begin.md5[i]);
+        }
+        Update.setMD5(md5);
+        DEBUG_PRINTF("OTA: 开始接收 session=%u size=%u blocks=%u\n", sessionId, imageSize, totalBlocks);
+    }
+
+    sendStatus(fromIP, currentBlock);
+}
+
+static void commitBlock() {
+    uint32_t bytes = otaBlockBytes(imageSize, currentBlock);
+    if (Update.write(blockBuffer, bytes) != bytes) {
+        failOta(OTA_ERROR_WRITE);
+        return;
+    }
+    bytesWritten += bytes;
+    currentBlock++;
+    receivedMask = 0;
+}
+
+static void handleChunk(const UDPOtaChunkHeader& header, const uint8_t* data, size_t dataLength) {
+    if (otaState != OTA_STATE_RECEIVING || header.sessionId != sessionId) {
+        return;
+    }
+    if (header.length != otaChunkLength(imageSize, header.chunkIndex) || dataLength < header.length) {
+        return;
+    }
+
+    uint16_t block = header.chunkIndex / OTA_BLOCK_CHUNKS;
+    if (block < currentBlock) {
+        return;                             // 补发的分片，本机已写入
+    }
+    if (block > currentBlock) {
+        // Brain只在所有Hand收齐后才发下一块，收到后续块说明本机已被放弃
+        failOta(OTA_ERROR_MISSED_BLOCK);
+        return;
+    }
+
+    uint8_t slot = header.chunkIndex % OTA_BLOCK_CHUNKS;
+    if (receivedMask & (1UL << slot)) {
+        return;
+    }
+    memcpy(blockBuffer + slot * OTA_CHUNK_SIZE, data, header.length);
+    receivedMask |= 1UL << slot;
+
+    if (receivedMask == otaBlockMask(imageSize, currentBlock)) {
+        commitBlock();
+    }
+}
+
+static void handleControl(const UDPOtaControl& control, IPAddress fromIP) {
+    if (otaState == OTA_STATE_IDLE || control.sessionId != sessionId) {
+        return;
+    }
+
+    switch (control.action) {
+        case OTA_ACTION_QUERY:
+            sendStatus(fromIP, control.blockIndex);
+            break;
+
+        case OTA_ACTION_END:
+            // 还有块未收齐时只回复状态
+            if (otaState == OTA_STATE_RECEIVING && currentBlock >= totalBlocks) {
+                if (Update.end()) {
+                    otaState = OTA_STATE_VERIFIED;
+                    DEBUG_PRINTLN("OTA: 镜像校验通过");
+                } else {
+                    failOta(OTA_ERROR_VERIFY);
+                }
+            }
+            sendStatus(fromIP, currentBlock);
+            break;
+
+        case OTA_ACTION_REBOOT:
+            if (otaState == OTA_STATE_VERIFIED && !rebootPending) {
+                rebootPending = true;
+                rebootTime = millis() + HAND_OTA_REBOOT_DELAY_MS;
+            }
+            sendStatus(fromIP, currentBlock);
+            break;
+
+        case OTA_ACTION_ABORT:
+            if (otaState == OTA_STATE_RECEIVING) {
+                Update.end();
+            }
+            otaState = OTA_STATE_IDLE;
+            break;
+    }
+}
+
+void hand_ota_setup() {
+#if defined ESP32
+    bool joined = otaUdp.beginMulticast(UDP_OTA_MULTICAST_IP, UDP_OTA_PORT);
+#else
+    bool joined = otaUdp.beginMulticast(WiFi.localIP(), UDP_OTA_MULTICAST_IP, UDP_OTA_PORT);
+#endif
+    if (joined) {
+        DEBUG_PRINTF("OTA: 监听组播端口 %d\n", UDP_OTA_PORT);
+    } else {
+        DEBUG_PRINTLN("OTA: 组播端口初始化失败");
+    }
+}
+
+void hand_ota_update() {
+    // 一次取完所有包：Brain连续组播一块的分片
+    int packetSize;
+    while ((packetSize = otaUdp.parsePacket()) > 0) {
+        IPAddress fromIP = otaUdp.remoteIP();
+        size_t length = otaUdp.read(otaPacket, sizeof(otaPacket));
+        if (length == 0) {
+            continue;
+        }
+
+        switch (otaPacket[0]) {
+            case UDP_PKT_OTA_BEGIN:
+                if (length >= sizeof(UDPOtaBegin)) {
+                    handleBegin(*(UDPOtaBegin*)otaPacket, fromIP);
+                }
+                break;
+
+            case UDP_PKT_OTA_CHUNK:
+                if (length >= sizeof(UDPOtaChunkHeader)) {
+                    handleChunk(*(UDPOtaChunkHeader*)otaPacket, otaPacket + sizeof(UDPOtaChunkHeader),
+                                length - sizeof(UDPOtaChunkHeader));
+                }
+                break;
+
+            case UDP_PKT_OTA_CONTROL:
+                if (length >= sizeof(UDPOtaControl)) {
+                    handleControl(*(UDPOtaControl*)otaPacket, fromIP);
+                }
+                break;
+        }
+    }
+
+    if (rebootPending && (int32_t)(millis() - rebootTime) >= 0) {
+        DEBUG_PRINTLN("OTA: 重启到新固件");
+        ESP.restart();
+    }
+}
+
+bool isOtaInProgress() {
+    return otaState == OTA_STATE_RECEIVING;
+}
@@ -0,0 +1,23 @@
+#ifndef HAND_OTA_H
+#define HAND_OTA_H
+
+#include <Arduino.h>
+#include "hand_config.h"
+#include "common/udp_protocol.h"
+
+// =============================================================================
+// Hand组播固件升级 - 加入UDP_OTA_MULTICAST_IP组，按块接收Brain组播的镜像，
+// 收齐一块即写入Flash；Brain查询时回复缺失分片位图，最后MD5校验通过并收到
+// 重启命令后才重启到新固件（协议见udp_protocol.h）
+// =============================================================================
+
+// 在WiFi连接后调用
+void hand_ota_setup();
+
+// 在主循环中调用：处理升级包，到时重启
+void hand_ota_update();
+
+// 是否正在接收固件
+bool isOtaInProgress();
+
+#endif // HAND_OTA_H
@@ -1,14 +1,217 @@
 #include "hand_servo.h"
-#include "SoftServo.h"
+#include "motion_profile.h"
+#include "settle_tuner.h"
+#include "servo_pulse.h"
+#include "feed_planner.h"
+#include <EEPROM.h>
+#if HAND_PCA9685
+#include "pca9685.h"
+#include "wire_i2c_bus.h"
+#else
+#include <core_esp8266_waveform.h>
+#endif
 
-// 舵机对象
-SoftServo myservo;
+// 每个通道的运动状态
+typedef enum {
+    MOTION_IDLE = 0,                    // 静止
+    MOTION_MOVING = 1,                  // 按速度曲线运动中
+    MOTION_SETTLING = 2                 // 曲线结束，等待舵机稳定
+} ServoMotionState;
+
+// 每个通道独立的舵机状态机
+struct ServoChannel {
+    int currentAngle;                   // 当前角度，-1表示上电后位置未知
+    int targetAngle;                    // 本次移动的目标角度
+    int writtenAngle;                   // 最近一次输出的角度，避免重复写入
+    uint8_t state;                      // ServoMotionState
+    MotionProfile profile;
+    uint32_t phaseStartMs;              // 当前运动/稳定阶段开始时间
+    uint16_t settleMs;                  // 当前稳定阶段时长
+    uint8_t leverPosition;              // LeverPosition，本次移动完成后杆所在位置
+    bool feeding;                       // 正在执行送料
+    uint8_t remainingFeedLength;        // 本次送料剩余长度(mm)
+    FeedRequest current;                // 正在执行的送料请求
+    FeedResult result;                  // 送料前反馈线检查结果
+    FeedRequest queue[FEED_QUEUE_DEPTH]; // 执行中收到的送料请求按顺序排队
+    uint8_t queueHead;
+    uint8_t queueCount;
+    uint32_t feedStartUs;               // 最近一次送料动作的起止时间（链路追踪）
+    uint32_t feedEndUs;
+};
+
+static ServoChannel channels[FEEDERS_PER_HAND];
+static FeedCompleteCallback feedCompleteCallback = nullptr;
+static uint32_t servoCycleCount = 0; // 上电以来实际执行的送料动作次数（随心跳上报）
+
+// 每个喂料器的稳定时间（运动曲线结束后的等待时间），可由校准模式调整并保存到EEPROM
+#define SETTLE_TIME_MAGIC_BYTE 0xA5
+static uint16_t settleTimeMs[FEEDERS_PER_HAND];
+
+// 稳定时间校准状态（同一时间只校准一个通道）
+static SettleTuner settleTuner(SETTLE_TUNE_START_MS, SETTLE_TUNE_MIN_MS, SETTLE_TUNE_STEP_MS,
+                               SETTLE_TUNE_SAFETY_MS, SETTLE_TUNE_CONFIRM_FEEDS);
+static uint8_t calibrationChannel = 0;
+static bool calibrationFeedUnconfirmed = false; // 上一次校准送料尚未确认（无反馈线时等待取料失败报告）
+
+#if HAND_PCA9685
+static WireI2CBus i2cBus;
+static Pca9685 pwmExpander(i2cBus, PCA9685_I2C_ADDRESS, PCA9685_STAGGER_TICKS);
+#endif
+
+static void loadSettleTimes()
+{
+    bool calibrated = EEPROM.read(SETTLE_TIME_MAGIC_ADDR) == SETTLE_TIME_MAGIC_BYTE;
+
+    for (uint8_t i = 0; i < FEEDERS_PER_HAND; i++) {
+        uint16_t stored = 0;
+        if (calibrated) {
+            EEPROM.get(SETTLE_TIME_ADDR + i * sizeof(uint16_t), stored);
+        }
+        settleTimeMs[i] = storedSettleTimeMs(calibrated, stored, SERVO_SETTLE_MARGIN_MS);
+        DEBUG_PRINTF("Settle time[%d]: %dms%s\n", i, settleTimeMs[i], calibrated ? " (calibrated)" : "");
+    }
+}
+
+static bool saveSettleTime(uint8_t channel, uint16_t valueMs)
+{
+    settleTimeMs[channel] = valueMs;
+    EEPROM.put(SETTLE_TIME_ADDR + channel * sizeof(uint16_t), valueMs);
+    EEPROM.write(SETTLE_TIME_MAGIC_ADDR, SETTLE_TIME_MAGIC_BYTE);
+
+    bool success = EEPROM.commit();
+    DEBUG_PRINTF("Settle time[%d] saved: %dms %s\n", channel, valueMs, success ? "OK" : "FAILED");
+    return success;
+}
+
+// 读取反馈线：没有反馈线时返回true
+static bool readFeedbackLineOk()
+{
+#if FEEDBACK_PIN >= 0
+    return digitalRead(FEEDBACK_PIN) == LOW;
+#else
+    return true;
+#endif
+}
+
+// 送料前检查反馈线（同demo FeederClass::checkFeedbackLine）
+static FeedResult checkFeedbackLine(bool overrideError)
+{
+#if FEEDBACK_PIN >= 0
+    if (readFeedbackLineOk()) {
+        return FEED_OK;
+    }
+    return overrideError ? FEED_ERROR_IGNORED : FEED_ERROR;
+#else
+    (void)overrideError;
+    return FEED_OK_NO_FEEDBACK;
+#endif
+}
+
+static bool isCalibratingChannel(uint8_t channel)
+{
+    return settleTuner.isActive() && calibrationChannel == channel;
+}
+
+static uint16_t activeSettleTimeMs(uint8_t channel)
+{
+    return isCalibratingChannel(channel) ? settleTuner.settleTimeMs() : settleTimeMs[channel];
+}
+
+#ifdef SERVO_JITTER_PROBE
+// 在舵机引脚上采样实际边沿，统计周期和脉宽相对设定值的偏差
+// 注意：GPIO中断本身的响应延迟也计入结果，测得的是上限
+// 中断里只记录原始时间，统计在printServoJitter()中计算（统计函数不在IRAM中）
+#define JITTER_PROBE_SAMPLES 64
+
+struct PulseSample {
+    uint32_t periodUs;
+    uint32_t highUs;
+    uint32_t expectedHighUs;
+};
+
+static volatile uint32_t probeRiseUs = 0;
+static volatile uint32_t probePeriodUs = 0;
+static volatile uint32_t probeExpectedHighUs = 0;
+static volatile PulseSample probeSamples[JITTER_PROBE_SAMPLES];
+static volatile uint8_t probeSampleIndex = 0;
+static volatile uint8_t probeSampleCount = 0;
+
+IRAM_ATTR static void onServoPinChange()
+{
+    uint32_t now = micros();
+    if (digitalRead(SERVO_PIN)) {
+        probePeriodUs = probeRiseUs != 0 ? now - probeRiseUs : 0;
+        probeRiseUs = now;
+    } else if (probePeriodUs != 0 && probeExpectedHighUs != 0) {
+        volatile PulseSample& sample = probeSamples[probeSampleIndex];
+        sample.periodUs = probePeriodUs;
+        sample.highUs = now - probeRiseUs;
+        sample.expectedHighUs = probeExpectedHighUs;
+        probeSampleIndex = (probeSampleIndex + 1) % JITTER_PROBE_SAMPLES;
+        if (probeSampleCount < JITTER_PROBE_SAMPLES) probeSampleCount++;
+    }
+}
+#endif
+
+// 更新舵机脉宽，新的时序在当前PWM周期结束后生效
+static void writeServoAngle(uint8_t channel, int angle)
+{
+    uint16_t pulseUs = servoAngleToPulseUs(angle, SERVO_MIN_PULSE_US, SERVO_MAX_PULSE_US);
+#if HAND_PCA9685
+    pwmExpander.setPulseUs(channel, pulseUs);
+#else
+    (void)channel;
+    ServoPulseSchedule schedule;
+    if (!planServoPulse(schedule, pulseUs, SERVO_PERIOD_US)) {
+        return;
+    }
+#ifdef SERVO_JITTER_PROBE
+    probeExpectedHighUs = schedule.highUs;
+#endif
+    startWaveform(SERVO_PIN, schedule.highUs, schedule.lowUs, 0);
+#endif
+}
 
 void setup_Servo()
 {
-    myservo.attach(SERVO_PIN);  // 连接舵机到指定引脚
-    myservo.delayMode();        // 使用延迟模式，更稳定
+#if HAND_PCA9685
+    i2cBus.begin(PCA9685_SDA_PIN, PCA9685_SCL_PIN, PCA9685_I2C_CLOCK_HZ);
+    if (pwmExpander.begin(1000000UL / SERVO_PERIOD_US)) {
+        DEBUG_PRINTF("PCA9685 at 0x%02X, prescale %d, %d channels\n",
+                     PCA9685_I2C_ADDRESS, pwmExpander.getPrescale(), FEEDERS_PER_HAND);
+    } else {
+        DEBUG_PRINTF("PCA9685 at 0x%02X not responding\n", PCA9685_I2C_ADDRESS);
+    }
+    delay(1); // 振荡器唤醒需要500us
+#else
+    pinMode(SERVO_PIN, OUTPUT);
+    digitalWrite(SERVO_PIN, LOW); // 第一次写入角度前不输出脉冲
     DEBUG_PRINTF("Servo attached to pin %d\n", SERVO_PIN);
+
+#ifdef SERVO_JITTER_PROBE
+    attachInterrupt(digitalPinToInterrupt(SERVO_PIN), onServoPinChange, CHANGE);
+#endif
+#endif
+
+    for (uint8_t i = 0; i < FEEDERS_PER_HAND; i++) {
+        ServoChannel& ch = channels[i];
+        ch.currentAngle = -1;
+        ch.targetAngle = -1;
+        ch.writtenAngle = -1;
+        ch.state = MOTION_IDLE;
+        ch.leverPosition = LEVER_UNKNOWN;
+        ch.feeding = false;
+        ch.remainingFeedLength = 0;
+        ch.queueHead = 0;
+        ch.queueCount = 0;
+        ch.feedStartUs = 0;
+        ch.feedEndUs = 0;
+    }
+
+#if FEEDBACK_PIN >= 0
+    pinMode(FEEDBACK_PIN, INPUT_PULLUP);
+#endif
+    loadSettleTimes();
     
     #ifdef ENABLE_SERVO_STARTUP_TEST
     // 开机测试舵机
@@ -18,53 +221,308 @@ void setup_Servo()
     #endif
 }
 
-// 推进料带函数
-void feedTapeAction(uint8_t feedLength)
+// 开始向angle移动，已在目标位置时返回false
+static bool beginMove(uint8_t channel, int angle)
+{
+    ServoChannel& ch = channels[channel];
+    uint32_t now = millis();
+
+    ch.targetAngle = angle;
+    ch.phaseStartMs = now;
+
+    if (ch.currentAngle < 0) {
+        // 上电后位置未知，只能直接跳转并等待最坏情况的稳定时间
+        writeServoAngle(channel, angle);
+        ch.writtenAngle = angle;
+        ch.settleMs = DEFAULT_SETTLE_TIME;
+        ch.state = MOTION_SETTLING;
+        return true;
+    }
+
+    if (angle == ch.currentAngle) {
+        return false; // 已在目标位置，无需等待
+    }
+
+    planMotionProfile(ch.profile, ch.currentAngle, angle, SERVO_MAX_VELOCITY_DPS, SERVO_ACCELERATION_DPS2);
+    ch.state = MOTION_MOVING;
+    return true;
+}
+
+static bool moveLever(uint8_t channel, uint8_t position)
 {
-    // 计算需要执行的动作次数：每4mm执行一次动作
-    uint8_t actionCount = feedLength / 4;
+    static const int positionAngles[] = {
+        DEFAULT_RETRACT_ANGLE,          // LEVER_UNKNOWN不会作为目标
+        DEFAULT_FULL_ADVANCE_ANGLE,
+        DEFAULT_HALF_ADVANCE_ANGLE,
+        DEFAULT_RETRACT_ANGLE
+    };
+    channels[channel].leverPosition = position;
+    return beginMove(channel, positionAngles[position]);
+}
+
+// 送料动作结束：记录时间、校准判定、通知上层
+static void finishFeed(uint8_t channel)
+{
+    ServoChannel& ch = channels[channel];
+    ch.feeding = false;
+    ch.feedEndUs = micros();
+    if (ch.result != FEED_ERROR) {
+        servoCycleCount++;
+    }
+
+    // 反馈线报错时没有送料，不计入校准
+    if (isCalibratingChannel(channel) && ch.result != FEED_ERROR) {
+#if FEEDBACK_PIN >= 0
+        // 有反馈线时立即根据盖膜张紧状态判断定位是否正确
+        if (settleTuner.reportFeed(readFeedbackLineOk())) {
+            saveSettleTime(channel, settleTuner.settleTimeMs());
+        }
+#else
+        calibrationFeedUnconfirmed = true;
+#endif
+    }
+
+    DEBUG_PRINTF("Feed tape action completed on channel %d, result %d\n", channel, ch.result);
+    if (feedCompleteCallback) {
+        feedCompleteCallback(channel, ch.current, ch.result);
+    }
+}
+
+static void beginFeed(uint8_t channel, const FeedRequest& request)
+{
+    ServoChannel& ch = channels[channel];
+
+    DEBUG_PRINTF("Feed tape ch%d: %dmm\n", channel, request.feedLength);
+
+    // 校准模式下没有反馈线：新的送料到来时，上一次送料没有收到取料失败报告即视为正常
+    if (isCalibratingChannel(channel) && calibrationFeedUnconfirmed) {
+        calibrationFeedUnconfirmed = false;
+        if (settleTuner.reportFeed(true)) {
+            saveSettleTime(channel, settleTuner.settleTimeMs());
+        }
+    }
 
-    DEBUG_PRINTF("Feed tape: %dmm, actions: %d\n", feedLength, actionCount);
+    ch.current = request;
+    ch.feeding = true;
+    ch.remainingFeedLength = request.feedLength;
+    ch.feedStartUs = micros();
 
-    // 执行推进动作
-    for (uint8_t i = 0; i < actionCount; i++)
-    {
-        DEBUG_PRINTF("Action %d/%d\n", i + 1, actionCount);
+    // 盖膜未卷紧（卡料或料带用完）时不动作，立即报错，不必等Brain超时
+    ch.result = checkFeedbackLine(request.overrideError);
+    if (ch.result == FEED_ERROR) {
+        DEBUG_PRINTF("Feedback line error on channel %d, feed skipped\n", channel);
+        ch.remainingFeedLength = 0;
+    }
+}
 
-        // 移动到90度位置
-        myservo.write(DEFAULT_FULL_ADVANCE_ANGLE);
-        unsigned long startTime = millis();
-        while (millis() - startTime < DEFAULT_SETTLE_TIME) {
-            myservo.tick(); // 必须持续调用tick()
-            delay(1);
+// 通道静止时推进送料状态机（同demo FeederClass::update的位置切换逻辑）
+static void advanceFeed(uint8_t channel)
+{
+    ServoChannel& ch = channels[channel];
+
+    while (true) {
+        if (!ch.feeding) {
+            // 取出下一条排队的送料请求
+            if (ch.queueCount == 0) {
+                return;
+            }
+            FeedRequest next = ch.queue[ch.queueHead];
+            ch.queueHead = (ch.queueHead + 1) % FEED_QUEUE_DEPTH;
+            ch.queueCount--;
+            beginFeed(channel, next);
         }
 
-        // 移动到0度位置
-        myservo.write(DEFAULT_RETRACT_ANGLE);
-        startTime = millis();
-        while (millis() - startTime < DEFAULT_SETTLE_TIME) {
-            myservo.tick(); // 必须持续调用tick()
-            delay(1);
+        if (ch.remainingFeedLength == 0) {
+            // 送料完成，推进杆停在推进位，下一次送料时再回退
+            finishFeed(channel);
+            continue;
         }
 
-        // 回到90度位置
-        myservo.write(DEFAULT_FULL_ADVANCE_ANGLE);
-        startTime = millis();
-        while (millis() - startTime < DEFAULT_SETTLE_TIME) {
-            myservo.tick(); // 必须持续调用tick()
-            delay(1);
+        FeedStep step = nextFeedStep(ch.leverPosition, ch.remainingFeedLength, FEEDER_MECHANICAL_ADVANCE_LENGTH);
+        ch.remainingFeedLength -= step.fedLength;
+        if (moveLever(channel, step.target)) {
+            return;
         }
     }
-    
-    DEBUG_PRINTLN("Feed tape action completed");
 }
 
-// 舵机tick函数，需要在主循环中频繁调用
-void servoTick() {
-    myservo.tick();
+void servo_update()
+{
+    uint32_t now = millis();
+
+    for (uint8_t i = 0; i < FEEDERS_PER_HAND; i++) {
+        ServoChannel& ch = channels[i];
+        uint32_t elapsed = now - ch.phaseStartMs;
+
+        switch (ch.state) {
+            case MOTION_MOVING:
+                if (elapsed >= ch.profile.durationMs) {
+                    writeServoAngle(i, ch.targetAngle);
+                    ch.writtenAngle = ch.targetAngle;
+                    ch.settleMs = activeSettleTimeMs(i);
+                    ch.phaseStartMs = now;
+                    ch.state = MOTION_SETTLING;
+                } else {
+                    int angle = (int)lroundf(motionProfileAngle(ch.profile, elapsed));
+                    if (angle != ch.writtenAngle) {
+                        writeServoAngle(i, angle);
+                        ch.writtenAngle = angle;
+                    }
+                }
+                break;
+
+            case MOTION_SETTLING:
+                if (elapsed >= ch.settleMs) {
+                    ch.currentAngle = ch.targetAngle;
+                    ch.state = MOTION_IDLE;
+                    advanceFeed(i);
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
 }
 
-// 开机测试舵机函数
+bool queueFeed(uint8_t channel, const FeedRequest& request)
+{
+    if (channel >= FEEDERS_PER_HAND) {
+        return false;
+    }
+
+    if (!isFeedLengthValid(request.feedLength, FEEDER_MECHANICAL_ADVANCE_LENGTH)) {
+        DEBUG_PRINTF("Feed length %dmm is not a multiple of the half stroke\n", request.feedLength);
+        return false;
+    }
+
+    ServoChannel& ch = channels[channel];
+    if (ch.queueCount >= FEED_QUEUE_DEPTH) {
+        DEBUG_PRINTF("Feed queue ch%d full\n", channel);
+        return false;
+    }
+
+    ch.queue[(ch.queueHead + ch.queueCount) % FEED_QUEUE_DEPTH] = request;
+    ch.queueCount++;
+
+    // 通道空闲时立即开始，否则在当前送料完成后依次执行
+    if (ch.state == MOTION_IDLE && !ch.feeding) {
+        advanceFeed(channel);
+    }
+    return true;
+}
+
+bool isFeedBusy(uint8_t channel)
+{
+    if (channel >= FEEDERS_PER_HAND) {
+        return false;
+    }
+    const ServoChannel& ch = channels[channel];
+    return ch.feeding || ch.queueCount > 0 || ch.state != MOTION_IDLE;
+}
+
+uint8_t getFeedQueueLength(uint8_t channel)
+{
+    return channel < FEEDERS_PER_HAND ? channels[channel].queueCount : 0;
+}
+
+uint32_t getServoCycleCount()
+{
+    return servoCycleCount;
+}
+
+void setFeedCompleteCallback(FeedCompleteCallback callback)
+{
+    feedCompleteCallback = callback;
+}
+
+void startSettleCalibration(uint8_t channel)
+{
+    if (channel >= FEEDERS_PER_HAND) {
+        return;
+    }
+    // 切换通道时先结束之前的校准
+    stopSettleCalibration();
+    calibrationChannel = channel;
+    settleTuner.begin();
+    calibrationFeedUnconfirmed = false;
+    DEBUG_PRINTF("Settle calibration ch%d started at %dms\n", channel, settleTuner.settleTimeMs());
+}
+
+void stopSettleCalibration()
+{
+    if (!settleTuner.isActive()) {
+        return;
+    }
+    // 未确认的送料视为正常后再结束，保留最后可靠值
+    if (calibrationFeedUnconfirmed) {
+        calibrationFeedUnconfirmed = false;
+        settleTuner.reportFeed(true);
+    }
+    settleTuner.abort();
+    saveSettleTime(calibrationChannel, settleTuner.settleTimeMs());
+}
+
+bool reportPickFailure(uint8_t channel)
+{
+    if (!isCalibratingChannel(channel) || !calibrationFeedUnconfirmed) {
+        return false;
+    }
+    calibrationFeedUnconfirmed = false;
+    settleTuner.reportFeed(false);
+    saveSettleTime(channel, settleTuner.settleTimeMs());
+    return true;
+}
+
+bool isSettleCalibrating(uint8_t channel)
+{
+    return isCalibratingChannel(channel);
+}
+
+uint16_t getSettleTimeMs(uint8_t channel)
+{
+    if (channel >= FEEDERS_PER_HAND) {
+        return 0;
+    }
+    return activeSettleTimeMs(channel);
+}
+
+void getLastServoMotionUs(uint8_t channel, uint32_t& startUs, uint32_t& endUs) {
+    if (channel >= FEEDERS_PER_HAND) {
+        startUs = endUs = micros();
+        return;
+    }
+    startUs = channels[channel].feedStartUs;
+    endUs = channels[channel].feedEndUs;
+}
+
+void printServoJitter() {
+#ifdef SERVO_JITTER_PROBE
+    PulseJitterStats periodJitter;
+    PulseJitterStats widthJitter;
+    resetPulseJitter(periodJitter);
+    resetPulseJitter(widthJitter);
+
+    noInterrupts();
+    for (uint8_t i = 0; i < probeSampleCount; i++) {
+        recordPulseJitter(periodJitter, probeSamples[i].periodUs, SERVO_PERIOD_US);
+        recordPulseJitter(widthJitter, probeSamples[i].highUs, probeSamples[i].expectedHighUs);
+    }
+    interrupts();
+
+    DEBUG_PRINTLN("=== 舵机脉冲抖动（最近64个脉冲）===");
+    DEBUG_PRINTF("周期: n=%u min=%dus max=%dus p-p=%uus mean|dev|=%uus\n",
+                 periodJitter.count, periodJitter.minDeviationUs, periodJitter.maxDeviationUs,
+                 pulseJitterPeakToPeakUs(periodJitter), pulseJitterMeanAbsUs(periodJitter));
+    DEBUG_PRINTF("脉宽: n=%u min=%dus max=%dus p-p=%uus mean|dev|=%uus\n",
+                 widthJitter.count, widthJitter.minDeviationUs, widthJitter.maxDeviationUs,
+                 pulseJitterPeakToPeakUs(widthJitter), pulseJitterMeanAbsUs(widthJitter));
+#else
+    DEBUG_PRINTLN("Servo jitter probe disabled");
+#endif
+}
+
+// 开机测试舵机函数（阻塞，所有通道同时动作）
 void testServoOnStartup() {
     DEBUG_PRINTLN("\n=== Starting Servo Test ===");
     
@@ -75,23 +533,29 @@ void testServoOnStartup() {
         DEBUG_PRINTF("Test step %d: Moving to %s position (%d°)\n", 
                      i + 1, angleNames[i], testAngles[i]);
         
-        myservo.write(testAngles[i]);
-        
-        // 等待300ms，持续调用tick
-        unsigned long startTime = millis();
-        while (millis() - startTime < 300) {
-            myservo.tick();
-            delay(1);
+        for (uint8_t ch = 0; ch < FEEDERS_PER_HAND; ch++) {
+            writeServoAngle(ch, testAngles[i]);
         }
         
+        // 等待300ms
+        delay(SERVO_TEST_DELAY);
+        
         DEBUG_PRINTF("  - Reached %d°\n", testAngles[i]);
     }
     
     DEBUG_PRINTLN("=== Servo Test Complete ===\n");
     delay(500); // 额外延迟确保舵机稳定
+    for (uint8_t ch = 0; ch < FEEDERS_PER_HAND; ch++) {
+        channels[ch].currentAngle = testAngles[3];
+        channels[ch].writtenAngle = testAngles[3];
+        channels[ch].leverPosition = LEVER_FULL_ADVANCED;
+    }
 }
 
 void feedOnce() {
-    feedTapeAction(4); // 例如推进16mm
-    DEBUG_PRINTLN("Feed action completed");
-}
\ No newline at end of file
+    // 按钮送料作用于第一个通道，不需要回复
+    FeedRequest request = {DEFAULT_FEED_LENGTH, false, 0, (uint32_t)micros(), false};
+    if (queueFeed(0, request)) {
+        DEBUG_PRINTLN("Feed action queued");
+    }
+}
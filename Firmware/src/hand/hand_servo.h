@@ -4,12 +4,44 @@
 #include <Arduino.h>
 #include "hand_config.h"
 
+// 送料请求：序列号和接收时间用于回复和链路追踪，按钮触发的送料不需要回复
+struct FeedRequest {
+    uint8_t feedLength;                 // 送料长度(mm)，2的倍数
+    bool needReply;
+    uint32_t sequence;
+    uint32_t receivedUs;
+    bool overrideError;                 // 反馈线报错时仍然送料（M600 X1）
+};
+
+// 送料结果（同demo tFeederErrorState），送料前检查反馈线
+typedef enum {
+    FEED_OK = 0,                        // 反馈线正常，已送料
+    FEED_OK_NO_FEEDBACK = 1,            // 未安装反馈线，已送料
+    FEED_ERROR_IGNORED = 2,             // 反馈线报错但请求忽略错误，已送料
+    FEED_ERROR = 3                      // 反馈线报错，未送料
+} FeedResult;
+
+// 送料完成回调，channel为通道号（0 ~ FEEDERS_PER_HAND-1）
+typedef void (*FeedCompleteCallback)(uint8_t channel, const FeedRequest& request, FeedResult result);
 
 // 舵机控制函数
 void setup_Servo();
+void servo_update(); // 推进各通道的运动状态机，需要在主循环中调用
 void testServoOnStartup(); // 开机测试舵机
-void feedTapeAction(uint8_t feedLength);
-void servoTick(); // 需要在主循环中调用
+bool queueFeed(uint8_t channel, const FeedRequest& request); // 空闲时立即开始，否则排队；长度无效或队列满时返回false
+bool isFeedBusy(uint8_t channel);
+uint8_t getFeedQueueLength(uint8_t channel);
+uint32_t getServoCycleCount(); // 所有通道累计的送料动作次数（反馈线报错未送料的不计）
+void setFeedCompleteCallback(FeedCompleteCallback callback);
 void feedOnce();
+void getLastServoMotionUs(uint8_t channel, uint32_t& startUs, uint32_t& endUs); // 最近一次送料动作的起止时间
+void printServoJitter(); // 打印脉冲抖动统计（需启用SERVO_JITTER_PROBE）
+
+// 稳定时间自整定（同一时间只校准一个通道）
+void startSettleCalibration(uint8_t channel);
+void stopSettleCalibration();   // 结束校准并保存最后可靠值
+bool reportPickFailure(uint8_t channel); // 报告上一次送料取料失败，校准中返回true并结束校准
+bool isSettleCalibrating(uint8_t channel);
+uint16_t getSettleTimeMs(uint8_t channel); // 当前使用的稳定时间
 
-#endif
\ No newline at end of file
+#endif
@@ -1,8 +1,15 @@
 #include "hand_udp.h"
 #include "feeder_id_manager.h"
 #include "hand_servo.h"
+#include "feed_planner.h"
 #include "hand_config.h"
 #include "hand_led.h"
+#include "hand_loop.h"
+#include "hand_health.h"
+#include "common/udp_transport.h"
+#if HAND_TRANSPORT == TRANSPORT_ESPNOW
+#include "common/espnow_transport.h"
+#endif
 
 #if defined ESP32
 #include <WiFi.h>
@@ -20,13 +27,19 @@
 // =============================================================================
 
 UDPConnectionState udpState = UDP_STATE_DISCONNECTED;
-BrainInfo connectedBrain = {IPAddress(0, 0, 0, 0), 0, 0, false, ""};
+BrainInfo connectedBrain = {IPAddress(0, 0, 0, 0), 0, {TRANSPORT_UDP, {0}}, 0, false, ""};
 UDPStats udpStats = {0};
 
 // UDP对象
 WiFiUDP udp;
 WiFiUDP discoveryUdp;
 
+// 命令通道传输：UDP主端口总是打开（未分配ID时和Brain主备切换后使用），ESP-NOW按HAND_TRANSPORT开启
+static UdpTransport udpTransport(udp, UDP_HAND_PORT);
+#if HAND_TRANSPORT == TRANSPORT_ESPNOW
+static EspNowTransport espNowTransport;
+#endif
+
 // 时间戳变量
 uint32_t lastDiscoveryTime = 0;
 uint32_t lastHeartbeatTime = 0;
@@ -35,19 +48,122 @@ uint32_t lastBrainCheckTime = 0;
 // 接收缓冲区 - 优化大小
 uint8_t udpBuffer[UDP_BUFFER_SIZE];
 
+// Hand端送料链路追踪
+static FeedTraceRing<HAND_TRACE_DEPTH> handTrace;
+
 // 全局变量用于存储接收到的命令（保持与原ESP-NOW兼容）
 volatile bool hasNewCommand = false;
 volatile uint8_t receivedCommandType = 0;
 volatile uint8_t receivedFeederID = 0;
 volatile uint8_t receivedFeedLength = 0;
+volatile uint8_t receivedFlags = 0;      // 命令标志位(CMD_FLAG_*)
 volatile uint32_t commandTimestamp = 0;
 volatile uint32_t receivedSequence = 0;  // 保存收到的命令序列号
+volatile uint32_t commandReceivedUs = 0; // 收到命令的时间（链路追踪）
+
+// 待发送的响应队列：多通道Hand上各通道的送料可能同时完成
+struct PendingResponse {
+    uint8_t feederID;
+    uint8_t status;
+    uint8_t reason;                     // 错误原因码(ESPNowErrorReason)
+    char message[16];
+    uint32_t sequence;                  // 对应命令的序列号
+    uint32_t receivedUs;                // 链路追踪时间点
+    uint32_t servoStartUs;
+    uint32_t servoEndUs;
+};
+
+// 每个通道最近执行的命令，用于识别Brain重发的命令
+struct LastCommand {
+    uint32_t sequence;
+    uint32_t receivedMs;
+};
+static LastCommand lastCommands[FEEDERS_PER_HAND];
+
+#define RESPONSE_QUEUE_DEPTH (FEEDERS_PER_HAND + 2)
+static PendingResponse responseQueue[RESPONSE_QUEUE_DEPTH];
+static uint8_t responseHead = 0;
+static uint8_t responseCount = 0;
+
+static void queueResponse(uint8_t feederID, uint8_t status, uint8_t reason, const char* message, uint32_t sequence,
+                          uint32_t receivedUs, uint32_t servoStartUs, uint32_t servoEndUs) {
+    if (responseCount >= RESPONSE_QUEUE_DEPTH) {
+        DEBUG_PRINTF("UDP: 响应队列已满，丢弃 seq=%u\n", sequence);
+        udpStats.errors++;
+        return;
+    }
+
+    PendingResponse& entry = responseQueue[(responseHead + responseCount) % RESPONSE_QUEUE_DEPTH];
+    entry.feederID = feederID;
+    entry.status = status;
+    entry.reason = reason;
+    strncpy(entry.message, message, sizeof(entry.message) - 1);
+    entry.message[sizeof(entry.message) - 1] = '\0';
+    entry.sequence = sequence;
+    entry.receivedUs = receivedUs;
+    entry.servoStartUs = servoStartUs;
+    entry.servoEndUs = servoEndUs;
+    responseCount++;
+}
+
+// 经connectedBrain所在的链路发送
+static bool sendToBrain(const uint8_t* data, size_t length) {
+#if HAND_TRANSPORT == TRANSPORT_ESPNOW
+    if (connectedBrain.address.type == TRANSPORT_ESPNOW) {
+        return espNowTransport.send(connectedBrain.address, data, length);
+    }
+#endif
+    return udpTransport.send(connectedBrain.address, data, length);
+}
+
+// 收到命令后立即确认，Brain据此测量往返时间并停止重发
+static void sendCommandAck(uint8_t feederID, uint32_t sequence) {
+    if (udpState != UDP_STATE_CONNECTED || !connectedBrain.isActive) {
+        return;
+    }
+
+    UDPAckPacket ack;
+    ack.packetType = UDP_PKT_ACK;
+    ack.feederId = feederID;
+    ack.sequence = sequence;
 
-// 全局变量用于响应状态管理
-volatile bool hasPendingResponse = false;
-volatile uint8_t pendingResponseFeederID = 0;
-volatile uint8_t pendingResponseStatus = 0;
-volatile char pendingResponseMessage[16] = {0};
+    if (!sendToBrain((uint8_t*)&ack, sizeof(ack))) {
+        udpStats.errors++;
+    }
+}
+
+// 某个通道送料完成（由舵机状态机回调）
+static void onFeedComplete(uint8_t channel, const FeedRequest& request, FeedResult result) {
+    if (result == FEED_ERROR) {
+        noteFeedError(REASON_TAPE_ERROR);
+    } else {
+        noteFeedOk();
+    }
+    if (!request.needReply) {
+        return;
+    }
+
+    uint32_t servoStartUs, servoEndUs;
+    getLastServoMotionUs(channel, servoStartUs, servoEndUs);
+
+    uint8_t feederID = getCurrentFeederID() + channel;
+    if (result == FEED_ERROR) {
+        queueResponse(feederID, STATUS_ERROR, REASON_TAPE_ERROR, "Tape error", request.sequence,
+                      request.receivedUs, servoStartUs, servoEndUs);
+        return;
+    }
+
+    char message[16];
+    if (isSettleCalibrating(channel)) {
+        snprintf(message, sizeof(message), "Cal %dms", getSettleTimeMs(channel));
+    } else if (result == FEED_ERROR_IGNORED) {
+        strcpy(message, "Err overridden");
+    } else {
+        strcpy(message, "Feed OK");
+    }
+    queueResponse(feederID, STATUS_OK, REASON_NONE, message, request.sequence,
+                  request.receivedUs, servoStartUs, servoEndUs);
+}
 
 // =============================================================================
 // 核心UDP函数实现
@@ -84,12 +200,20 @@ void udp_setup() {
     optimizeWiFiSettings();
 
     // 初始化UDP
-    if (udp.begin(UDP_HAND_PORT)) {
+    if (udpTransport.begin()) {
         DEBUG_PRINTF("UDP: Hand端监听端口 %d\n", UDP_HAND_PORT);
     } else {
         DEBUG_PRINTLN("UDP: Hand端端口初始化失败");
     }
 
+#if HAND_TRANSPORT == TRANSPORT_ESPNOW
+    if (espNowTransport.begin()) {
+        DEBUG_PRINTLN("UDP: ESP-NOW命令通道已启动");
+    } else {
+        DEBUG_PRINTLN("UDP: ESP-NOW初始化失败");
+    }
+#endif
+
     if (discoveryUdp.begin(UDP_DISCOVERY_PORT)) {
         DEBUG_PRINTF("UDP: 发现服务监听端口 %d\n", UDP_DISCOVERY_PORT);
     } else {
@@ -99,6 +223,9 @@ void udp_setup() {
     udpState = UDP_STATE_DISCONNECTED;
     resetUDPStats();
 
+    // 送料完成后异步回复
+    setFeedCompleteCallback(onFeedComplete);
+
     DEBUG_PRINTLN("UDP: 初始化完成");
 }
 
@@ -169,9 +296,7 @@ bool sendCommandAndWaitResponse(const ESPNowPacket& command, ESPNowResponse& res
     udpCommand.command = command;
 
     // 发送命令
-    udp.beginPacket(connectedBrain.ip, connectedBrain.port);
-    udp.write((uint8_t*)&udpCommand, sizeof(udpCommand));
-    bool sent = udp.endPacket();
+    bool sent = sendToBrain((uint8_t*)&udpCommand, sizeof(udpCommand));
 
     if (!sent) {
         DEBUG_PRINTLN("UDP: 命令发送失败");
@@ -218,11 +343,12 @@ void sendHeartbeat() {
     heartbeat.packetType = UDP_PKT_HEARTBEAT;
     heartbeat.deviceId = getCurrentFeederID();
     heartbeat.timestamp_low = getTimestampLow();  // 使用优化后的低16位时间戳
-    heartbeat.status = 0; // 正常状态
+    heartbeat.status = getHandStatusFlags();
+    heartbeat.feederCount = FEEDERS_PER_HAND;
+    takeLoopStats(heartbeat.loop);
+    fillHandHealth(heartbeat.health);
 
-    udp.beginPacket(connectedBrain.ip, connectedBrain.port);
-    udp.write((uint8_t*)&heartbeat, sizeof(heartbeat));
-    bool sent = udp.endPacket();
+    bool sent = sendToBrain((uint8_t*)&heartbeat, sizeof(heartbeat));
 
     if (sent) {
         udpStats.heartbeatsSent++;
@@ -238,76 +364,99 @@ void sendHeartbeat() {
 // 内部UDP处理函数实现
 // =============================================================================
 
-void processUDPData() {
-    // 处理主UDP端口的数据
-    int packetSize = udp.parsePacket();
-    if (packetSize > 0) {
-        IPAddress remoteIP = udp.remoteIP();
-        uint16_t remotePort = udp.remotePort();
-        
-        size_t len = udp.read(udpBuffer, sizeof(udpBuffer));
-        if (len > 0) {
-            printUDPPacket(udpBuffer, len, true);
+// 处理命令通道收到的一个包（任一链路）
+static void handleMainPacket(size_t len, const TransportAddress& from) {
+    printUDPPacket(udpBuffer, len, true);
+    
+    // 处理不同类型的包
+    UDPPacketType packetType = (UDPPacketType)udpBuffer[0];
+    
+    switch (packetType) {
+        case UDP_PKT_RESPONSE:
+            if (len >= UDP_RESPONSE_LEGACY_SIZE) {
+                handleBusinessResponse(*(UDPResponsePacket*)udpBuffer);
+            }
+            break;
             
-            // 处理不同类型的包
-            UDPPacketType packetType = (UDPPacketType)udpBuffer[0];
+        case UDP_PKT_COMMAND:
+            if (len >= sizeof(UDPCommandPacket)) {
+                UDPCommandPacket* cmdPkt = (UDPCommandPacket*)udpBuffer;
+                // 将UDP命令转换为原有的ESP-NOW命令格式
+                receivedCommandType = cmdPkt->command.commandType;
+                receivedFeederID = cmdPkt->command.feederId;
+                receivedFeedLength = cmdPkt->command.feedLength;
+                receivedFlags = cmdPkt->command.flags;
+                receivedSequence = cmdPkt->sequence;  // 保存命令序列号
+                commandTimestamp = millis();
+                commandReceivedUs = micros();
+                hasNewCommand = true;
+                DEBUG_PRINTF("UDP: 接收到命令 seq=%u cmd=0x%02X id=%d len=%d\n", 
+                           receivedSequence, receivedCommandType, receivedFeederID, receivedFeedLength);
+            }
+            break;
             
-            switch (packetType) {
-                case UDP_PKT_RESPONSE:
-                    if (len >= sizeof(UDPResponsePacket)) {
-                        handleBusinessResponse(*(UDPResponsePacket*)udpBuffer);
-                    }
-                    break;
-                    
-                case UDP_PKT_COMMAND:
-                    if (len >= sizeof(UDPCommandPacket)) {
-                        UDPCommandPacket* cmdPkt = (UDPCommandPacket*)udpBuffer;
-                        // 将UDP命令转换为原有的ESP-NOW命令格式
-                        receivedCommandType = cmdPkt->command.commandType;
-                        receivedFeederID = cmdPkt->command.feederId;
-                        receivedFeedLength = cmdPkt->command.feedLength;
-                        receivedSequence = cmdPkt->sequence;  // 保存命令序列号
-                        commandTimestamp = millis();
-                        hasNewCommand = true;
-                        DEBUG_PRINTF("UDP: 接收到命令 seq=%u cmd=0x%02X id=%d len=%d\n", 
-                                   receivedSequence, receivedCommandType, receivedFeederID, receivedFeedLength);
-                    }
-                    break;
-                    
-                case UDP_PKT_HEARTBEAT:
-                    if (len >= sizeof(UDPHeartbeatPacket)) {
-                        handleBrainHeartbeat(*(UDPHeartbeatPacket*)udpBuffer, remoteIP);
-                    }
-                    break;
-                    
-                default:
-                    DEBUG_PRINTF("UDP: 主端口收到未知包类型 0x%02X\n", packetType);
-                    break;
+        case UDP_PKT_HEARTBEAT:
+            if (len >= UDP_HEARTBEAT_BASE_SIZE) {
+                handleBrainHeartbeat(*(UDPHeartbeatPacket*)udpBuffer, from);
             }
-        }
+            break;
+
+        case UDP_PKT_DISCOVERY_RESPONSE:
+            // ESP-NOW的发现响应在命令通道上返回
+            if (from.type != TRANSPORT_UDP && len >= sizeof(UDPDiscoveryResponse)) {
+                handleDiscoveryResponse(*(UDPDiscoveryResponse*)udpBuffer, from);
+            }
+            break;
+            
+        default:
+            DEBUG_PRINTF("UDP: 主端口收到未知包类型 0x%02X\n", packetType);
+            break;
+    }
+}
+
+void processUDPData() {
+    // 处理命令通道的数据
+    TransportAddress from;
+    size_t len = udpTransport.receive(udpBuffer, sizeof(udpBuffer), from);
+    if (len > 0) {
+        handleMainPacket(len, from);
+    }
+
+#if HAND_TRANSPORT == TRANSPORT_ESPNOW
+    len = espNowTransport.receive(udpBuffer, sizeof(udpBuffer), from);
+    if (len > 0) {
+        // 收到的命令只有一个槽位，先处理UDP上收到的命令，避免被ESP-NOW的命令覆盖
+        processReceivedCommand();
+        handleMainPacket(len, from);
     }
+#endif
 
     // 处理发现端口的数据
-    packetSize = discoveryUdp.parsePacket();
+    int packetSize = discoveryUdp.parsePacket();
     if (packetSize > 0) {
         IPAddress remoteIP = discoveryUdp.remoteIP();
         
-        size_t len = discoveryUdp.read(udpBuffer, sizeof(udpBuffer));
+        len = discoveryUdp.read(udpBuffer, sizeof(udpBuffer));
         if (len > 0 && udpBuffer[0] == UDP_PKT_DISCOVERY_RESPONSE) {
             if (len >= sizeof(UDPDiscoveryResponse)) {
-                handleDiscoveryResponse(*(UDPDiscoveryResponse*)udpBuffer, remoteIP);
+                handleDiscoveryResponse(*(UDPDiscoveryResponse*)udpBuffer,
+                                        udpTransportAddress(remoteIP, UDP_DISCOVERY_PORT));
             }
         }
     }
 }
 
-void handleDiscoveryResponse(const UDPDiscoveryResponse& response, IPAddress fromIP) {
-    DEBUG_PRINTF("UDP: 收到Brain发现响应 从 %s:%d\n", 
-                 fromIP.toString().c_str(), response.brainPort);
+void handleDiscoveryResponse(const UDPDiscoveryResponse& response, const TransportAddress& from) {
+    DEBUG_PRINTF("UDP: 收到Brain发现响应 via %s\n", from.type == TRANSPORT_UDP ? "udp" : "espnow");
     
-    // 更新Brain信息
-    connectedBrain.ip = fromIP;  // 使用实际发送方IP，而不是包中的IP
-    connectedBrain.port = response.brainPort;
+    // 更新Brain信息：UDP使用实际发送方IP（而不是包中的IP）和包中的主端口，ESP-NOW直接使用发送方MAC
+    if (from.type == TRANSPORT_UDP) {
+        connectedBrain.ip = transportAddressIP(from);
+        connectedBrain.port = response.brainPort;
+        connectedBrain.address = udpTransportAddress(connectedBrain.ip, response.brainPort);
+    } else {
+        connectedBrain.address = from;
+    }
     connectedBrain.lastSeen = millis();
     connectedBrain.isActive = true;
     strncpy(connectedBrain.info, response.brainInfo, sizeof(connectedBrain.info) - 1);
@@ -332,13 +481,13 @@ void handleBusinessResponse(const UDPResponsePacket& response) {
     hasNewCommand = true; // 复用原有标志
 }
 
-void handleBrainHeartbeat(const UDPHeartbeatPacket& heartbeat, IPAddress fromIP) {
+void handleBrainHeartbeat(const UDPHeartbeatPacket& heartbeat, const TransportAddress& from) {
     // 验证心跳来源是否为已连接的Brain
-    if (connectedBrain.isActive && connectedBrain.ip == fromIP) {
+    if (connectedBrain.isActive && sameTransportAddress(connectedBrain.address, from)) {
         connectedBrain.lastSeen = millis();
-        DEBUG_PRINTF("UDP: 收到Brain心跳 来自 %s\n", fromIP.toString().c_str());
+        DEBUG_PRINTLN("UDP: 收到Brain心跳");
     } else {
-        DEBUG_PRINTF("UDP: 收到未知Brain心跳 来自 %s\n", fromIP.toString().c_str());
+        DEBUG_PRINTLN("UDP: 收到未知Brain心跳");
     }
 }
 
@@ -348,6 +497,23 @@ bool sendDiscoveryRequest() {
     request.handId = getCurrentFeederID();
     request.timestamp_low = getTimestampLow();  // 使用优化后的低16位时间戳
     snprintf(request.handInfo, sizeof(request.handInfo), "Hand-%d", request.handId);
+    request.feederCount = FEEDERS_PER_HAND;
+
+#if HAND_TRANSPORT == TRANSPORT_ESPNOW
+    // 已分配ID时在ESP-NOW上广播，Brain回复后命令通道改走ESP-NOW；未分配ID时仍用UDP（网页按IP设置ID）
+    if (request.handId != 255) {
+        bool espNowSent = espNowTransport.send(broadcastTransportAddress(TRANSPORT_ESPNOW),
+                                               (uint8_t*)&request, sizeof(request));
+        if (espNowSent) {
+            udpStats.discoveryRequests++;
+            DEBUG_PRINTLN("UDP: 发现请求已通过ESP-NOW广播");
+        } else {
+            DEBUG_PRINTLN("UDP: ESP-NOW发现请求发送失败");
+            udpStats.errors++;
+        }
+        return espNowSent;
+    }
+#endif
 
     // 广播发现请求
     IPAddress broadcastIP = WiFi.localIP();
@@ -392,21 +558,77 @@ void processReceivedCommand() {
     if (!hasNewCommand) return;
 
     hasNewCommand = false;
-    uint8_t myFeederID = getCurrentFeederID();
+    uint8_t baseFeederID = getCurrentFeederID();
+    uint8_t myFeederID = baseFeederID;
+    uint8_t channel = 0;
+
+    // 检查命令是否针对本设备：多通道Hand接受[baseFeederID, baseFeederID + FEEDERS_PER_HAND)
+    if (receivedFeederID != 255) {
+        if (baseFeederID == 255 || receivedFeederID < baseFeederID ||
+            receivedFeederID >= baseFeederID + FEEDERS_PER_HAND) {
+            return;
+        }
+        channel = receivedFeederID - baseFeederID;
+        myFeederID = receivedFeederID;
+    }
 
-    // 检查命令是否针对本设备
-    if (receivedFeederID != myFeederID && receivedFeederID != 255) {
+    // 确认丢失时Brain会重发同一序列号的命令，只重新确认，不重复送料
+    LastCommand& last = lastCommands[channel];
+    bool duplicate = receivedSequence == last.sequence && commandTimestamp - last.receivedMs < HAND_DUPLICATE_WINDOW_MS;
+    sendCommandAck(myFeederID, receivedSequence);
+    if (duplicate) {
+        DEBUG_PRINTF("UDP: 重复命令 seq=%u，已确认\n", receivedSequence);
         return;
     }
+    last.sequence = receivedSequence;
+    last.receivedMs = commandTimestamp;
 
     DEBUG_PRINTF("UDP: 处理命令 Type=0x%02X, ID=%d, Len=%d\n",
                  receivedCommandType, receivedFeederID, receivedFeedLength);
 
     switch (receivedCommandType) {
         case CMD_FEEDER_ADVANCE:
-            DEBUG_PRINTF("UDP: 喂料命令: %d mm\n", receivedFeedLength);
-            feedTapeAction(receivedFeedLength);
-            schedulePendingResponse(myFeederID, STATUS_OK, "Feed OK");
+            DEBUG_PRINTF("UDP: 喂料命令: 通道%d %d mm\n", channel, receivedFeedLength);
+        {
+            // 上一次送料未完成时排队，送料完成后由onFeedComplete回复
+            FeedRequest request = {receivedFeedLength, true, receivedSequence, commandReceivedUs,
+                                   (receivedFlags & CMD_FLAG_OVERRIDE_ERROR) != 0};
+            if (!isFeedLengthValid(receivedFeedLength, FEEDER_MECHANICAL_ADVANCE_LENGTH)) {
+                noteFeedError(REASON_INVALID_LENGTH);
+                schedulePendingResponse(myFeederID, STATUS_INVALID_PARAM, "Bad length", REASON_INVALID_LENGTH);
+            } else if (!queueFeed(channel, request)) {
+                noteFeedError(REASON_QUEUE_FULL);
+                schedulePendingResponse(myFeederID, STATUS_BUSY, "Queue full", REASON_QUEUE_FULL);
+            }
+        }
+            break;
+
+        case CMD_CALIBRATE_SETTLE: {
+            DEBUG_PRINTF("UDP: 稳定时间校准命令: %d\n", receivedFeedLength);
+            char calibMessage[16];
+            if (receivedFeedLength == 1) {
+                startSettleCalibration(channel);
+                snprintf(calibMessage, sizeof(calibMessage), "Calib on %dms", getSettleTimeMs(channel));
+            } else {
+                if (receivedFeedLength == 0 && isSettleCalibrating(channel)) {
+                    stopSettleCalibration();
+                }
+                snprintf(calibMessage, sizeof(calibMessage), "%s %dms",
+                         isSettleCalibrating(channel) ? "Cal" : "Settle", getSettleTimeMs(channel));
+            }
+            schedulePendingResponse(myFeederID, STATUS_OK, calibMessage);
+            break;
+        }
+
+        case CMD_PICK_FAILED:
+            DEBUG_PRINTLN("UDP: 取料失败报告");
+            if (reportPickFailure(channel)) {
+                char calibMessage[16];
+                snprintf(calibMessage, sizeof(calibMessage), "Cal done %dms", getSettleTimeMs(channel));
+                schedulePendingResponse(myFeederID, STATUS_OK, calibMessage);
+            } else {
+                schedulePendingResponse(myFeederID, STATUS_OK, "Noted");
+            }
             break;
 
         case CMD_HEARTBEAT:
@@ -436,52 +658,62 @@ void processReceivedCommand() {
     }
 }
 
-// 调度响应 - 保持与原来相同的接口
-void schedulePendingResponse(uint8_t feederID, uint8_t status, const char *message) {
-    pendingResponseFeederID = feederID;
-    pendingResponseStatus = status;
-    strncpy((char *)pendingResponseMessage, message, sizeof(pendingResponseMessage) - 1);
-    pendingResponseMessage[sizeof(pendingResponseMessage) - 1] = '\0';
-    hasPendingResponse = true;
+// 调度响应 - 保持与原来相同的接口（非送料命令没有舵机动作，区间长度为0）
+void schedulePendingResponse(uint8_t feederID, uint8_t status, const char *message, uint8_t reason) {
+    uint32_t now = micros();
+    queueResponse(feederID, status, reason, message, receivedSequence, commandReceivedUs, now, now);
 }
 
 // 处理待发送的响应 - 保持与原来相同的接口
 void processPendingResponse() {
-    if (!hasPendingResponse || udpState != UDP_STATE_CONNECTED || !connectedBrain.isActive) {
+    if (udpState != UDP_STATE_CONNECTED || !connectedBrain.isActive) {
         return;
     }
 
-    hasPendingResponse = false;
-
-    DEBUG_PRINTF("UDP: 发送响应: ID=%d, Status=%d, Msg=%s\n",
-                 pendingResponseFeederID, pendingResponseStatus, (char *)pendingResponseMessage);
-
-    // 创建UDP响应包
-    UDPResponsePacket udpResponse;
-    udpResponse.packetType = UDP_PKT_RESPONSE;
-    udpResponse.sequence = receivedSequence;  // 使用原始命令的序列号
-    udpResponse.timestamp = getCurrentTimestamp();
-    
-    // 填充业务响应
-    udpResponse.response.handId = pendingResponseFeederID;
-    udpResponse.response.commandType = CMD_RESPONSE;
-    udpResponse.response.status = pendingResponseStatus;
-    udpResponse.response.sequence = udpResponse.sequence;
-    udpResponse.response.timestamp = udpResponse.timestamp;
-    strncpy(udpResponse.response.message, (char *)pendingResponseMessage, sizeof(udpResponse.response.message) - 1);
-    udpResponse.response.message[sizeof(udpResponse.response.message) - 1] = '\0';
-
-    // 发送响应
-    udp.beginPacket(connectedBrain.ip, connectedBrain.port);
-    udp.write((uint8_t*)&udpResponse, sizeof(udpResponse));
-    bool sent = udp.endPacket();
-
-    if (sent) {
-        DEBUG_PRINTF("UDP: 响应已发送到 %s:%d\n", 
-                     connectedBrain.ip.toString().c_str(), connectedBrain.port);
-    } else {
-        DEBUG_PRINTLN("UDP: 响应发送失败");
-        udpStats.errors++;
+    while (responseCount > 0) {
+        PendingResponse& entry = responseQueue[responseHead];
+        responseHead = (responseHead + 1) % RESPONSE_QUEUE_DEPTH;
+        responseCount--;
+
+        DEBUG_PRINTF("UDP: 发送响应: ID=%d, Status=%d, Msg=%s\n",
+                     entry.feederID, entry.status, entry.message);
+
+        // 创建UDP响应包
+        UDPResponsePacket udpResponse;
+        udpResponse.packetType = UDP_PKT_RESPONSE;
+        udpResponse.sequence = entry.sequence;  // 使用原始命令的序列号
+        udpResponse.timestamp = getCurrentTimestamp();
+
+        // 填充业务响应
+        udpResponse.response.handId = entry.feederID;
+        udpResponse.response.commandType = CMD_RESPONSE;
+        udpResponse.response.status = entry.status;
+        udpResponse.response.reason = entry.reason;
+        memset(udpResponse.response.reserved, 0, sizeof(udpResponse.response.reserved));
+        udpResponse.response.sequence = udpResponse.sequence;
+        udpResponse.response.timestamp = udpResponse.timestamp;
+        strncpy(udpResponse.response.message, entry.message, sizeof(udpResponse.response.message) - 1);
+        udpResponse.response.message[sizeof(udpResponse.response.message) - 1] = '\0';
+
+        // 记录Hand端区间，并以发送时刻为基准回传偏移量
+        uint32_t sendUs = micros();
+        handTrace.record(TRACE_HAND_RECEIVE, entry.feederID, entry.sequence, entry.receivedUs, entry.servoStartUs);
+        handTrace.record(TRACE_SERVO_MOTION, entry.feederID, entry.sequence, entry.servoStartUs, entry.servoEndUs);
+        handTrace.record(TRACE_RESPONSE_SEND, entry.feederID, entry.sequence, entry.servoEndUs, sendUs);
+        udpResponse.timing.receiveOffsetUs = sendUs - entry.receivedUs;
+        udpResponse.timing.servoStartOffsetUs = sendUs - entry.servoStartUs;
+        udpResponse.timing.servoEndOffsetUs = sendUs - entry.servoEndUs;
+
+        // 发送响应
+        bool sent = sendToBrain((uint8_t*)&udpResponse, sizeof(udpResponse));
+
+        if (sent) {
+            DEBUG_PRINTF("UDP: 响应已发送到 %s:%d\n", 
+                         connectedBrain.ip.toString().c_str(), connectedBrain.port);
+        } else {
+            DEBUG_PRINTLN("UDP: 响应发送失败");
+            udpStats.errors++;
+        }
     }
 }
 
@@ -514,6 +746,15 @@ void printUDPStatus() {
     DEBUG_PRINTF("错误次数: %u\n", udpStats.errors);
 }
 
+void printHandTrace() {
+    DEBUG_PRINTLN("=== 送料链路追踪 ===");
+    for (size_t i = 0; i < handTrace.size(); i++) {
+        const FeedTraceSpan& span = handTrace.at(i);
+        DEBUG_PRINTF("seq=%u %s start=%u dur=%uus\n",
+                     span.sequence, getFeedTraceStageName(span.stage), span.startUs, span.durationUs);
+    }
+}
+
 void resetUDPStats() {
     memset(&udpStats, 0, sizeof(udpStats));
 }
@@ -46,14 +46,14 @@ void sendHeartbeat();
 // 处理接收到的UDP数据
 void processUDPData();
 
-// 处理发现响应
-void handleDiscoveryResponse(const UDPDiscoveryResponse& response, IPAddress fromIP);
+// 处理发现响应（UDP发现端口，或ESP-NOW命令通道）
+void handleDiscoveryResponse(const UDPDiscoveryResponse& response, const TransportAddress& from);
 
 // 处理业务响应
 void handleBusinessResponse(const UDPResponsePacket& response);
 
 // 处理Brain心跳包
-void handleBrainHeartbeat(const UDPHeartbeatPacket& heartbeat, IPAddress fromIP);
+void handleBrainHeartbeat(const UDPHeartbeatPacket& heartbeat, const TransportAddress& from);
 
 // 发送发现请求
 bool sendDiscoveryRequest();
@@ -69,7 +69,7 @@ void checkBrainConnection();
 void processReceivedCommand();
 
 // 调度响应
-void schedulePendingResponse(uint8_t feederID, uint8_t status, const char *message);
+void schedulePendingResponse(uint8_t feederID, uint8_t status, const char *message, uint8_t reason = REASON_NONE);
 
 // 处理待发送的响应
 void processPendingResponse();
@@ -87,4 +87,7 @@ void resetUDPStats();
 // 获取连接状态字符串
 const char* getUDPStateString();
 
+// 打印Hand端送料链路追踪记录
+void printHandTrace();
+
 #endif // HAND_UDP_H
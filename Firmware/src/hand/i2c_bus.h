@@ -0,0 +1,18 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <stdint.h>
+
+// =============================================================================
+// I2C总线抽象 - 驱动只依赖此接口，便于在主机上用模拟总线测试
+// =============================================================================
+
+class I2CBus {
+public:
+    virtual ~I2CBus() {}
+
+    // 向address写入length字节（第一个字节通常为寄存器地址），成功返回true
+    virtual bool write(uint8_t address, const uint8_t* data, uint8_t length) = 0;
+};
+
+#endif // I2C_BUS_H
@@ -0,0 +1,60 @@
+#include "motion_profile.h"
+#include <math.h>
+
+void planMotionProfile(MotionProfile& profile, float fromAngle, float toAngle,
+                       float maxVelocityDps, float accelerationDps2) {
+    float distance = fabsf(toAngle - fromAngle);
+    float velocity = maxVelocityDps / 1000.0f;              // °/ms
+    float acceleration = accelerationDps2 / 1000000.0f;     // °/ms²
+
+    profile.startAngle = fromAngle;
+    profile.distance = toAngle - fromAngle;
+    profile.acceleration = acceleration;
+
+    if (distance <= 0.0f || velocity <= 0.0f || acceleration <= 0.0f) {
+        profile.peakVelocity = 0.0f;
+        profile.accelTimeMs = 0.0f;
+        profile.cruiseTimeMs = 0.0f;
+        profile.durationMs = 0;
+        return;
+    }
+
+    float accelTime = velocity / acceleration;
+    float accelDistance = 0.5f * acceleration * accelTime * accelTime;
+
+    if (2.0f * accelDistance >= distance) {
+        // 距离太短达不到最高速度：三角形曲线
+        accelTime = sqrtf(distance / acceleration);
+        profile.peakVelocity = acceleration * accelTime;
+        profile.cruiseTimeMs = 0.0f;
+    } else {
+        profile.peakVelocity = velocity;
+        profile.cruiseTimeMs = (distance - 2.0f * accelDistance) / velocity;
+    }
+
+    profile.accelTimeMs = accelTime;
+    profile.durationMs = (uint32_t)ceilf(2.0f * accelTime + profile.cruiseTimeMs);
+}
+
+float motionProfileAngle(const MotionProfile& profile, uint32_t elapsedMs) {
+    float total = 2.0f * profile.accelTimeMs + profile.cruiseTimeMs;
+    float t = (float)elapsedMs;
+    float travelled;
+
+    if (t >= total) {
+        return profile.startAngle + profile.distance;
+    }
+
+    if (t < profile.accelTimeMs) {
+        travelled = 0.5f * profile.acceleration * t * t;
+    } else if (t < profile.accelTimeMs + profile.cruiseTimeMs) {
+        float accelDistance = 0.5f * profile.acceleration * profile.accelTimeMs * profile.accelTimeMs;
+        travelled = accelDistance + profile.peakVelocity * (t - profile.accelTimeMs);
+    } else {
+        float remaining = total - t;
+        travelled = fabsf(profile.distance) - 0.5f * profile.acceleration * remaining * remaining;
+    }
+
+    return profile.distance >= 0.0f ? profile.startAngle + travelled
+                                    : profile.startAngle - travelled;
+}
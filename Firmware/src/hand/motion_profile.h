@@ -0,0 +1,27 @@
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+
+#include <stdint.h>
+
+// =============================================================================
+// 舵机梯形速度曲线（加速 - 匀速 - 减速），纯计算，不依赖Arduino
+// =============================================================================
+
+struct MotionProfile {
+    float startAngle;                   // 起始角度(°)
+    float distance;                     // 带符号的移动角度(°)
+    float acceleration;                 // 加速度(°/ms²)
+    float peakVelocity;                 // 实际达到的最高速度(°/ms)
+    float accelTimeMs;                  // 加速段(与减速段相同)时长
+    float cruiseTimeMs;                 // 匀速段时长
+    uint32_t durationMs;                // 总时长(向上取整)
+};
+
+// 规划从fromAngle到toAngle的运动，速度单位°/s，加速度单位°/s²
+void planMotionProfile(MotionProfile& profile, float fromAngle, float toAngle,
+                       float maxVelocityDps, float accelerationDps2);
+
+// 计算运动开始后elapsedMs时刻的目标角度，超过总时长后返回终点角度
+float motionProfileAngle(const MotionProfile& profile, uint32_t elapsedMs);
+
+#endif // MOTION_PROFILE_H
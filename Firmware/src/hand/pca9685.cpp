@@ -0,0 +1,67 @@
+#include "pca9685.h"
+
+uint8_t pca9685Prescale(uint16_t frequencyHz) {
+    if (frequencyHz == 0) {
+        return 255;
+    }
+
+    // prescale = round(osc / (4096 * freq)) - 1
+    uint32_t divisor = (uint32_t)PCA9685_RESOLUTION * frequencyHz;
+    uint32_t value = (PCA9685_OSC_HZ + divisor / 2) / divisor;
+    if (value < 4) value = 4;
+    if (value > 256) value = 256;
+    return (uint8_t)(value - 1);
+}
+
+Pca9685::Pca9685(I2CBus& bus, uint8_t address, uint16_t staggerTicks)
+    : bus(bus), address(address), prescale(pca9685Prescale(50)), staggerTicks(staggerTicks) {}
+
+bool Pca9685::writeRegister(uint8_t reg, uint8_t value) {
+    uint8_t data[2] = {reg, value};
+    return bus.write(address, data, sizeof(data));
+}
+
+bool Pca9685::begin(uint16_t frequencyHz) {
+    prescale = pca9685Prescale(frequencyHz);
+
+    // 预分频只能在SLEEP状态下修改
+    if (!writeRegister(PCA9685_REG_MODE1, PCA9685_MODE1_SLEEP)) return false;
+    if (!writeRegister(PCA9685_REG_PRESCALE, prescale)) return false;
+    if (!writeRegister(PCA9685_REG_MODE2, PCA9685_MODE2_OUTDRV)) return false;
+    return writeRegister(PCA9685_REG_MODE1, PCA9685_MODE1_AI);
+}
+
+uint16_t Pca9685::pulseUsToTicks(uint16_t pulseUs) const {
+    // 每个计数 = (prescale + 1) / osc 秒
+    uint32_t ticks = ((uint32_t)pulseUs * (PCA9685_OSC_HZ / 1000) + 500UL * (prescale + 1))
+                     / (1000UL * (prescale + 1));
+    return ticks >= PCA9685_RESOLUTION ? PCA9685_RESOLUTION - 1 : (uint16_t)ticks;
+}
+
+bool Pca9685::setPulseUs(uint8_t channel, uint16_t pulseUs) {
+    if (channel >= PCA9685_CHANNELS) {
+        return false;
+    }
+
+    uint16_t on = (uint16_t)(channel * staggerTicks) % PCA9685_RESOLUTION;
+    uint16_t off = (on + pulseUsToTicks(pulseUs)) % PCA9685_RESOLUTION;
+
+    uint8_t data[5] = {
+        (uint8_t)(PCA9685_REG_LED0_ON_L + 4 * channel),
+        (uint8_t)(on & 0xFF), (uint8_t)(on >> 8),
+        (uint8_t)(off & 0xFF), (uint8_t)(off >> 8)
+    };
+    return bus.write(address, data, sizeof(data));
+}
+
+bool Pca9685::setOff(uint8_t channel) {
+    if (channel >= PCA9685_CHANNELS) {
+        return false;
+    }
+
+    uint8_t data[5] = {
+        (uint8_t)(PCA9685_REG_LED0_ON_L + 4 * channel),
+        0, 0, 0, PCA9685_LED_FULL
+    };
+    return bus.write(address, data, sizeof(data));
+}
@@ -0,0 +1,58 @@
+#ifndef PCA9685_H
+#define PCA9685_H
+
+#include <stdint.h>
+#include "i2c_bus.h"
+
+// =============================================================================
+// PCA9685 16通道PWM扩展芯片驱动 - 不依赖Arduino，通过I2CBus访问
+// =============================================================================
+
+#define PCA9685_CHANNELS        16
+#define PCA9685_OSC_HZ          25000000UL  // 内部振荡器频率
+#define PCA9685_RESOLUTION      4096        // 12位计数器
+
+// 寄存器地址
+#define PCA9685_REG_MODE1       0x00
+#define PCA9685_REG_MODE2       0x01
+#define PCA9685_REG_LED0_ON_L   0x06
+#define PCA9685_REG_PRESCALE    0xFE
+
+// MODE1/MODE2位定义
+#define PCA9685_MODE1_AI        0x20        // 寄存器地址自动递增
+#define PCA9685_MODE1_SLEEP     0x10        // 低功耗模式（修改预分频时必须进入）
+#define PCA9685_MODE2_OUTDRV    0x04        // 推挽输出
+#define PCA9685_LED_FULL        0x10        // LEDn_ON_H/LEDn_OFF_H中的常开/常关位
+
+class Pca9685 {
+private:
+    I2CBus& bus;
+    uint8_t address;
+    uint8_t prescale;
+    uint16_t staggerTicks;
+
+    bool writeRegister(uint8_t reg, uint8_t value);
+
+public:
+    // staggerTicks: 各通道脉冲起点依次错开的计数，分散多个舵机同时起动的电流
+    Pca9685(I2CBus& bus, uint8_t address, uint16_t staggerTicks = 0);
+
+    // 设置输出频率并唤醒芯片；振荡器唤醒后需等待500us再输出脉冲
+    bool begin(uint16_t frequencyHz);
+
+    // 设置通道脉宽（微秒）
+    bool setPulseUs(uint8_t channel, uint16_t pulseUs);
+
+    // 关闭通道输出（舵机不再保持力矩）
+    bool setOff(uint8_t channel);
+
+    // 脉宽换算为计数值
+    uint16_t pulseUsToTicks(uint16_t pulseUs) const;
+
+    uint8_t getPrescale() const { return prescale; }
+};
+
+// 计算给定输出频率的预分频值（限制在芯片允许的3-255范围内）
+uint8_t pca9685Prescale(uint16_t frequencyHz);
+
+#endif // PCA9685_H
@@ -0,0 +1,50 @@
+#include "servo_pulse.h"
+
+uint16_t servoAngleToPulseUs(int angle, uint16_t minPulseUs, uint16_t maxPulseUs) {
+    if (angle < 0) angle = 0;
+    if (angle > 180) angle = 180;
+
+    // 四舍五入到最近的微秒
+    uint32_t span = (uint32_t)(maxPulseUs - minPulseUs);
+    return (uint16_t)(minPulseUs + (span * (uint32_t)angle + 90) / 180);
+}
+
+bool planServoPulse(ServoPulseSchedule& schedule, uint16_t pulseUs, uint32_t periodUs) {
+    if (pulseUs == 0 || pulseUs >= periodUs) {
+        return false;
+    }
+
+    schedule.highUs = pulseUs;
+    schedule.lowUs = periodUs - pulseUs;
+    return true;
+}
+
+void resetPulseJitter(PulseJitterStats& stats) {
+    stats.count = 0;
+    stats.minDeviationUs = 0;
+    stats.maxDeviationUs = 0;
+    stats.sumAbsDeviationUs = 0;
+}
+
+void recordPulseJitter(PulseJitterStats& stats, uint32_t observedUs, uint32_t expectedUs) {
+    int32_t deviation = (int32_t)(observedUs - expectedUs);
+
+    if (stats.count == 0 || deviation < stats.minDeviationUs) stats.minDeviationUs = deviation;
+    if (stats.count == 0 || deviation > stats.maxDeviationUs) stats.maxDeviationUs = deviation;
+    stats.sumAbsDeviationUs += (uint32_t)(deviation < 0 ? -deviation : deviation);
+    stats.count++;
+}
+
+uint32_t pulseJitterPeakToPeakUs(const PulseJitterStats& stats) {
+    if (stats.count == 0) {
+        return 0;
+    }
+    return (uint32_t)(stats.maxDeviationUs - stats.minDeviationUs);
+}
+
+uint32_t pulseJitterMeanAbsUs(const PulseJitterStats& stats) {
+    if (stats.count == 0) {
+        return 0;
+    }
+    return stats.sumAbsDeviationUs / stats.count;
+}
@@ -0,0 +1,39 @@
+#ifndef SERVO_PULSE_H
+#define SERVO_PULSE_H
+
+#include <stdint.h>
+
+// =============================================================================
+// 舵机脉冲时序 - 纯计算，不依赖Arduino
+// 角度换算为高/低电平时长，交给ESP8266硬件定时器波形发生器输出
+// =============================================================================
+
+struct ServoPulseSchedule {
+    uint32_t highUs;                    // 高电平时长（脉宽）
+    uint32_t lowUs;                     // 低电平时长（周期 - 脉宽）
+};
+
+// 角度(0-180°，超出范围会被限制)换算为脉宽
+uint16_t servoAngleToPulseUs(int angle, uint16_t minPulseUs, uint16_t maxPulseUs);
+
+// 根据脉宽和周期生成波形时序，脉宽不小于周期时返回false
+bool planServoPulse(ServoPulseSchedule& schedule, uint16_t pulseUs, uint32_t periodUs);
+
+// 脉冲抖动统计：记录实测值与期望值的偏差
+struct PulseJitterStats {
+    uint32_t count;
+    int32_t minDeviationUs;
+    int32_t maxDeviationUs;
+    uint32_t sumAbsDeviationUs;
+};
+
+void resetPulseJitter(PulseJitterStats& stats);
+void recordPulseJitter(PulseJitterStats& stats, uint32_t observedUs, uint32_t expectedUs);
+
+// 峰峰值抖动，没有样本时返回0
+uint32_t pulseJitterPeakToPeakUs(const PulseJitterStats& stats);
+
+// 平均绝对偏差，没有样本时返回0
+uint32_t pulseJitterMeanAbsUs(const PulseJitterStats& stats);
+
+#endif // SERVO_PULSE_H
@@ -0,0 +1,84 @@
+#ifndef SETTLE_TUNER_H
+#define SETTLE_TUNER_H
+
+#include <stdint.h>
+
+// =============================================================================
+// 稳定时间自整定 - 纯计算，不依赖Arduino
+// 从已知可靠的起始值开始，每连续confirmFeeds次送料正常就缩短一步；
+// 一旦出现料带定位错误，退回到最后一次可靠值加安全余量并结束校准
+// =============================================================================
+
+class SettleTuner {
+private:
+    uint16_t startMs;
+    uint16_t minMs;
+    uint16_t stepMs;
+    uint16_t safetyMs;
+    uint8_t confirmFeeds;
+
+    bool active = false;
+    uint16_t currentMs = 0;             // 下一次送料使用的稳定时间
+    uint16_t lastGoodMs = 0;            // 最后一次确认可靠的稳定时间
+    uint8_t okCount = 0;                // 当前稳定时间下连续正常的次数
+
+    void finish(uint16_t resultMs) {
+        active = false;
+        currentMs = resultMs;
+    }
+
+public:
+    SettleTuner(uint16_t startMs, uint16_t minMs, uint16_t stepMs, uint16_t safetyMs, uint8_t confirmFeeds)
+        : startMs(startMs), minMs(minMs), stepMs(stepMs), safetyMs(safetyMs), confirmFeeds(confirmFeeds) {}
+
+    void begin() {
+        active = true;
+        currentMs = startMs;
+        lastGoodMs = startMs;
+        okCount = 0;
+    }
+
+    // 中止校准，保留最后一次确认可靠的值
+    void abort() {
+        if (active) {
+            finish(lastGoodMs);
+        }
+    }
+
+    bool isActive() const { return active; }
+    uint16_t settleTimeMs() const { return currentMs; }
+
+    // 报告一次校准送料的结果，返回true表示校准在此次报告后结束
+    bool reportFeed(bool registrationOk) {
+        if (!active) {
+            return false;
+        }
+
+        if (!registrationOk) {
+            uint32_t backedOff = (uint32_t)lastGoodMs + safetyMs;
+            finish(backedOff > startMs ? startMs : (uint16_t)backedOff);
+            return true;
+        }
+
+        if (++okCount < confirmFeeds) {
+            return false;
+        }
+
+        okCount = 0;
+        lastGoodMs = currentMs;
+        if (currentMs < minMs + stepMs) {
+            // 已到下限，当前值即为结果
+            finish(currentMs);
+            return true;
+        }
+        currentMs -= stepMs;
+        return false;
+    }
+};
+
+// EEPROM中保存的校准值：未校准或超过默认值（旧固件或数据损坏）时使用默认值
+inline uint16_t storedSettleTimeMs(bool calibrated, uint16_t stored, uint16_t defaultMs) {
+    return (calibrated && stored <= defaultMs) ? stored : defaultMs;
+}
+
+#endif // SETTLE_TUNER_H
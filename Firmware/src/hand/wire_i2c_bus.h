@@ -0,0 +1,23 @@
+#ifndef WIRE_I2C_BUS_H
+#define WIRE_I2C_BUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "i2c_bus.h"
+
+// 基于Arduino Wire库的I2C总线实现
+class WireI2CBus : public I2CBus {
+public:
+    void begin(int sdaPin, int sclPin, uint32_t clockHz) {
+        Wire.begin(sdaPin, sclPin);
+        Wire.setClock(clockHz);
+    }
+
+    bool write(uint8_t address, const uint8_t* data, uint8_t length) override {
+        Wire.beginTransmission(address);
+        Wire.write(data, length);
+        return Wire.endTransmission() == 0;
+    }
+};
+
+#endif // WIRE_I2C_BUS_H
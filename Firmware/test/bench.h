@@ -0,0 +1,111 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <new>
+
+// =============================================================================
+// 主机基准工具 - 统计每次操作的耗时(ns/op)和堆分配次数(allocs/op)。
+// 替换了全局operator new（glibc下还有malloc/calloc/realloc），每个测试程序只能有一个源文件包含本文件
+// =============================================================================
+
+static volatile uint64_t benchAllocations = 0;
+
+#if defined(__GLIBC__)
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* pointer, size_t size);
+extern "C" void __libc_free(void* pointer);
+
+extern "C" void* malloc(size_t size) {
+    benchAllocations++;
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+    benchAllocations++;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, size_t size) {
+    benchAllocations++;
+    return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void* pointer) {
+    __libc_free(pointer);
+}
+
+static inline void* benchRawAlloc(size_t size) {
+    return __libc_malloc(size);
+}
+#else
+static inline void* benchRawAlloc(size_t size) {
+    return malloc(size);
+}
+#endif
+
+void* operator new(size_t size) {
+    benchAllocations++;
+    void* pointer = benchRawAlloc(size > 0 ? size : 1);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+struct BenchResult {
+    double nsPerOp;
+    double allocsPerOp;
+};
+
+// 防止被测结果被编译器优化掉
+static volatile uint32_t benchSink = 0;
+
+// 运行iterations次body(i)，打印并返回ns/op和allocs/op
+template <typename Body>
+BenchResult runBench(const char* name, uint32_t iterations, Body body) {
+    // 预热一轮，排除首次调用的缓存和惰性初始化
+    for (uint32_t i = 0; i < iterations / 10 + 1; i++) {
+        body(i);
+    }
+
+    uint64_t allocationsBefore = benchAllocations;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        body(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    uint64_t allocations = benchAllocations - allocationsBefore;
+
+    BenchResult result;
+    result.nsPerOp = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    result.allocsPerOp = (double)allocations / iterations;
+    printf("BENCH %-32s %10.1f ns/op %8.3f allocs/op\n", name, result.nsPerOp, result.allocsPerOp);
+    return result;
+}
+
+#endif // BENCH_H
@@ -0,0 +1,118 @@
+#include <unity.h>
+#include <string.h>
+#include "../bench.h"
+#include "common/udp_packets.h"
+#include "common/udp_timestamp.h"
+#include "common/loopback_transport.h"
+#include "brain/brain_config.h"
+#include "brain/gcode_parse.h"
+#include "brain/pending_command.h"
+
+// =============================================================================
+// 热路径基准：打印ns/op和allocs/op（主机上的数值，只用于前后对比，不代表ESP32/ESP8266上的耗时）。
+// 热路径不允许堆分配，出现分配即失败
+// =============================================================================
+
+#define BENCH_ITERATIONS 1000000
+
+void setUp() {}
+void tearDown() {}
+
+static void test_bench_valid_packet() {
+    uint8_t data[sizeof(UDPResponsePacket)] = {UDP_PKT_RESPONSE};
+    BenchResult result = runBench("isValidUDPPacket", BENCH_ITERATIONS, [&](uint32_t i) {
+        benchSink += isValidUDPPacket(data, sizeof(data) - (i & 7), UDP_PKT_RESPONSE);
+    });
+    TEST_ASSERT_EQUAL_FLOAT(0, result.allocsPerOp);
+}
+
+static void test_bench_packet_fresh() {
+    BenchResult result = runBench("isTimestampLowFresh", BENCH_ITERATIONS, [&](uint32_t i) {
+        benchSink += isTimestampLowFresh((uint16_t)(i * 7), (uint16_t)i, 30000);
+    });
+    TEST_ASSERT_EQUAL_FLOAT(0, result.allocsPerOp);
+}
+
+static void test_bench_generate_sequence() {
+    BenchResult result = runBench("generateSequence", BENCH_ITERATIONS, [&](uint32_t) {
+        benchSink += generateSequence();
+    });
+    TEST_ASSERT_EQUAL_FLOAT(0, result.allocsPerOp);
+}
+
+static void test_bench_parse_parameter() {
+    BenchResult result = runBench("parseGcodeParameter", BENCH_ITERATIONS, [&](uint32_t) {
+        benchSink += (uint32_t)parseGcodeParameter("M600 N12 F4 X1", 'F', -1);
+    });
+    TEST_ASSERT_EQUAL_FLOAT(0, result.allocsPerOp);
+}
+
+static void test_bench_parse_feed_advance() {
+    BenchResult result = runBench("parseFeedAdvanceArgs", BENCH_ITERATIONS, [&](uint32_t) {
+        FeedAdvanceArgs args;
+        benchSink += parseFeedAdvanceArgs("M600 N12 F4 X1", 50, args) == nullptr ? args.feedLength : 0;
+    });
+    TEST_ASSERT_EQUAL_FLOAT(0, result.allocsPerOp);
+}
+
+static void test_bench_find_pending() {
+    static PendingCommand pending[MAX_PENDING_COMMANDS];
+    memset(pending, 0, sizeof(pending));
+    for (int i = 0; i < MAX_PENDING_COMMANDS; i++) {
+        pending[i].sequence = 1000 + i;
+        pending[i].feederId = i;
+        pending[i].waiting = true;
+    }
+    // 最坏情况：匹配的命令在表尾
+    BenchResult result = runBench("findPendingCommand (50)", BENCH_ITERATIONS, [&](uint32_t) {
+        benchSink += findPendingCommand(pending, MAX_PENDING_COMMANDS, 1000 + MAX_PENDING_COMMANDS - 1,
+                                        MAX_PENDING_COMMANDS - 1);
+    });
+    TEST_ASSERT_EQUAL_FLOAT(0, result.allocsPerOp);
+}
+
+static void test_bench_response_round_trip() {
+    TransportAddress brainAddress = {TRANSPORT_UDP, {10, 0, 0, 1, 0, 0}};
+    TransportAddress handAddress = {TRANSPORT_UDP, {10, 0, 0, 2, 0, 0}};
+    static LoopbackTransport brain(brainAddress);
+    static LoopbackTransport hand(handAddress);
+    static PendingCommand pending[MAX_PENDING_COMMANDS];
+    memset(pending, 0, sizeof(pending));
+    pending[MAX_PENDING_COMMANDS - 1].feederId = 3;
+    pending[MAX_PENDING_COMMANDS - 1].waiting = true;
+
+    UDPResponsePacket response;
+    memset(&response, 0, sizeof(response));
+    response.packetType = UDP_PKT_RESPONSE;
+    response.response.handId = 3;
+
+    // 发送 -> 接收 -> 校验 -> 零初始化拷贝 -> 匹配，与handleMainPacket/handleHandResponse相同
+    BenchResult result = runBench("response send+receive+match", BENCH_ITERATIONS / 10, [&](uint32_t i) {
+        response.sequence = i;
+        pending[MAX_PENDING_COMMANDS - 1].sequence = i;
+        hand.send(brainAddress, (const uint8_t*)&response, sizeof(response));
+
+        uint8_t buffer[LOOPBACK_PACKET_SIZE];
+        TransportAddress from;
+        size_t length = brain.receive(buffer, sizeof(buffer), from);
+        if (isValidUDPPacket(buffer, length, UDP_PKT_RESPONSE)) {
+            UDPResponsePacket received;
+            memset(&received, 0, sizeof(received));
+            memcpy(&received, buffer, length < sizeof(received) ? length : sizeof(received));
+            benchSink += findPendingCommand(pending, MAX_PENDING_COMMANDS, received.sequence, received.response.handId);
+        }
+    });
+    TEST_ASSERT_EQUAL_FLOAT(0, result.allocsPerOp);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_valid_packet);
+    RUN_TEST(test_bench_packet_fresh);
+    RUN_TEST(test_bench_generate_sequence);
+    RUN_TEST(test_bench_parse_parameter);
+    RUN_TEST(test_bench_parse_feed_advance);
+    RUN_TEST(test_bench_find_pending);
+    RUN_TEST(test_bench_response_round_trip);
+    return UNITY_END();
+}
@@ -0,0 +1,151 @@
+#include <unity.h>
+#include <string.h>
+#include "../bench.h"
+#include "brain/gcode_line.h"
+#include "brain/gcode_parse.h"
+
+// =============================================================================
+// 串口/TCP接收回调的拼行和入队：行队列（GCODE_LINE_QUEUE_DEPTH）满时每一行仍要得到回复
+// =============================================================================
+
+static GcodeLine queued[GCODE_LINE_QUEUE_DEPTH];
+static size_t queuedCount;
+static char lastReply[32];
+static size_t replyCount;
+
+static bool testQueue(const GcodeLine& line) {
+    if (queuedCount >= GCODE_LINE_QUEUE_DEPTH) {
+        return false;
+    }
+    queued[queuedCount++] = line;
+    return true;
+}
+
+static void testReply(const char* data, size_t length) {
+    size_t count = length < sizeof(lastReply) - 1 ? length : sizeof(lastReply) - 1;
+    memcpy(lastReply, data, count);
+    lastReply[count] = '\0';
+    replyCount++;
+}
+
+void setUp() {
+    queuedCount = 0;
+    replyCount = 0;
+    lastReply[0] = '\0';
+}
+
+void tearDown() {}
+
+static void test_receive_line_with_timing() {
+    GcodeLineReceiver receiver(GCODE_SOURCE_TCP, testQueue, testReply);
+    TEST_ASSERT_EQUAL(0, receiver.receive("M600 N", 6, 100));
+    TEST_ASSERT_EQUAL(1, receiver.receive("3 F4\r\n", 6, 250));
+    TEST_ASSERT_EQUAL(1, queuedCount);
+    TEST_ASSERT_EQUAL_STRING("M600 N3 F4", queued[0].text);
+    TEST_ASSERT_EQUAL_UINT32(100, queued[0].rxStartUs);
+    TEST_ASSERT_EQUAL_UINT32(250, queued[0].rxEndUs);
+    TEST_ASSERT_EQUAL_UINT8(GCODE_SOURCE_TCP, queued[0].source);
+    TEST_ASSERT_FALSE(queued[0].overflow);
+    TEST_ASSERT_EQUAL(0, replyCount);
+}
+
+static void test_split_chunks_and_blank_lines() {
+    // 一行分在多个TCP段中到达，一个段中也可能有多行和空行；行首尾空白被去掉
+    GcodeLineReceiver receiver(GCODE_SOURCE_TCP, testQueue, testReply);
+    TEST_ASSERT_EQUAL(0, receiver.receive("  M60", strlen("  M60"), 0));
+    TEST_ASSERT_EQUAL(1, receiver.receive("0 N3 F4 \n\r\n\nM6", strlen("0 N3 F4 \n\r\n\nM6"), 0));
+    TEST_ASSERT_EQUAL(1, receiver.receive("10\r\n", strlen("10\r\n"), 0));
+    TEST_ASSERT_EQUAL(2, queuedCount);
+    TEST_ASSERT_EQUAL_STRING("M600 N3 F4", queued[0].text);
+    TEST_ASSERT_EQUAL_STRING("M610", queued[1].text);
+}
+
+static void test_packet_with_several_lines() {
+    // 原生USB一个64字节数据包可能带多行，drainSerial一次读出后要拼出全部
+    const char packet[] = "M600 N12 F4\nM610 S1\r\nM621 N5\nM600 N3 F8 X1\n";
+    TEST_ASSERT_TRUE(sizeof(packet) - 1 <= 64);
+    GcodeLineReceiver receiver(GCODE_SOURCE_SERIAL, testQueue, testReply);
+    TEST_ASSERT_EQUAL(4, receiver.receive(packet, sizeof(packet) - 1, 0));
+    TEST_ASSERT_EQUAL(4, queuedCount);
+    TEST_ASSERT_EQUAL_STRING("M610 S1", queued[1].text);
+    TEST_ASSERT_EQUAL_STRING("M600 N3 F8 X1", queued[3].text);
+    TEST_ASSERT_EQUAL_UINT8(GCODE_SOURCE_SERIAL, queued[3].source);
+}
+
+static void test_overflow_line_is_queued() {
+    // 超长行仍然入队，由主循环回复line too long
+    char line[MAX_GCODE_LINE_LENGTH + 8];
+    memset(line, 'X', sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\n';
+    GcodeLineReceiver receiver(GCODE_SOURCE_SERIAL, testQueue, testReply);
+    TEST_ASSERT_EQUAL(1, receiver.receive(line, sizeof(line), 0));
+    TEST_ASSERT_TRUE(queued[0].overflow);
+    TEST_ASSERT_EQUAL(MAX_GCODE_LINE_LENGTH, strlen(queued[0].text));
+
+    // 下一行不受影响
+    TEST_ASSERT_EQUAL(1, receiver.receive("M610\n", 5, 0));
+    TEST_ASSERT_FALSE(queued[1].overflow);
+    TEST_ASSERT_EQUAL_STRING("M610", queued[1].text);
+}
+
+static void test_full_queue_replies_busy() {
+    // 一个TCP段中的行数超过队列深度：放不下的行立即回复busy，主循环处理的行各回复一次，每行都有回复
+    const size_t sent = GCODE_LINE_QUEUE_DEPTH + 4;
+    char stream[sent * 8 + 1];
+    stream[0] = '\0';
+    for (size_t i = 0; i < sent; i++) {
+        strcat(stream, "M610\r\n");
+    }
+
+    GcodeLineReceiver receiver(GCODE_SOURCE_TCP, testQueue, testReply);
+    TEST_ASSERT_EQUAL(sent, receiver.receive(stream, strlen(stream), 0));
+    TEST_ASSERT_EQUAL(GCODE_LINE_QUEUE_DEPTH, queuedCount);
+    TEST_ASSERT_EQUAL(sent - GCODE_LINE_QUEUE_DEPTH, replyCount);
+    TEST_ASSERT_EQUAL_UINT32(sent - GCODE_LINE_QUEUE_DEPTH, receiver.getBusyCount());
+    TEST_ASSERT_EQUAL_STRING("error busy\r\n", lastReply);
+
+    // 主循环取出队列中的行，各回复一次
+    for (size_t i = 0; i < queuedCount; i++) {
+        testReply("ok\r\n", 4);
+    }
+    queuedCount = 0;
+    TEST_ASSERT_EQUAL(sent, replyCount);
+
+    // 队列有空间后恢复正常入队
+    TEST_ASSERT_EQUAL(1, receiver.receive("M610\n", 5, 0));
+    TEST_ASSERT_EQUAL(1, queuedCount);
+    TEST_ASSERT_EQUAL_UINT32(sent - GCODE_LINE_QUEUE_DEPTH, receiver.getBusyCount());
+}
+
+static void test_reset_drops_partial_line() {
+    GcodeLineReceiver receiver(GCODE_SOURCE_TCP, testQueue, testReply);
+    receiver.receive("M60", 3, 0);
+    receiver.reset();
+    TEST_ASSERT_EQUAL(1, receiver.receive("M610\n", 5, 0));
+    TEST_ASSERT_EQUAL_STRING("M610", queued[0].text);
+}
+
+static void test_receive_does_not_allocate() {
+    // 接收回调中拼行入队，主循环取出后解析M号
+    static const char request[] = "M610 S1\r\n";
+    GcodeLineReceiver receiver(GCODE_SOURCE_TCP, testQueue, testReply);
+    BenchResult result = runBench("receive M610 + parse", 1000000, [&](uint32_t) {
+        receiver.receive(request, sizeof(request) - 1, 0);
+        benchSink += (uint32_t)parseGcodeParameter(queued[0].text, 'M', -1);
+        queuedCount = 0;
+    });
+    TEST_ASSERT_EQUAL_FLOAT(0, result.allocsPerOp);
+    TEST_ASSERT_EQUAL(0, replyCount);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_receive_line_with_timing);
+    RUN_TEST(test_split_chunks_and_blank_lines);
+    RUN_TEST(test_packet_with_several_lines);
+    RUN_TEST(test_overflow_line_is_queued);
+    RUN_TEST(test_full_queue_replies_busy);
+    RUN_TEST(test_reset_drops_partial_line);
+    RUN_TEST(test_receive_does_not_allocate);
+    return UNITY_END();
+}
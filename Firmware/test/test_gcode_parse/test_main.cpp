@@ -0,0 +1,79 @@
+#include <unity.h>
+#include <string.h>
+#include "brain/gcode_parse.h"
+
+// =============================================================================
+// G-code参数解析（parseParameter）和M600参数检查（processCommand的MCODE_ADVANCE分支）
+// =============================================================================
+
+void setUp() {}
+void tearDown() {}
+
+static void test_parameter_found() {
+    TEST_ASSERT_EQUAL_FLOAT(600, parseGcodeParameter("M600 N3 F4", 'M', -1));
+    TEST_ASSERT_EQUAL_FLOAT(3, parseGcodeParameter("M600 N3 F4", 'N', -1));
+    TEST_ASSERT_EQUAL_FLOAT(4, parseGcodeParameter("M600 N3 F4", 'F', -1));
+}
+
+static void test_parameter_missing_returns_default() {
+    TEST_ASSERT_EQUAL_FLOAT(-1, parseGcodeParameter("M600 N3", 'F', -1));
+    TEST_ASSERT_EQUAL_FLOAT(-1, parseGcodeParameter("", 'M', -1));
+}
+
+static void test_parameter_without_value_returns_zero() {
+    // 与原String::substring().toFloat()一致
+    TEST_ASSERT_EQUAL_FLOAT(0, parseGcodeParameter("M600 N F4", 'N', -1));
+    TEST_ASSERT_EQUAL_FLOAT(0, parseGcodeParameter("M600 N", 'N', -1));
+}
+
+static void test_parameter_negative_and_fraction() {
+    TEST_ASSERT_EQUAL_FLOAT(-2.5f, parseGcodeParameter("G1 X-2.5", 'X', 0));
+    TEST_ASSERT_EQUAL_FLOAT(1e2f, parseGcodeParameter("G1 X1e2", 'X', 0));
+}
+
+static void test_feed_advance_valid() {
+    FeedAdvanceArgs args;
+    TEST_ASSERT_NULL(parseFeedAdvanceArgs("M600 N7 F8", 50, args));
+    TEST_ASSERT_EQUAL_UINT8(7, args.feederNo);
+    TEST_ASSERT_EQUAL_UINT8(8, args.feedLength);
+    TEST_ASSERT_FALSE(args.overrideError);
+
+    TEST_ASSERT_NULL(parseFeedAdvanceArgs("M600 N0 X1", 50, args));
+    TEST_ASSERT_EQUAL_UINT8(2, args.feedLength);
+    TEST_ASSERT_TRUE(args.overrideError);
+}
+
+static void test_feed_advance_feeder_number() {
+    FeedAdvanceArgs args;
+    TEST_ASSERT_NOT_NULL(parseFeedAdvanceArgs("M600 F4", 50, args));
+    TEST_ASSERT_NOT_NULL(parseFeedAdvanceArgs("M600 N50 F4", 50, args));
+    TEST_ASSERT_NULL(parseFeedAdvanceArgs("M600 N49 F4", 50, args));
+}
+
+static void test_feed_advance_length() {
+    FeedAdvanceArgs args;
+    TEST_ASSERT_NOT_NULL(parseFeedAdvanceArgs("M600 N1 F3", 50, args));
+    TEST_ASSERT_NOT_NULL(parseFeedAdvanceArgs("M600 N1 F0", 50, args));
+    TEST_ASSERT_NOT_NULL(parseFeedAdvanceArgs("M600 N1 F26", 50, args));
+    TEST_ASSERT_NULL(parseFeedAdvanceArgs("M600 N1 F24", 50, args));
+}
+
+static void test_feeder_number_range() {
+    TEST_ASSERT_FALSE(isValidFeederNumber(-1, true, 50));
+    TEST_ASSERT_FALSE(isValidFeederNumber(-1, false, 50));
+    TEST_ASSERT_TRUE(isValidFeederNumber(0, true, 50));
+    TEST_ASSERT_FALSE(isValidFeederNumber(50, true, 50));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_parameter_found);
+    RUN_TEST(test_parameter_missing_returns_default);
+    RUN_TEST(test_parameter_without_value_returns_zero);
+    RUN_TEST(test_parameter_negative_and_fraction);
+    RUN_TEST(test_feed_advance_valid);
+    RUN_TEST(test_feed_advance_feeder_number);
+    RUN_TEST(test_feed_advance_length);
+    RUN_TEST(test_feeder_number_range);
+    return UNITY_END();
+}
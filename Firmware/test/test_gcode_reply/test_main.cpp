@@ -0,0 +1,81 @@
+#include <unity.h>
+#include <string.h>
+#include "../bench.h"
+#include "brain/brain_config.h"
+#include "brain/gcode_reply.h"
+
+// =============================================================================
+// G-code回复格式化：sendAnswer写入GCODE_REPLY_BUFFER_SIZE的静态缓冲区，handleHandResponse写入64字节的栈缓冲区
+// =============================================================================
+
+void setUp() {}
+void tearDown() {}
+
+static ESPNowResponse makeResponse(uint8_t status, uint8_t reason, const char* message) {
+    ESPNowResponse response;
+    memset(&response, 0, sizeof(response));
+    response.status = status;
+    response.reason = reason;
+    memcpy(response.message, message, strnlen(message, sizeof(response.message)));
+    return response;
+}
+
+static void test_format_answer() {
+    char buffer[GCODE_REPLY_BUFFER_SIZE];
+    TEST_ASSERT_EQUAL_INT(24, formatGcodeAnswer(buffer, sizeof(buffer), 0, "Feeder set disabled"));
+    TEST_ASSERT_EQUAL_STRING("ok Feeder set disabled\r\n", buffer);
+    formatGcodeAnswer(buffer, sizeof(buffer), 1, "Invalid parameters");
+    TEST_ASSERT_EQUAL_STRING("error Invalid parameters\r\n", buffer);
+    TEST_ASSERT_EQUAL_INT(4, formatGcodeAnswer(buffer, sizeof(buffer), 0, ""));
+    TEST_ASSERT_EQUAL_STRING("ok\r\n", buffer);
+}
+
+static void test_format_answer_too_long() {
+    // 超长回复（如M620）返回值 >= 缓冲区大小，sendAnswer改为分段发送
+    char message[GCODE_REPLY_BUFFER_SIZE];
+    memset(message, 'x', sizeof(message) - 1);
+    message[sizeof(message) - 1] = '\0';
+    char buffer[GCODE_REPLY_BUFFER_SIZE];
+    TEST_ASSERT_TRUE(formatGcodeAnswer(buffer, sizeof(buffer), 0, message) >= (int)sizeof(buffer));
+}
+
+static void test_format_hand_reply() {
+    char buffer[64];
+    formatHandReply(buffer, sizeof(buffer), CMD_FEEDER_ADVANCE, makeResponse(STATUS_OK, REASON_NONE, "Fed 4mm"));
+    TEST_ASSERT_EQUAL_STRING("ok Feed completed - Fed 4mm", buffer);
+    formatHandReply(buffer, sizeof(buffer), CMD_FEEDER_ADVANCE, makeResponse(STATUS_ERROR, REASON_TAPE_ERROR, "Tape"));
+    TEST_ASSERT_EQUAL_STRING("error Tape (tape error)", buffer);
+    formatHandReply(buffer, sizeof(buffer), CMD_FEEDER_ADVANCE, makeResponse(STATUS_ERROR, REASON_NONE, "Busy"));
+    TEST_ASSERT_EQUAL_STRING("error Busy", buffer);
+}
+
+static void test_hand_reply_unterminated_message() {
+    // message填满16字节、没有'\0'时按字段长度截断
+    char buffer[64];
+    ESPNowResponse response = makeResponse(STATUS_OK, REASON_NONE, "");
+    memset(response.message, 'A', sizeof(response.message));
+    formatHandReply(buffer, sizeof(buffer), CMD_HEARTBEAT, response);
+    TEST_ASSERT_EQUAL_STRING("ok AAAAAAAAAAAAAAAA", buffer);
+}
+
+static void test_format_does_not_allocate() {
+    // 每条回复都在热路径上格式化
+    static char replyBuffer[GCODE_REPLY_BUFFER_SIZE];
+    ESPNowResponse response = makeResponse(STATUS_OK, REASON_NONE, "Fed 4mm");
+    BenchResult result = runBench("format answer+hand reply", 1000000, [&](uint32_t i) {
+        benchSink += formatGcodeAnswer(replyBuffer, sizeof(replyBuffer), i & 1, "Feeder set enabled and operational");
+        char tcpResponse[64];
+        benchSink += formatHandReply(tcpResponse, sizeof(tcpResponse), CMD_FEEDER_ADVANCE, response);
+    });
+    TEST_ASSERT_EQUAL_FLOAT(0, result.allocsPerOp);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_format_answer);
+    RUN_TEST(test_format_answer_too_long);
+    RUN_TEST(test_format_hand_reply);
+    RUN_TEST(test_hand_reply_unterminated_message);
+    RUN_TEST(test_format_does_not_allocate);
+    return UNITY_END();
+}
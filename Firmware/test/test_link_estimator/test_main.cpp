@@ -0,0 +1,87 @@
+#include <unity.h>
+#include <string.h>
+#include "../bench.h"
+#include "brain/brain_config.h"
+#include "brain/link_estimator.h"
+
+// =============================================================================
+// 命令超时估计：按brain_config.h的UDP_RTO_*和ACTUATION_*计算重发间隔和送料等待时间
+// =============================================================================
+
+void setUp() {}
+void tearDown() {}
+
+static uint32_t rtoMs(const RttEstimator& rtt) {
+    return rtt.rtoMs(UDP_RTO_INITIAL_MS, UDP_RTO_MIN_MS, UDP_RTO_MAX_MS);
+}
+
+static void test_rto_without_samples() {
+    RttEstimator rtt;
+    memset(&rtt, 0, sizeof(rtt));
+    TEST_ASSERT_EQUAL_UINT32(UDP_RTO_INITIAL_MS, rtoMs(rtt));
+}
+
+static void test_rto_tracks_samples() {
+    RttEstimator rtt;
+    memset(&rtt, 0, sizeof(rtt));
+    rtt.addSample(4000);
+    TEST_ASSERT_EQUAL_UINT32(4000, rtt.srttUs);
+    TEST_ASSERT_EQUAL_UINT32(2000, rtt.rttvarUs);
+    TEST_ASSERT_EQUAL_UINT32(UDP_RTO_MIN_MS, rtoMs(rtt));      // 4 + 4*2 = 12ms，取下限
+
+    for (int i = 0; i < 50; i++) {
+        rtt.addSample(4000);
+    }
+    TEST_ASSERT_UINT32_WITHIN(10, 4000, rtt.srttUs);
+    TEST_ASSERT_LESS_OR_EQUAL(20, rtt.rttvarUs);
+
+    // 往返时间变长后重发间隔超过下限
+    for (int i = 0; i < 50; i++) {
+        rtt.addSample(150000);
+    }
+    TEST_ASSERT_TRUE(rtoMs(rtt) > UDP_RTO_MIN_MS);
+    TEST_ASSERT_TRUE(rtoMs(rtt) < UDP_RTO_MAX_MS);
+
+    rtt.addSample(2000000);
+    TEST_ASSERT_EQUAL_UINT32(UDP_RTO_MAX_MS, rtoMs(rtt));      // 取上限
+}
+
+static void test_actuation_budget() {
+    ActuationModel model;
+    memset(&model, 0, sizeof(model));
+    // 没有样本时按默认速率，加最小余量
+    TEST_ASSERT_EQUAL_UINT32(ACTUATION_DEFAULT_US_PER_MM * 4 / 1000 + ACTUATION_MIN_MARGIN_MS,
+                             model.budgetMs(4, ACTUATION_DEFAULT_US_PER_MM, ACTUATION_MIN_MARGIN_MS));
+
+    // 稳定的样本：等待时间接近实际耗时加最小余量
+    for (int i = 0; i < 50; i++) {
+        model.addSample(4, 400000);
+    }
+    uint32_t budget = model.budgetMs(8, ACTUATION_DEFAULT_US_PER_MM, ACTUATION_MIN_MARGIN_MS);
+    TEST_ASSERT_UINT32_WITHIN(10, 800 + ACTUATION_MIN_MARGIN_MS, budget);
+
+    // 长度为0的样本不计入
+    uint32_t samples = model.samples;
+    model.addSample(0, 400000);
+    TEST_ASSERT_EQUAL_UINT32(samples, model.samples);
+}
+
+static void test_sample_does_not_allocate() {
+    // handleHandResponse每个带timing的响应更新一次估计值并计算超时
+    RttEstimator rtt;
+    memset(&rtt, 0, sizeof(rtt));
+    BenchResult result = runBench("RttEstimator sample+rto", 1000000, [&](uint32_t i) {
+        rtt.addSample(3000 + (i & 1023));
+        benchSink += rtoMs(rtt);
+    });
+    TEST_ASSERT_EQUAL_FLOAT(0, result.allocsPerOp);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_rto_without_samples);
+    RUN_TEST(test_rto_tracks_samples);
+    RUN_TEST(test_actuation_budget);
+    RUN_TEST(test_sample_does_not_allocate);
+    return UNITY_END();
+}
@@ -0,0 +1,84 @@
+#include <unity.h>
+#include <math.h>
+#include "../bench.h"
+#include "hand/hand_config.h"
+#include "hand/motion_profile.h"
+#include "hand/feed_planner.h"
+
+// =============================================================================
+// 舵机运动曲线和送料步骤：按hand_servo.cpp的方式（每一步为曲线时长+SERVO_SETTLE_MARGIN_MS）
+// 计算送料周期，检查它比旧的“每次write后固定等待DEFAULT_SETTLE_TIME”短
+// =============================================================================
+
+void setUp() {}
+void tearDown() {}
+
+static float leverAngle(uint8_t position) {
+    switch (position) {
+        case LEVER_FULL_ADVANCED: return DEFAULT_FULL_ADVANCE_ANGLE;
+        case LEVER_HALF_ADVANCED: return DEFAULT_HALF_ADVANCE_ANGLE;
+        default:                  return DEFAULT_RETRACT_ANGLE;
+    }
+}
+
+// 稳态（上一次送料后推进杆在推进位）送出feedLength的周期
+static uint32_t profiledCycleMs(uint8_t feedLength) {
+    uint8_t position = LEVER_FULL_ADVANCED;
+    uint8_t remaining = feedLength;
+    uint32_t totalMs = 0;
+    while (remaining > 0) {
+        FeedStep step = nextFeedStep(position, remaining, FEEDER_MECHANICAL_ADVANCE_LENGTH);
+        MotionProfile profile;
+        planMotionProfile(profile, leverAngle(position), leverAngle(step.target),
+                          SERVO_MAX_VELOCITY_DPS, SERVO_ACCELERATION_DPS2);
+        totalMs += profile.durationMs + SERVO_SETTLE_MARGIN_MS;
+        position = step.target;
+        remaining -= step.fedLength;
+    }
+    return totalMs;
+}
+
+static void test_profile_reaches_target() {
+    MotionProfile profile;
+    planMotionProfile(profile, DEFAULT_RETRACT_ANGLE, DEFAULT_FULL_ADVANCE_ANGLE,
+                      SERVO_MAX_VELOCITY_DPS, SERVO_ACCELERATION_DPS2);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, DEFAULT_FULL_ADVANCE_ANGLE, motionProfileAngle(profile, profile.durationMs));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, DEFAULT_RETRACT_ANGLE, motionProfileAngle(profile, 0));
+
+    // 每毫秒的角度变化不超过最高速度
+    float previous = DEFAULT_RETRACT_ANGLE;
+    for (uint32_t t = 1; t <= profile.durationMs; t++) {
+        float angle = motionProfileAngle(profile, t);
+        TEST_ASSERT_TRUE(angle >= previous);
+        TEST_ASSERT_TRUE(angle - previous <= SERVO_MAX_VELOCITY_DPS / 1000.0f + 0.01f);
+        previous = angle;
+    }
+}
+
+static void test_cycle_shorter_than_fixed_settle() {
+    // 旧实现每4mm写三次角度（推进、回退、推进），每次固定等待DEFAULT_SETTLE_TIME
+    const uint8_t lengths[] = {4, 8, 12};
+    for (uint8_t length : lengths) {
+        uint32_t fixedMs = (uint32_t)(length / FEEDER_MECHANICAL_ADVANCE_LENGTH) * 3 * DEFAULT_SETTLE_TIME;
+        TEST_ASSERT_TRUE(profiledCycleMs(length) < fixedMs);
+    }
+}
+
+static void test_profile_sample_does_not_allocate() {
+    MotionProfile profile;
+    planMotionProfile(profile, DEFAULT_RETRACT_ANGLE, DEFAULT_FULL_ADVANCE_ANGLE,
+                      SERVO_MAX_VELOCITY_DPS, SERVO_ACCELERATION_DPS2);
+    // servo_update每个节拍调用一次
+    BenchResult result = runBench("motionProfileAngle", 100000, [&](uint32_t i) {
+        benchSink += (uint32_t)lroundf(motionProfileAngle(profile, i % (profile.durationMs + 1)));
+    });
+    TEST_ASSERT_EQUAL_FLOAT(0, result.allocsPerOp);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_profile_reaches_target);
+    RUN_TEST(test_cycle_shorter_than_fixed_settle);
+    RUN_TEST(test_profile_sample_does_not_allocate);
+    return UNITY_END();
+}
@@ -0,0 +1,121 @@
+#include <unity.h>
+#include <string.h>
+#include "common/udp_packets.h"
+#include "common/loopback_transport.h"
+#include "brain/pending_command.h"
+
+// =============================================================================
+// handleHandResponse的在途命令匹配：Hand的响应经内存回环送到Brain，按序列号+Feeder ID找到命令
+// =============================================================================
+
+#define TEST_PENDING_COUNT 8
+
+static PendingCommand pending[TEST_PENDING_COUNT];
+
+static TransportAddress testAddress(uint8_t id) {
+    TransportAddress address;
+    address.type = TRANSPORT_UDP;
+    memset(address.bytes, 0, sizeof(address.bytes));
+    address.bytes[3] = id;
+    return address;
+}
+
+void setUp() {
+    memset(pending, 0, sizeof(pending));
+}
+
+void tearDown() {}
+
+static void addPending(int slot, uint32_t sequence, uint8_t feederId) {
+    pending[slot].sequence = sequence;
+    pending[slot].feederId = feederId;
+    pending[slot].waiting = true;
+}
+
+static void sendResponse(LoopbackTransport& hand, const TransportAddress& brain, uint8_t feederId, uint32_t sequence,
+                         size_t length) {
+    UDPResponsePacket response;
+    memset(&response, 0, sizeof(response));
+    response.packetType = UDP_PKT_RESPONSE;
+    response.sequence = sequence;
+    response.response.handId = feederId;
+    response.response.status = STATUS_OK;
+    response.timing.receiveOffsetUs = 1000;
+    hand.send(brain, (const uint8_t*)&response, length);
+}
+
+// 与brain_udp.cpp的handleMainPacket相同：校验长度，旧固件的短包按timing为0处理，再匹配在途命令
+static int receiveAndMatch(LoopbackTransport& brain, UDPResponsePacket& response) {
+    uint8_t buffer[LOOPBACK_PACKET_SIZE];
+    TransportAddress from;
+    size_t length = brain.receive(buffer, sizeof(buffer), from);
+    if (!isValidUDPPacket(buffer, length, UDP_PKT_RESPONSE)) {
+        return -2;
+    }
+    memset(&response, 0, sizeof(response));
+    memcpy(&response, buffer, length < sizeof(response) ? length : sizeof(response));
+    return findPendingCommand(pending, TEST_PENDING_COUNT, response.sequence, response.response.handId);
+}
+
+static void test_match_by_sequence_and_feeder() {
+    addPending(0, 10, 1);
+    addPending(3, 11, 2);
+    addPending(5, 10, 4);           // 序列号相同但Feeder不同
+    TEST_ASSERT_EQUAL_INT(3, findPendingCommand(pending, TEST_PENDING_COUNT, 11, 2));
+    TEST_ASSERT_EQUAL_INT(5, findPendingCommand(pending, TEST_PENDING_COUNT, 10, 4));
+    TEST_ASSERT_EQUAL_INT(-1, findPendingCommand(pending, TEST_PENDING_COUNT, 11, 1));
+}
+
+static void test_completed_command_not_matched() {
+    addPending(2, 20, 7);
+    pending[2].waiting = false;
+    TEST_ASSERT_EQUAL_INT(-1, findPendingCommand(pending, TEST_PENDING_COUNT, 20, 7));
+}
+
+static void test_response_over_loopback() {
+    LoopbackTransport brain(testAddress(1));
+    LoopbackTransport hand(testAddress(2));
+    addPending(4, 42, 9);
+
+    UDPResponsePacket response;
+    sendResponse(hand, testAddress(1), 9, 42, sizeof(UDPResponsePacket));
+    TEST_ASSERT_EQUAL_INT(4, receiveAndMatch(brain, response));
+    TEST_ASSERT_EQUAL_UINT32(1000, response.timing.receiveOffsetUs);
+    TEST_ASSERT_TRUE(hasHandTiming(response.timing));
+}
+
+static void test_legacy_response_over_loopback() {
+    LoopbackTransport brain(testAddress(1));
+    LoopbackTransport hand(testAddress(2));
+    addPending(1, 43, 9);
+
+    UDPResponsePacket response;
+    sendResponse(hand, testAddress(1), 9, 43, UDP_RESPONSE_LEGACY_SIZE);
+    TEST_ASSERT_EQUAL_INT(1, receiveAndMatch(brain, response));
+    // 旧固件不带timing：不作为往返时间和送料耗时样本
+    TEST_ASSERT_FALSE(hasHandTiming(response.timing));
+
+    sendResponse(hand, testAddress(1), 9, 43, UDP_RESPONSE_LEGACY_SIZE - 1);
+    TEST_ASSERT_EQUAL_INT(-2, receiveAndMatch(brain, response));
+}
+
+static void test_lost_response_leaves_command_waiting() {
+    LoopbackTransport brain(testAddress(1));
+    LoopbackTransport hand(testAddress(2));
+    hand.setLoss(1);
+    addPending(0, 50, 3);
+
+    sendResponse(hand, testAddress(1), 3, 50, sizeof(UDPResponsePacket));
+    TEST_ASSERT_EQUAL(0, brain.pending());
+    TEST_ASSERT_TRUE(pending[0].waiting);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_match_by_sequence_and_feeder);
+    RUN_TEST(test_completed_command_not_matched);
+    RUN_TEST(test_response_over_loopback);
+    RUN_TEST(test_legacy_response_over_loopback);
+    RUN_TEST(test_lost_response_leaves_command_waiting);
+    return UNITY_END();
+}
@@ -0,0 +1,75 @@
+#include <unity.h>
+#include "../bench.h"
+#include "hand/hand_config.h"
+#include "hand/servo_pulse.h"
+
+// =============================================================================
+// 舵机脉冲时序：角度换算、硬件定时器的高/低电平时长和抖动统计（printServoJitter()使用）
+// =============================================================================
+
+void setUp() {}
+void tearDown() {}
+
+static void test_angle_to_pulse() {
+    TEST_ASSERT_EQUAL_UINT32(SERVO_MIN_PULSE_US, servoAngleToPulseUs(0, SERVO_MIN_PULSE_US, SERVO_MAX_PULSE_US));
+    TEST_ASSERT_EQUAL_UINT32((SERVO_MIN_PULSE_US + SERVO_MAX_PULSE_US) / 2,
+                             servoAngleToPulseUs(90, SERVO_MIN_PULSE_US, SERVO_MAX_PULSE_US));
+    TEST_ASSERT_EQUAL_UINT32(SERVO_MAX_PULSE_US, servoAngleToPulseUs(180, SERVO_MIN_PULSE_US, SERVO_MAX_PULSE_US));
+    // 超出范围的角度被限制
+    TEST_ASSERT_EQUAL_UINT32(SERVO_MIN_PULSE_US, servoAngleToPulseUs(-10, SERVO_MIN_PULSE_US, SERVO_MAX_PULSE_US));
+    TEST_ASSERT_EQUAL_UINT32(SERVO_MAX_PULSE_US, servoAngleToPulseUs(200, SERVO_MIN_PULSE_US, SERVO_MAX_PULSE_US));
+}
+
+static void test_pulse_schedule() {
+    ServoPulseSchedule schedule;
+    TEST_ASSERT_TRUE(planServoPulse(schedule, 1500, SERVO_PERIOD_US));
+    TEST_ASSERT_EQUAL_UINT32(1500, schedule.highUs);
+    TEST_ASSERT_EQUAL_UINT32(SERVO_PERIOD_US - 1500, schedule.lowUs);
+    TEST_ASSERT_FALSE(planServoPulse(schedule, SERVO_PERIOD_US, SERVO_PERIOD_US));
+    TEST_ASSERT_FALSE(planServoPulse(schedule, 0, SERVO_PERIOD_US));
+
+    // 整个角度范围的脉宽都能放进一个周期
+    for (int angle = 0; angle <= 180; angle++) {
+        uint16_t pulseUs = servoAngleToPulseUs(angle, SERVO_MIN_PULSE_US, SERVO_MAX_PULSE_US);
+        TEST_ASSERT_TRUE(planServoPulse(schedule, pulseUs, SERVO_PERIOD_US));
+        TEST_ASSERT_EQUAL_UINT32(SERVO_PERIOD_US, schedule.highUs + schedule.lowUs);
+    }
+}
+
+static void test_jitter_stats() {
+    PulseJitterStats stats;
+    resetPulseJitter(stats);
+    TEST_ASSERT_EQUAL_UINT32(0, pulseJitterPeakToPeakUs(stats));
+    TEST_ASSERT_EQUAL_UINT32(0, pulseJitterMeanAbsUs(stats));
+
+    recordPulseJitter(stats, SERVO_PERIOD_US + 10, SERVO_PERIOD_US);
+    recordPulseJitter(stats, SERVO_PERIOD_US - 10, SERVO_PERIOD_US);
+    recordPulseJitter(stats, SERVO_PERIOD_US + 30, SERVO_PERIOD_US);
+    TEST_ASSERT_EQUAL_INT(-10, stats.minDeviationUs);
+    TEST_ASSERT_EQUAL_INT(30, stats.maxDeviationUs);
+    TEST_ASSERT_EQUAL_UINT32(40, pulseJitterPeakToPeakUs(stats));
+    TEST_ASSERT_EQUAL_UINT32(16, pulseJitterMeanAbsUs(stats));
+}
+
+static void test_write_angle_does_not_allocate() {
+    // writeServoAngle每次更新舵机角度都要换算，SERVO_JITTER_PROBE每个周期记录一次偏差
+    PulseJitterStats stats;
+    resetPulseJitter(stats);
+    BenchResult result = runBench("servo pulse plan+record", 1000000, [&](uint32_t i) {
+        ServoPulseSchedule schedule;
+        uint16_t pulseUs = servoAngleToPulseUs(i % 181, SERVO_MIN_PULSE_US, SERVO_MAX_PULSE_US);
+        benchSink += planServoPulse(schedule, pulseUs, SERVO_PERIOD_US) ? schedule.lowUs : 0;
+        recordPulseJitter(stats, SERVO_PERIOD_US - 50 + (i % 100), SERVO_PERIOD_US);
+    });
+    benchSink += stats.count;
+    TEST_ASSERT_EQUAL_FLOAT(0, result.allocsPerOp);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_angle_to_pulse);
+    RUN_TEST(test_pulse_schedule);
+    RUN_TEST(test_jitter_stats);
+    RUN_TEST(test_write_angle_does_not_allocate);
+    return UNITY_END();
+}
@@ -0,0 +1,75 @@
+#include <unity.h>
+#include "hand/hand_config.h"
+#include "hand/settle_tuner.h"
+
+// =============================================================================
+// 稳定时间自整定：校准结果不能比未校准的默认值（SERVO_SETTLE_MARGIN_MS）更慢
+// =============================================================================
+
+void setUp() {}
+void tearDown() {}
+
+static SettleTuner makeTuner() {
+    return SettleTuner(SETTLE_TUNE_START_MS, SETTLE_TUNE_MIN_MS, SETTLE_TUNE_STEP_MS,
+                       SETTLE_TUNE_SAFETY_MS, SETTLE_TUNE_CONFIRM_FEEDS);
+}
+
+static void test_starts_from_default() {
+    SettleTuner tuner = makeTuner();
+    tuner.begin();
+    TEST_ASSERT_EQUAL_UINT32(SERVO_SETTLE_MARGIN_MS, tuner.settleTimeMs());
+}
+
+static void test_steps_down_and_backs_off() {
+    SettleTuner tuner = makeTuner();
+    tuner.begin();
+    for (int i = 0; i < 4 * SETTLE_TUNE_CONFIRM_FEEDS; i++) {
+        TEST_ASSERT_FALSE(tuner.reportFeed(true));
+    }
+    TEST_ASSERT_EQUAL_UINT32(SETTLE_TUNE_START_MS - 4 * SETTLE_TUNE_STEP_MS, tuner.settleTimeMs());
+
+    // 出错：退回最后可靠值加余量
+    TEST_ASSERT_TRUE(tuner.reportFeed(false));
+    TEST_ASSERT_FALSE(tuner.isActive());
+    TEST_ASSERT_EQUAL_UINT32(SETTLE_TUNE_START_MS - 3 * SETTLE_TUNE_STEP_MS + SETTLE_TUNE_SAFETY_MS,
+                             tuner.settleTimeMs());
+}
+
+static void test_result_never_exceeds_default() {
+    // 在第failAt次送料出错（或从不出错）、在第abortAt次后中止（或从不中止）的每种组合
+    const int maxFeeds = (SETTLE_TUNE_START_MS / SETTLE_TUNE_STEP_MS + 2) * SETTLE_TUNE_CONFIRM_FEEDS;
+    for (int failAt = 0; failAt <= maxFeeds; failAt++) {
+        for (int abortAt = 0; abortAt <= maxFeeds; abortAt++) {
+            SettleTuner tuner = makeTuner();
+            tuner.begin();
+            for (int feed = 0; feed < maxFeeds && tuner.isActive(); feed++) {
+                if (feed == abortAt) {
+                    tuner.abort();
+                    break;
+                }
+                tuner.reportFeed(feed != failAt);
+            }
+            tuner.abort();
+            TEST_ASSERT_LESS_OR_EQUAL(SERVO_SETTLE_MARGIN_MS, tuner.settleTimeMs());
+            TEST_ASSERT_TRUE(tuner.settleTimeMs() >= SETTLE_TUNE_MIN_MS);
+        }
+    }
+}
+
+static void test_stored_value() {
+    TEST_ASSERT_EQUAL_UINT32(SERVO_SETTLE_MARGIN_MS, storedSettleTimeMs(false, 40, SERVO_SETTLE_MARGIN_MS));
+    TEST_ASSERT_EQUAL_UINT32(40, storedSettleTimeMs(true, 40, SERVO_SETTLE_MARGIN_MS));
+    // 旧固件以DEFAULT_SETTLE_TIME为上限保存的值比默认值慢，不再使用
+    TEST_ASSERT_EQUAL_UINT32(SERVO_SETTLE_MARGIN_MS,
+                             storedSettleTimeMs(true, SERVO_SETTLE_MARGIN_MS + 1, SERVO_SETTLE_MARGIN_MS));
+    TEST_ASSERT_EQUAL_UINT32(SERVO_SETTLE_MARGIN_MS, storedSettleTimeMs(true, 0xFFFF, SERVO_SETTLE_MARGIN_MS));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_starts_from_default);
+    RUN_TEST(test_steps_down_and_backs_off);
+    RUN_TEST(test_result_never_exceeds_default);
+    RUN_TEST(test_stored_value);
+    return UNITY_END();
+}
@@ -0,0 +1,113 @@
+#include <unity.h>
+#include <string.h>
+#include "common/udp_packets.h"
+#include "common/udp_timestamp.h"
+
+// =============================================================================
+// 命令通道包校验、序列号和16位时间戳新鲜度
+// =============================================================================
+
+void setUp() {}
+void tearDown() {}
+
+static void test_valid_packet_rejects_null_and_empty() {
+    uint8_t data[1] = {UDP_PKT_PING};
+    TEST_ASSERT_FALSE(isValidUDPPacket(nullptr, 10, UDP_PKT_PING));
+    TEST_ASSERT_FALSE(isValidUDPPacket(data, 0, UDP_PKT_PING));
+    TEST_ASSERT_TRUE(isValidUDPPacket(data, 1, UDP_PKT_PING));
+}
+
+static void test_valid_packet_rejects_type_mismatch() {
+    uint8_t data[sizeof(UDPCommandPacket)] = {0};
+    data[0] = UDP_PKT_COMMAND;
+    TEST_ASSERT_TRUE(isValidUDPPacket(data, sizeof(data), UDP_PKT_COMMAND));
+    TEST_ASSERT_FALSE(isValidUDPPacket(data, sizeof(data), UDP_PKT_RESPONSE));
+}
+
+static void test_valid_packet_command_length() {
+    uint8_t data[sizeof(UDPCommandPacket)] = {0};
+    data[0] = UDP_PKT_COMMAND;
+    TEST_ASSERT_FALSE(isValidUDPPacket(data, sizeof(data) - 1, UDP_PKT_COMMAND));
+    TEST_ASSERT_TRUE(isValidUDPPacket(data, sizeof(data), UDP_PKT_COMMAND));
+}
+
+static void test_valid_packet_accepts_legacy_response() {
+    uint8_t data[sizeof(UDPResponsePacket)] = {0};
+    data[0] = UDP_PKT_RESPONSE;
+    // 不带timing的旧固件响应
+    TEST_ASSERT_EQUAL(sizeof(UDPResponsePacket) - sizeof(UDPHandTiming), UDP_RESPONSE_LEGACY_SIZE);
+    TEST_ASSERT_TRUE(isValidUDPPacket(data, UDP_RESPONSE_LEGACY_SIZE, UDP_PKT_RESPONSE));
+    TEST_ASSERT_FALSE(isValidUDPPacket(data, UDP_RESPONSE_LEGACY_SIZE - 1, UDP_PKT_RESPONSE));
+    TEST_ASSERT_TRUE(isValidUDPPacket(data, sizeof(data), UDP_PKT_RESPONSE));
+}
+
+static void test_valid_packet_accepts_legacy_heartbeat() {
+    uint8_t data[sizeof(UDPHeartbeatPacket)] = {0};
+    data[0] = UDP_PKT_HEARTBEAT;
+    TEST_ASSERT_TRUE(isValidUDPPacket(data, UDP_HEARTBEAT_LEGACY_SIZE, UDP_PKT_HEARTBEAT));
+    TEST_ASSERT_FALSE(isValidUDPPacket(data, UDP_HEARTBEAT_LEGACY_SIZE - 1, UDP_PKT_HEARTBEAT));
+}
+
+static void test_valid_packet_rejects_unknown_type() {
+    uint8_t data[32] = {0x7F};
+    TEST_ASSERT_FALSE(isValidUDPPacket(data, sizeof(data), (UDPPacketType)0x7F));
+}
+
+static void test_generate_sequence_is_monotonic_and_nonzero() {
+    uint32_t previous = generateSequence();
+    TEST_ASSERT_NOT_EQUAL(0, previous);
+    for (int i = 0; i < 1000; i++) {
+        uint32_t next = generateSequence();
+        TEST_ASSERT_EQUAL_UINT32(previous + 1, next);
+        previous = next;
+    }
+}
+
+static void test_fresh_within_age() {
+    TEST_ASSERT_TRUE(isTimestampLowFresh(1000, 1000, 30000));
+    TEST_ASSERT_TRUE(isTimestampLowFresh(30999, 1000, 30000));
+    TEST_ASSERT_FALSE(isTimestampLowFresh(31000, 1000, 30000));
+}
+
+static void test_fresh_across_16bit_wrap() {
+    // 发送时0xFFF0，现在已回绕到0x0010：年龄为0x20ms
+    TEST_ASSERT_TRUE(isTimestampLowFresh(0x0010, 0xFFF0, 0x21));
+    TEST_ASSERT_FALSE(isTimestampLowFresh(0x0010, 0xFFF0, 0x20));
+    TEST_ASSERT_TRUE(isTimestampLowFresh(0x0000, 0xFFFF, 30000));
+}
+
+static void test_fresh_large_max_age_always_fresh() {
+    // 16位时间戳区分不了超过65535ms的年龄
+    TEST_ASSERT_TRUE(isTimestampLowFresh(0, 1, 0x10000));
+    TEST_ASSERT_FALSE(isTimestampLowFresh(0, 1, 0xFFFF));
+}
+
+static void test_fresh_property_matches_modular_age() {
+    // 性质：对任意now/ts，结果等于 (now - ts) mod 65536 < maxAge
+    uint32_t state = 12345;
+    for (int i = 0; i < 100000; i++) {
+        state = state * 1103515245u + 12345u;
+        uint16_t now = state >> 8;
+        state = state * 1103515245u + 12345u;
+        uint16_t ts = state >> 8;
+        uint32_t maxAge = (state >> 4) & 0xFFFF;
+        uint32_t age = ((uint32_t)now + 0x10000 - ts) & 0xFFFF;
+        TEST_ASSERT_EQUAL(age < maxAge, isTimestampLowFresh(now, ts, maxAge));
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_valid_packet_rejects_null_and_empty);
+    RUN_TEST(test_valid_packet_rejects_type_mismatch);
+    RUN_TEST(test_valid_packet_command_length);
+    RUN_TEST(test_valid_packet_accepts_legacy_response);
+    RUN_TEST(test_valid_packet_accepts_legacy_heartbeat);
+    RUN_TEST(test_valid_packet_rejects_unknown_type);
+    RUN_TEST(test_generate_sequence_is_monotonic_and_nonzero);
+    RUN_TEST(test_fresh_within_age);
+    RUN_TEST(test_fresh_across_16bit_wrap);
+    RUN_TEST(test_fresh_large_max_age_always_fresh);
+    RUN_TEST(test_fresh_property_matches_modular_age);
+    return UNITY_END();
+}
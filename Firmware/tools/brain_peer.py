@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+主备Brain同步包观察与接管测试工具（需在Brain的brain_config.h中启用BRAIN_STANDBY_ENABLED）
+
+  watch                        打印网络中所有Brain广播的同步包（角色、优先级、条目）
+  failover --standby IP        在本机模拟一台主机Brain和一个Hand：向备机同步一个在线Hand
+                               （IP为本机）和可选的在途命令，然后停止广播，测量备机从
+                               最后一个同步包到向Hand发出发现响应（接管）的时间
+
+包结构见 src/common/udp_protocol.h（packed小端序）
+"""
+
+import argparse
+import json
+import socket
+import struct
+import sys
+import time
+import urllib.request
+
+UDP_PKT_DISCOVERY_RESPONSE = 0x11
+UDP_PKT_PEER_SYNC = 0x16
+
+PEER_SYNC_HEADER = struct.Struct("<BBBBI")              # UDPPeerSyncHeader
+PEER_FEEDER_ENTRY = struct.Struct("<BBB4sHIHIHHB")      # UDPPeerFeederEntry
+
+PEER_FEEDER_ONLINE = 0x01
+PEER_FEEDER_PENDING = 0x02
+
+ROLE_NAMES = {0: "startup", 1: "active", 2: "standby"}
+BRAIN_ROLE_ACTIVE = 1
+CMD_FEEDER_ADVANCE = 0x04
+
+UDP_DISCOVERY_PORT = 8268
+UDP_PEER_PORT = 8270
+
+
+def open_udp(port, broadcast=False):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    if broadcast:
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_BROADCAST, 1)
+    sock.bind(("", port))
+    return sock
+
+
+def local_ip_towards(ip):
+    """本机访问ip时使用的源地址"""
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    try:
+        sock.connect((ip, 1))
+        return sock.getsockname()[0]
+    finally:
+        sock.close()
+
+
+def decode_sync(data):
+    """返回(header元组, 条目列表)，长度不符时返回None"""
+    if len(data) < PEER_SYNC_HEADER.size:
+        return None
+    header = PEER_SYNC_HEADER.unpack_from(data)
+    count = header[3]
+    if len(data) < PEER_SYNC_HEADER.size + count * PEER_FEEDER_ENTRY.size:
+        return None
+    entries = [PEER_FEEDER_ENTRY.unpack_from(data, PEER_SYNC_HEADER.size + i * PEER_FEEDER_ENTRY.size)
+               for i in range(count)]
+    return header, entries
+
+
+def cmd_watch(args):
+    sock = open_udp(UDP_PEER_PORT)
+    start = time.monotonic()
+    while True:
+        data, (ip, _) = sock.recvfrom(512)
+        if not data or data[0] != UDP_PKT_PEER_SYNC:
+            continue
+        decoded = decode_sync(data)
+        if decoded is None:
+            print(f"{ip}: 长度错误 {len(data)}")
+            continue
+        (_, role, priority, count, next_seq), entries = decoded
+        print(f"{time.monotonic() - start:8.3f} {ip:15s} {ROLE_NAMES.get(role, role):8s} "
+              f"prio={priority} seq={next_seq} entries={count}")
+        if not args.entries:
+            continue
+        for (fid, flags, ch, hand_ip, age, total, session, p_seq, p_elapsed, p_timeout, p_cmd) in entries:
+            if not flags and not total:
+                continue
+            line = (f"    feeder {fid:2d} ch{ch} {socket.inet_ntoa(hand_ip) if flags & PEER_FEEDER_ONLINE else 'offline':15s}"
+                    f" age={age}s total={total} session={session}")
+            if flags & PEER_FEEDER_PENDING:
+                line += f" pending seq={p_seq} {p_elapsed}/{p_timeout}ms cmd=0x{p_cmd:02X}"
+            print(line)
+
+
+def build_sync(next_seq, feeder_id, hand_ip, pending_seq):
+    flags = PEER_FEEDER_ONLINE
+    if pending_seq:
+        flags |= PEER_FEEDER_PENDING
+    entry = PEER_FEEDER_ENTRY.pack(feeder_id, flags, 0, socket.inet_aton(hand_ip), 0, 0, 0,
+                                   pending_seq, 0, 5000 if pending_seq else 0, CMD_FEEDER_ADVANCE)
+    return PEER_SYNC_HEADER.pack(UDP_PKT_PEER_SYNC, BRAIN_ROLE_ACTIVE, 255, 1, next_seq) + entry
+
+
+def fetch_peer_status(ip):
+    try:
+        with urllib.request.urlopen(f"http://{ip}/api/peer", timeout=2) as response:
+            return json.loads(response.read())
+    except (OSError, ValueError) as e:
+        return {"error": str(e)}
+
+
+def cmd_failover(args):
+    my_ip = local_ip_towards(args.standby)
+    peer_sock = open_udp(UDP_PEER_PORT, broadcast=True)
+    hand_sock = open_udp(UDP_DISCOVERY_PORT)
+    hand_sock.settimeout(0.01)
+
+    # 以最高优先级作为主机广播，备机应保持（或退为）备机
+    sync = build_sync(args.sequence, args.feeder, my_ip, args.sequence - 1 if args.pending else 0)
+    print(f"模拟主机 {my_ip}，同步Feeder {args.feeder} -> {my_ip}，持续 {args.sync_time}s")
+    end = time.monotonic() + args.sync_time
+    while time.monotonic() < end:
+        peer_sock.sendto(sync, ("<broadcast>", UDP_PEER_PORT))
+        time.sleep(args.interval / 1000.0)
+        while True:
+            try:
+                data, (ip, _) = hand_sock.recvfrom(256)
+            except socket.timeout:
+                break
+            if ip == args.standby and data and data[0] == UDP_PKT_DISCOVERY_RESPONSE:
+                print("错误: 主机在线时备机发出了发现响应")
+                return 1
+
+    before = fetch_peer_status(args.standby)
+    print("停止前备机状态:", json.dumps(before, ensure_ascii=False))
+    if before.get("role") != "standby":
+        print("错误: 备机没有处于standby角色")
+        return 1
+
+    # 停止广播，等待备机向模拟Hand发出发现响应
+    stop = time.monotonic()
+    hand_sock.settimeout(0.05)
+    while time.monotonic() - stop < args.wait:
+        try:
+            data, (ip, _) = hand_sock.recvfrom(256)
+        except socket.timeout:
+            continue
+        if ip == args.standby and data and data[0] == UDP_PKT_DISCOVERY_RESPONSE:
+            print(f"备机在停止同步后 {(time.monotonic() - stop) * 1000:.0f}ms 接管")
+            print("接管后状态:", json.dumps(fetch_peer_status(args.standby), ensure_ascii=False))
+            return 0
+
+    print(f"错误: {args.wait}s内没有收到发现响应")
+    return 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("watch")
+    p.add_argument("--entries", action="store_true", help="同时打印每个条目")
+    p.set_defaults(func=cmd_watch)
+
+    p = sub.add_parser("failover")
+    p.add_argument("--standby", required=True, help="备机Brain的IP")
+    p.add_argument("--feeder", type=int, default=0, help="模拟Hand的Feeder ID")
+    p.add_argument("--pending", action="store_true", help="同步一条在途送料命令，接管后由备机继续等待")
+    p.add_argument("--sequence", type=int, default=100000, help="模拟主机的下一个序列号")
+    p.add_argument("--sync-time", type=float, default=3.0, help="作为主机广播的时间(秒)")
+    p.add_argument("--interval", type=int, default=100, help="同步包间隔(ms)，应与BRAIN_PEER_SYNC_INTERVAL_MS一致")
+    p.add_argument("--wait", type=float, default=5.0, help="停止后等待接管的时间(秒)")
+    p.set_defaults(func=cmd_failover)
+
+    args = parser.parse_args()
+    try:
+        return args.func(args) or 0
+    except KeyboardInterrupt:
+        return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,383 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Hand固件组播升级工具
+
+  push  FILE --brain IP        上传Hand镜像到Brain并开始组播升级，打印进度直到结束
+  hands --count N              在本机模拟N个Hand：加入升级组播组，按固件相同的规则按块接收、
+                               回复缺失位图、MD5校验；--loss模拟丢包
+  send  FILE                   在本机按Brain固件相同的规则组播镜像（用于不接Brain时测试协议）
+
+本机回环测试（两个终端）：
+  fleet_ota.py hands --count 50 --loss 0.05 --iface 127.0.0.1
+  fleet_ota.py send firmware.bin --iface 127.0.0.1
+模拟Hand使用127.0.0.10起的回环地址回复，每个Hand的IP不同，与真实网络一致
+
+包结构见 src/common/udp_protocol.h（packed小端序）
+"""
+
+import argparse
+import hashlib
+import json
+import random
+import select
+import socket
+import struct
+import sys
+import time
+import urllib.request
+import uuid
+
+UDP_OTA_PORT = 8271
+UDP_OTA_MULTICAST_IP = "239.80.78.80"
+
+UDP_PKT_OTA_BEGIN = 0x17
+UDP_PKT_OTA_CHUNK = 0x18
+UDP_PKT_OTA_CONTROL = 0x19
+UDP_PKT_OTA_STATUS = 0x1A
+
+OTA_BEGIN = struct.Struct("<BBHIH16s")              # UDPOtaBegin
+OTA_CHUNK_HEADER = struct.Struct("<BBHHH")          # UDPOtaChunkHeader
+OTA_CONTROL = struct.Struct("<BBHH")                # UDPOtaControl
+OTA_STATUS = struct.Struct("<BBHBBHII")             # UDPOtaStatus
+
+OTA_CHUNK_SIZE = 512
+OTA_BLOCK_CHUNKS = 8
+
+OTA_STATE_IDLE, OTA_STATE_RECEIVING, OTA_STATE_VERIFIED, OTA_STATE_FAILED = range(4)
+STATE_NAMES = ["idle", "receiving", "verified", "failed"]
+OTA_ERROR_NONE, OTA_ERROR_PARAMS, OTA_ERROR_SPACE, OTA_ERROR_WRITE, OTA_ERROR_MISSED_BLOCK, \
+    OTA_ERROR_VERIFY, OTA_ERROR_TIMEOUT = range(7)
+OTA_ACTION_QUERY, OTA_ACTION_END, OTA_ACTION_REBOOT, OTA_ACTION_ABORT = range(1, 5)
+
+
+def chunk_count(size):
+    return (size + OTA_CHUNK_SIZE - 1) // OTA_CHUNK_SIZE
+
+
+def block_count(size):
+    return (chunk_count(size) + OTA_BLOCK_CHUNKS - 1) // OTA_BLOCK_CHUNKS
+
+
+def chunk_length(size, index):
+    offset = index * OTA_CHUNK_SIZE
+    return max(0, min(OTA_CHUNK_SIZE, size - offset))
+
+
+def block_mask(size, block):
+    first = block * OTA_BLOCK_CHUNKS
+    count = min(OTA_BLOCK_CHUNKS, max(0, chunk_count(size) - first))
+    return (1 << count) - 1
+
+
+def multicast_socket(iface):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 1)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_LOOP, 1)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_IF, socket.inet_aton(iface))
+    return sock
+
+
+# =============================================================================
+# 模拟Hand（与src/hand/hand_ota.cpp相同的状态机）
+# =============================================================================
+
+class SimHand:
+    def __init__(self, feeder_id, ip, loss):
+        self.feeder_id = feeder_id
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind((ip, 0))
+        self.loss = loss
+        self.state = OTA_STATE_IDLE
+        self.error = OTA_ERROR_NONE
+        self.session = 0
+        self.rebooted = False
+
+    def fail(self, error):
+        self.state = OTA_STATE_FAILED
+        self.error = error
+
+    def send_status(self, brain, block):
+        missing = 0
+        if self.state == OTA_STATE_RECEIVING and block >= self.block:
+            missing = block_mask(self.size, block)
+            if block == self.block:
+                missing &= ~self.received
+        written = len(self.image) if self.state != OTA_STATE_IDLE else 0
+        self.sock.sendto(OTA_STATUS.pack(UDP_PKT_OTA_STATUS, self.state, self.session, self.feeder_id,
+                                         self.error, block, missing, written), (brain, UDP_OTA_PORT))
+
+    def handle(self, data, brain):
+        if random.random() < self.loss:
+            return
+        kind = data[0]
+        if kind == UDP_PKT_OTA_BEGIN and len(data) >= OTA_BEGIN.size:
+            _, block_chunks, session, size, chunk_size, md5 = OTA_BEGIN.unpack_from(data)
+            if self.state == OTA_STATE_IDLE or session != self.session:
+                self.session, self.size, self.md5 = session, size, md5
+                self.blocks = block_count(size)
+                self.block, self.received, self.buffer, self.image = 0, 0, {}, bytearray()
+                self.state, self.error = OTA_STATE_RECEIVING, OTA_ERROR_NONE
+                self.rebooted = False
+                if chunk_size != OTA_CHUNK_SIZE or block_chunks != OTA_BLOCK_CHUNKS or size == 0:
+                    self.fail(OTA_ERROR_PARAMS)
+            self.send_status(brain, self.block if self.state != OTA_STATE_IDLE else 0)
+        elif kind == UDP_PKT_OTA_CHUNK and len(data) >= OTA_CHUNK_HEADER.size:
+            _, _, session, index, length = OTA_CHUNK_HEADER.unpack_from(data)
+            if self.state != OTA_STATE_RECEIVING or session != self.session:
+                return
+            if length != chunk_length(self.size, index) or len(data) < OTA_CHUNK_HEADER.size + length:
+                return
+            block, slot = divmod(index, OTA_BLOCK_CHUNKS)
+            if block < self.block or self.received & (1 << slot):
+                return
+            if block > self.block:
+                self.fail(OTA_ERROR_MISSED_BLOCK)
+                return
+            self.buffer[slot] = data[OTA_CHUNK_HEADER.size:OTA_CHUNK_HEADER.size + length]
+            self.received |= 1 << slot
+            if self.received == block_mask(self.size, self.block):
+                for i in range(OTA_BLOCK_CHUNKS):
+                    self.image += self.buffer.get(i, b"")
+                self.block, self.received, self.buffer = self.block + 1, 0, {}
+        elif kind == UDP_PKT_OTA_CONTROL and len(data) >= OTA_CONTROL.size:
+            _, action, session, block = OTA_CONTROL.unpack_from(data)
+            if self.state == OTA_STATE_IDLE or session != self.session:
+                return
+            if action == OTA_ACTION_QUERY:
+                self.send_status(brain, block)
+            elif action == OTA_ACTION_END:
+                if self.state == OTA_STATE_RECEIVING and self.block >= self.blocks:
+                    if hashlib.md5(self.image).digest() == self.md5:
+                        self.state = OTA_STATE_VERIFIED
+                    else:
+                        self.fail(OTA_ERROR_VERIFY)
+                self.send_status(brain, self.block)
+            elif action == OTA_ACTION_REBOOT:
+                if self.state == OTA_STATE_VERIFIED and not self.rebooted:
+                    self.rebooted = True
+                    print(f"Hand {self.feeder_id}: 校验通过，重启 ({len(self.image)} 字节)")
+                self.send_status(brain, self.block)
+            elif action == OTA_ACTION_ABORT:
+                self.state = OTA_STATE_IDLE
+
+
+def cmd_hands(args):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind((UDP_OTA_MULTICAST_IP, UDP_OTA_PORT))
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP,
+                    socket.inet_aton(UDP_OTA_MULTICAST_IP) + socket.inet_aton(args.iface))
+
+    base = args.iface.rsplit(".", 1)[0] if args.iface.startswith("127.") else None
+    hands = []
+    for i in range(args.count):
+        ip = f"{base}.{10 + i}" if base else args.iface
+        hands.append(SimHand(args.first_id + i, ip, args.loss))
+    print(f"{args.count}个模拟Hand已加入 {UDP_OTA_MULTICAST_IP}:{UDP_OTA_PORT}，丢包率 {args.loss:.0%}")
+
+    while True:
+        data, (brain, _) = sock.recvfrom(2048)
+        for hand in hands:
+            hand.handle(data, brain)
+
+
+# =============================================================================
+# 组播发送（与src/brain/brain_ota.cpp相同的流程）
+# =============================================================================
+
+def cmd_send(args):
+    image = open(args.file, "rb").read()
+    size = len(image)
+    md5 = hashlib.md5(image).digest()
+    session = random.randint(1, 0xFFFF)
+    blocks = block_count(size)
+    group = (UDP_OTA_MULTICAST_IP, UDP_OTA_PORT)
+
+    out = multicast_socket(args.iface)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind((args.iface, UDP_OTA_PORT))
+
+    hands = {}                      # (ip, feederId) -> 状态字典
+    stats = {"chunks": 0, "resent": 0, "queries": 0}
+
+    def receive(timeout):
+        ready, _, _ = select.select([sock], [], [], timeout)
+        while ready:
+            data, (ip, _) = sock.recvfrom(64)
+            if len(data) >= OTA_STATUS.size and data[0] == UDP_PKT_OTA_STATUS:
+                _, state, sess, fid, error, block, missing, written = OTA_STATUS.unpack_from(data)
+                if sess == session:
+                    yield (ip, fid), state, error, block, missing
+            ready, _, _ = select.select([sock], [], [], 0)
+
+    def active():
+        return [k for k, h in hands.items() if h["active"]]
+
+    def drop(key, error):
+        hands[key].update(active=False, state=OTA_STATE_FAILED, error=error)
+        print(f"放弃Hand {key[1]} ({key[0]})")
+
+    def update_hand(key, state, error):
+        hand = hands[key]
+        hand.update(state=state, error=error)
+        if state == OTA_STATE_FAILED:
+            hand["active"] = False
+
+    start = time.monotonic()
+    begin = OTA_BEGIN.pack(UDP_PKT_OTA_BEGIN, OTA_BLOCK_CHUNKS, session, size, OTA_CHUNK_SIZE, md5)
+    while time.monotonic() - start < args.begin_wait:
+        out.sendto(begin, group)
+        end = time.monotonic() + 0.3
+        while time.monotonic() < end:
+            for key, state, error, _, _ in receive(max(0, end - time.monotonic())):
+                if key not in hands:
+                    hands[key] = {"active": True, "state": state, "error": error}
+                update_hand(key, state, error)
+    if not active():
+        print("没有Hand应答")
+        return 1
+    print(f"{len(active())}个Hand参与，镜像 {size} 字节，{blocks} 块")
+    transfer_start = time.monotonic()
+
+    for block in range(blocks):
+        send_mask = block_mask(size, block)
+        confirmed = set()           # 已确认收齐本块的Hand，之后的轮次不再等待
+        rnd = 0
+        while active():
+            for slot in range(OTA_BLOCK_CHUNKS):
+                if send_mask & (1 << slot):
+                    index = block * OTA_BLOCK_CHUNKS + slot
+                    length = chunk_length(size, index)
+                    offset = index * OTA_CHUNK_SIZE
+                    out.sendto(OTA_CHUNK_HEADER.pack(UDP_PKT_OTA_CHUNK, 0, session, index, length)
+                               + image[offset:offset + length], group)
+                    stats["chunks"] += 1
+                    stats["resent"] += rnd > 0
+            out.sendto(OTA_CONTROL.pack(UDP_PKT_OTA_CONTROL, OTA_ACTION_QUERY, session, block), group)
+            stats["queries"] += 1
+
+            replies = {}
+            deadline = time.monotonic() + args.query_timeout
+            while (any(k not in confirmed and k not in replies for k in active())
+                   and time.monotonic() < deadline):
+                for key, state, error, blk, missing in receive(max(0, deadline - time.monotonic())):
+                    if key in hands and hands[key]["active"]:
+                        update_hand(key, state, error)
+                        if hands[key]["active"] and blk == block:
+                            replies[key] = missing
+                            if missing == 0:
+                                confirmed.add(key)
+            # 按每个Hand连续失败的轮数放弃
+            send_mask = 0
+            done = True
+            for key in active():
+                if key in confirmed:
+                    hands[key]["failed"] = 0
+                    continue
+                hands[key]["failed"] = hands[key].get("failed", 0) + 1
+                if hands[key]["failed"] > args.max_rounds:
+                    drop(key, OTA_ERROR_TIMEOUT)
+                    continue
+                send_mask |= replies.get(key, 0)
+                done = False
+            if done:
+                break
+            rnd += 1
+        if not active():
+            print("所有Hand均失败")
+            return 1
+        if block % 50 == 0 or block == blocks - 1:
+            print(f"块 {block + 1}/{blocks}  {time.monotonic() - transfer_start:.1f}s")
+
+    deadline = time.monotonic() + args.verify_timeout
+    while time.monotonic() < deadline and any(hands[k]["state"] != OTA_STATE_VERIFIED for k in active()):
+        out.sendto(OTA_CONTROL.pack(UDP_PKT_OTA_CONTROL, OTA_ACTION_END, session, blocks), group)
+        for key, state, error, _, _ in receive(0.3):
+            if key in hands and hands[key]["active"]:
+                update_hand(key, state, error)
+    for key in active():
+        if hands[key]["state"] != OTA_STATE_VERIFIED:
+            drop(key, OTA_ERROR_TIMEOUT)
+    for _ in range(3):
+        out.sendto(OTA_CONTROL.pack(UDP_PKT_OTA_CONTROL, OTA_ACTION_REBOOT, session, blocks), group)
+        time.sleep(0.1)
+
+    elapsed = time.monotonic() - start
+    verified = sum(1 for h in hands.values() if h["state"] == OTA_STATE_VERIFIED)
+    print(f"完成：{verified}/{len(hands)}个Hand校验通过，总耗时 {elapsed:.1f}s"
+          f"（传输 {time.monotonic() - transfer_start:.1f}s），分片 {stats['chunks']}（补发 {stats['resent']}），"
+          f"查询 {stats['queries']}")
+    for (ip, fid), hand in sorted(hands.items(), key=lambda item: item[0][1]):
+        if hand["state"] != OTA_STATE_VERIFIED:
+            print(f"  Hand {fid} ({ip}): {STATE_NAMES[hand['state']]} error={hand['error']}")
+    return 0 if verified == len(hands) else 1
+
+
+# =============================================================================
+# 通过Brain升级
+# =============================================================================
+
+def cmd_push(args):
+    image = open(args.file, "rb").read()
+    boundary = uuid.uuid4().hex
+    body = (f"--{boundary}\r\nContent-Disposition: form-data; name=\"image\"; filename=\"hand.bin\"\r\n"
+            f"Content-Type: application/octet-stream\r\n\r\n").encode() + image + f"\r\n--{boundary}--\r\n".encode()
+    request = urllib.request.Request(f"http://{args.brain}/api/ota/image", data=body, method="POST",
+                                     headers={"Content-Type": f"multipart/form-data; boundary={boundary}"})
+    with urllib.request.urlopen(request, timeout=60) as response:
+        print("上传:", response.read().decode())
+
+    request = urllib.request.Request(f"http://{args.brain}/api/ota", data=b"", method="POST")
+    with urllib.request.urlopen(request, timeout=5) as response:
+        print("开始:", response.read().decode())
+
+    last = None
+    while True:
+        time.sleep(0.5)
+        with urllib.request.urlopen(f"http://{args.brain}/api/ota", timeout=5) as response:
+            status = json.loads(response.read())
+        line = f"{status['phase']} 块 {status.get('block', 0) + 1}/{status.get('blocks', 0)}"
+        if line != last:
+            print(line, f"{status.get('elapsedMs', 0) / 1000:.1f}s")
+            last = line
+        if status["phase"] in ("done", "failed", "idle"):
+            print(json.dumps(status, ensure_ascii=False, indent=2))
+            return 0 if status["phase"] == "done" else 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("push")
+    p.add_argument("file")
+    p.add_argument("--brain", required=True, help="Brain IP")
+    p.set_defaults(func=cmd_push)
+
+    p = sub.add_parser("hands")
+    p.add_argument("--count", type=int, default=50)
+    p.add_argument("--first-id", type=int, default=0, help="第一个模拟Hand的Feeder ID")
+    p.add_argument("--loss", type=float, default=0.0, help="每个Hand独立的收包丢失率")
+    p.add_argument("--iface", default="127.0.0.1", help="加入组播的本机接口地址")
+    p.set_defaults(func=cmd_hands)
+
+    p = sub.add_parser("send")
+    p.add_argument("file")
+    p.add_argument("--iface", default="127.0.0.1", help="组播发送接口地址")
+    p.add_argument("--begin-wait", type=float, default=1.5, help="对应OTA_BEGIN_WAIT_MS(秒)")
+    p.add_argument("--query-timeout", type=float, default=0.15, help="对应OTA_QUERY_TIMEOUT_MS(秒)")
+    p.add_argument("--max-rounds", type=int, default=20, help="对应OTA_MAX_ROUNDS")
+    p.add_argument("--verify-timeout", type=float, default=5.0, help="对应OTA_VERIFY_TIMEOUT_MS(秒)")
+    p.set_defaults(func=cmd_send)
+
+    args = parser.parse_args()
+    try:
+        return args.func(args) or 0
+    except KeyboardInterrupt:
+        return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,328 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Brain通信录制文件(/api/record下载的traffic.pnpr)解析与回放工具
+
+  dump   FILE                 逐条打印录制内容
+  stats  FILE                 按录制时间统计M600到Hand响应的延迟
+  replay FILE --brain IP      按录制节奏把G-code行重新发给Brain，并在本机模拟Hand，
+                              Hand响应延迟取录制中对应Feeder的实测值；不需要贴片机和喂料器
+  rtt    --brain IP           反复发送不涉及Hand的M-code（默认M610），测量TCP往返时间
+
+文件格式见 src/common/traffic_record.h，包结构见 src/common/udp_protocol.h（均为packed小端序）
+"""
+
+import argparse
+import re
+import socket
+import statistics
+import struct
+import sys
+import threading
+import time
+
+TRAFFIC_FILE_MAGIC = 0x52504E50
+TRAFFIC_FILE_VERSION = 1
+FILE_HEADER = struct.Struct("<IB3xII")
+RECORD_HEADER = struct.Struct("<IB4sxH")
+
+TRAFFIC_TCP_LINE = 0
+TRAFFIC_UDP_MAIN = 1
+TRAFFIC_UDP_DISCOVERY = 2
+SOURCE_NAMES = {TRAFFIC_TCP_LINE: "tcp", TRAFFIC_UDP_MAIN: "udp", TRAFFIC_UDP_DISCOVERY: "disc"}
+
+# UDP包类型与结构
+UDP_PKT_DISCOVERY_REQUEST = 0x10
+UDP_PKT_COMMAND = 0x12
+UDP_PKT_RESPONSE = 0x13
+UDP_PKT_HEARTBEAT = 0x14
+PACKET_NAMES = {0x10: "discovery_req", 0x11: "discovery_resp", 0x12: "command",
+                0x13: "response", 0x14: "heartbeat", 0x15: "ping", 0x1B: "ack"}
+
+COMMAND_PACKET = struct.Struct("<BIIBBBB3s")             # UDPCommandPacket
+RESPONSE_PACKET = struct.Struct("<BIIBBBB2sII16sIII")    # UDPResponsePacket
+HEARTBEAT_PACKET = struct.Struct("<BBHBB")               # UDPHeartbeatPacket
+HEARTBEAT_HEALTH_OFFSET = HEARTBEAT_PACKET.size + 19     # UDPLoopStats之后
+HAND_HEALTH = struct.Struct("<bBIIIIHBBH")               # UDPHandHealth
+DISCOVERY_REQUEST = struct.Struct("<BBH12sB")            # UDPDiscoveryRequest
+
+CMD_FEEDER_ADVANCE = 0x04
+CMD_RESPONSE = 0x07
+STATUS_OK = 0x00
+
+UDP_BRAIN_PORT = 8266
+UDP_HAND_PORT = 8267
+UDP_DISCOVERY_PORT = 8268
+TCP_PORT = 8080
+
+M600_RE = re.compile(r"^M600\b.*?\bN(\d+)", re.IGNORECASE)
+
+
+def load_recording(path):
+    """返回(header字典, 记录列表)，记录为(timeUs, source, ip, payload)"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < FILE_HEADER.size:
+        raise ValueError("文件太短")
+    magic, version, count, dropped = FILE_HEADER.unpack_from(data, 0)
+    if magic != TRAFFIC_FILE_MAGIC or version != TRAFFIC_FILE_VERSION:
+        raise ValueError("不是录制文件或版本不支持")
+
+    records = []
+    pos = FILE_HEADER.size
+    while pos + RECORD_HEADER.size <= len(data):
+        time_us, source, ip, length = RECORD_HEADER.unpack_from(data, pos)
+        pos += RECORD_HEADER.size
+        if pos + length > len(data):
+            break
+        records.append((time_us, source, socket.inet_ntoa(ip), data[pos:pos + length]))
+        pos += length
+
+    # micros()约71分钟回绕一次，展开为单调时间
+    unwrapped = []
+    offset = 0
+    last = None
+    for time_us, source, ip, payload in records:
+        if last is not None and time_us < last:
+            offset += 1 << 32
+        last = time_us
+        unwrapped.append((time_us + offset, source, ip, payload))
+
+    return {"records": count, "dropped": dropped}, unwrapped
+
+
+def describe_packet(payload):
+    if not payload:
+        return "empty"
+    kind = payload[0]
+    name = PACKET_NAMES.get(kind, "0x%02X" % kind)
+    if kind == UDP_PKT_RESPONSE and len(payload) >= RESPONSE_PACKET.size:
+        f = RESPONSE_PACKET.unpack_from(payload)
+        message = f[10].split(b"\0", 1)[0].decode("utf-8", "replace")
+        return "%s seq=%u feeder=%u status=%u reason=%u msg=%r servo=%uus" % (
+            name, f[1], f[3], f[5], f[6], message, f[12] - f[13])
+    if kind == UDP_PKT_HEARTBEAT and len(payload) >= HEARTBEAT_PACKET.size - 1:
+        fields = HEARTBEAT_PACKET.unpack_from(payload + b"\0")
+        count = fields[4] or 1
+        text = "%s feeder=%u count=%u status=0x%02x" % (name, fields[1], count, fields[3])
+        if len(payload) >= HEARTBEAT_HEALTH_OFFSET + HAND_HEALTH.size:
+            h = HAND_HEALTH.unpack_from(payload, HEARTBEAT_HEALTH_OFFSET)
+            text += " rssi=%d heap=%u frag=%u%% cycles=%u resets=%u errors=%u" % (
+                h[0], h[2], h[1], h[4], h[6], h[9])
+        return text
+    if kind == UDP_PKT_DISCOVERY_REQUEST and len(payload) >= DISCOVERY_REQUEST.size - 1:
+        fields = DISCOVERY_REQUEST.unpack_from(payload + b"\0")
+        return "%s hand=%u count=%u" % (name, fields[1], fields[4] or 1)
+    return "%s len=%d" % (name, len(payload))
+
+
+def cmd_dump(args):
+    header, records = load_recording(args.file)
+    print("records=%d dropped=%d" % (header["records"], header["dropped"]))
+    if not records:
+        return
+    start = records[0][0]
+    last = start
+    for time_us, source, ip, payload in records:
+        if source == TRAFFIC_TCP_LINE:
+            text = payload.decode("utf-8", "replace")
+        else:
+            text = "%s from %s" % (describe_packet(payload), ip)
+        print("%10.3fms +%8.3fms %-4s %s" % ((time_us - start) / 1000.0, (time_us - last) / 1000.0,
+                                            SOURCE_NAMES.get(source, "?"), text))
+        last = time_us
+
+
+def feed_latencies(records):
+    """把M600行与其后同一Feeder的第一个响应配对，返回{feederId: [延迟us...]}"""
+    waiting = {}
+    latencies = {}
+    for time_us, source, ip, payload in records:
+        if source == TRAFFIC_TCP_LINE:
+            match = M600_RE.match(payload.decode("utf-8", "replace"))
+            if match:
+                waiting.setdefault(int(match.group(1)), []).append(time_us)
+        elif source == TRAFFIC_UDP_MAIN and payload[:1] == bytes([UDP_PKT_RESPONSE]) \
+                and len(payload) >= RESPONSE_PACKET.size:
+            feeder = RESPONSE_PACKET.unpack_from(payload)[3]
+            if waiting.get(feeder):
+                sent = waiting[feeder].pop(0)
+                latencies.setdefault(feeder, []).append(time_us - sent)
+    return latencies
+
+
+def summarize(label, values_us):
+    values = sorted(values_us)
+    p95 = values[min(len(values) - 1, int(len(values) * 0.95))]
+    print("%-10s n=%-4d p50=%8.2fms p95=%8.2fms max=%8.2fms" % (
+        label, len(values), statistics.median(values) / 1000.0, p95 / 1000.0, values[-1] / 1000.0))
+
+
+def cmd_stats(args):
+    header, records = load_recording(args.file)
+    print("records=%d dropped=%d" % (header["records"], header["dropped"]))
+    latencies = feed_latencies(records)
+    if not latencies:
+        print("没有可配对的M600与响应")
+        return
+    everything = []
+    for feeder in sorted(latencies):
+        summarize("feeder %d" % feeder, latencies[feeder])
+        everything.extend(latencies[feeder])
+    summarize("all", everything)
+
+
+class HandEmulator:
+    """在本机模拟录制中出现的Hand：回放心跳让Brain登记本机IP，收到送料命令后按录制延迟回复"""
+
+    def __init__(self, brain_ip, records):
+        self.brain_ip = brain_ip
+        self.running = True
+        self.delays = {f: statistics.median(v) / 1e6 for f, v in feed_latencies(records).items()}
+        self.heartbeats = {}
+        for _, source, _, payload in records:
+            if source == TRAFFIC_UDP_MAIN and payload[:1] == bytes([UDP_PKT_HEARTBEAT]):
+                self.heartbeats[payload[1]] = payload
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind(("", UDP_HAND_PORT))
+        self.sock.settimeout(0.1)
+
+    def start(self):
+        threading.Thread(target=self._heartbeat_loop, daemon=True).start()
+        threading.Thread(target=self._command_loop, daemon=True).start()
+
+    def stop(self):
+        self.running = False
+
+    def _heartbeat_loop(self):
+        while self.running:
+            for payload in self.heartbeats.values():
+                self.sock.sendto(payload, (self.brain_ip, UDP_BRAIN_PORT))
+            time.sleep(2.0)
+
+    def _command_loop(self):
+        while self.running:
+            try:
+                data, _ = self.sock.recvfrom(256)
+            except socket.timeout:
+                continue
+            if len(data) < COMMAND_PACKET.size or data[0] != UDP_PKT_COMMAND:
+                continue
+            _, sequence, _, command, feeder, _, _, _ = COMMAND_PACKET.unpack_from(data)
+            delay = self.delays.get(feeder, 0.0) if command == CMD_FEEDER_ADVANCE else 0.0
+            threading.Timer(delay, self._respond, (sequence, feeder, delay)).start()
+
+    def _respond(self, sequence, feeder, delay):
+        now = int(time.monotonic() * 1000) & 0xFFFFFFFF
+        servo_us = int(delay * 1e6)
+        packet = RESPONSE_PACKET.pack(UDP_PKT_RESPONSE, sequence, now, feeder, CMD_RESPONSE, STATUS_OK, 0,
+                                      b"\0\0", sequence, now, b"Feed OK", servo_us, servo_us, 0)
+        self.sock.sendto(packet, (self.brain_ip, UDP_BRAIN_PORT))
+
+
+def cmd_replay(args):
+    _, records = load_recording(args.file)
+    lines = [(t, p.decode("utf-8", "replace")) for t, s, _, p in records if s == TRAFFIC_TCP_LINE]
+    if not lines:
+        print("录制中没有G-code行")
+        return 1
+
+    emulator = None
+    if not args.no_emulate:
+        emulator = HandEmulator(args.brain, records)
+        emulator.start()
+        time.sleep(args.warmup)
+
+    conn = socket.create_connection((args.brain, args.port), timeout=args.timeout)
+    reader = conn.makefile("r", encoding="utf-8", errors="replace")
+    reader.readline()  # 欢迎消息
+
+    # OpenPnP等到回复后才发下一行，回放同样逐行等待；录制间隔更长时按录制节奏补足
+    latencies = []
+    errors = 0
+    replay_start = time.monotonic()
+    record_start = lines[0][0]
+    for record_us, line in lines:
+        due = replay_start + (record_us - record_start) / 1e6 / args.speed
+        wait = due - time.monotonic()
+        if wait > 0:
+            time.sleep(wait)
+        sent = time.monotonic()
+        conn.sendall((line + "\n").encode("utf-8"))
+        try:
+            reply = reader.readline().strip()
+        except socket.timeout:
+            reply = "<timeout>"
+        elapsed_us = (time.monotonic() - sent) * 1e6
+        latencies.append(elapsed_us)
+        if not reply.startswith("ok"):
+            errors += 1
+        if args.verbose:
+            print("%8.2fms %-24s -> %s" % (elapsed_us / 1000.0, line, reply))
+
+    conn.close()
+    if emulator:
+        emulator.stop()
+
+    summarize("replay", latencies)
+    print("errors=%d" % errors)
+    return 1 if errors else 0
+
+
+def cmd_rtt(args):
+    conn = socket.create_connection((args.brain, args.port), timeout=args.timeout)
+    conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    reader = conn.makefile("r", encoding="utf-8", errors="replace")
+    reader.readline()  # 欢迎消息
+
+    latencies = []
+    for _ in range(args.count):
+        sent = time.monotonic()
+        conn.sendall((args.line + "\n").encode("utf-8"))
+        reader.readline()
+        latencies.append((time.monotonic() - sent) * 1e6)
+        time.sleep(args.interval)
+
+    conn.close()
+    summarize("rtt", latencies)
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("dump")
+    p.add_argument("file")
+    p.set_defaults(func=cmd_dump)
+
+    p = sub.add_parser("stats")
+    p.add_argument("file")
+    p.set_defaults(func=cmd_stats)
+
+    p = sub.add_parser("replay")
+    p.add_argument("file")
+    p.add_argument("--brain", required=True, help="Brain IP地址")
+    p.add_argument("--port", type=int, default=TCP_PORT)
+    p.add_argument("--speed", type=float, default=1.0, help="回放速度倍数")
+    p.add_argument("--timeout", type=float, default=5.0, help="等待回复的超时(秒)")
+    p.add_argument("--warmup", type=float, default=3.0, help="模拟Hand上线后等待的时间(秒)")
+    p.add_argument("--no-emulate", action="store_true", help="不模拟Hand（真实Hand在线时使用）")
+    p.add_argument("-v", "--verbose", action="store_true")
+    p.set_defaults(func=cmd_replay)
+
+    p = sub.add_parser("rtt")
+    p.add_argument("--brain", required=True, help="Brain IP地址")
+    p.add_argument("--port", type=int, default=TCP_PORT)
+    p.add_argument("--line", default="M610", help="发送的G-code行")
+    p.add_argument("--count", type=int, default=200)
+    p.add_argument("--interval", type=float, default=0.02, help="两次发送间隔(秒)")
+    p.add_argument("--timeout", type=float, default=5.0)
+    p.set_defaults(func=cmd_rtt)
+
+    args = parser.parse_args()
+    return args.func(args) or 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())